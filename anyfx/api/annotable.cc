@@ -32,6 +32,16 @@ Annotable::~Annotable()
 	}
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Annotable::SwapAnnotations(Annotable& other)
+{
+	this->annotationTypes.swap(other.annotationTypes);
+	this->annotationMap.swap(other.annotationMap);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -105,4 +115,21 @@ Annotable::GetAnnotationString(const std::string& name) const
 	assert(it != this->annotationMap.end());
 	return *it->second.data.stringValue;
 }
+
+//------------------------------------------------------------------------------
+/**
+	Map nodes are counted as the stored pair plus the three links and color of a tree node.
+*/
+size_t
+Annotable::GetAnnotationBytes() const
+{
+	size_t bytes = this->annotationTypes.capacity() * sizeof(VariableType);
+	std::map<std::string, AnnotationVariant>::const_iterator it;
+	for (it = this->annotationMap.begin(); it != this->annotationMap.end(); it++)
+	{
+		bytes += sizeof(*it) + 4 * sizeof(void*) + it->first.capacity();
+		if (it->second.type == String) bytes += sizeof(std::string) + it->second.data.stringValue->capacity();
+	}
+	return bytes;
+}
 } // namespace AnyFX
\ No newline at end of file
@@ -38,6 +38,13 @@ public:
 	/// get string value
     const std::string& GetAnnotationString(const std::string& name) const;
 
+	/// get bytes held by annotations, including an estimate of the map overhead
+	size_t GetAnnotationBytes() const;
+
+protected:
+	/// swap annotations with another object, used when an effect is reloaded in place
+	void SwapAnnotations(Annotable& other);
+
 private:
 	friend class EffectAnnotationStreamLoader;
 	friend class AnnotationLoader;
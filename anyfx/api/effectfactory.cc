@@ -5,6 +5,8 @@
 #include "effectfactory.h"
 #include <assert.h>
 #include "binreader.h"
+#include "lowlevel/shadereffect.h"
+#include "effectpack.h"
 #include <fstream>
 
 namespace AnyFX
@@ -14,7 +16,10 @@ EffectFactory* EffectFactory::instance = 0;
 //------------------------------------------------------------------------------
 /**
 */
-EffectFactory::EffectFactory()
+EffectFactory::EffectFactory() :
+	numWorkers(0),
+	numActiveJobs(0),
+	stopWorkers(false)
 {
 	assert(instance == 0);
 	instance = this;
@@ -25,6 +30,7 @@ EffectFactory::EffectFactory()
 */
 EffectFactory::~EffectFactory()
 {
+	this->StopWorkers();
 	assert(instance != 0);
 	instance = 0;
 }
@@ -43,16 +49,24 @@ EffectFactory::Instance()
 /**
 */
 ShaderEffect*
-EffectFactory::CreateShaderEffectFromFile(const std::string& file)
+EffectFactory::CreateShaderEffectFromFile(const std::string& file, bool deferPrograms)
 {
 	StreamLoader loader;
-	BinReader reader;
-	reader.SetPath(file.c_str());
-	reader.Open();
-	loader.SetReader(&reader);
+	BinReader* reader = new BinReader;
+	reader->SetPath(file.c_str());
+	reader->Open();
+	loader.SetReader(reader);
+	loader.SetDeferPrograms(deferPrograms);
 	ShaderEffect* retval = loader.Load();
 	loader.SetReader(0);
-	reader.Close();
+
+	// if the effect loads programs on demand it owns the reader
+	if (retval == NULL || retval->deferredReader != reader)
+	{
+		reader->Close();
+		delete reader;
+	}
+	if (retval != NULL) this->AddStatistics(retval);
 	return retval;
 }
 
@@ -60,17 +74,301 @@ EffectFactory::CreateShaderEffectFromFile(const std::string& file)
 /**
 */
 ShaderEffect*
-EffectFactory::CreateShaderEffectFromMemory(void* data, size_t size)
+EffectFactory::CreateShaderEffectFromMemory(void* data, size_t size, bool deferPrograms)
 {
 	StreamLoader loader;
 	BinReader* reader = new BinReader;
 	reader->Open((const char*)data, size);
 	loader.SetReader(reader);
+	loader.SetDeferPrograms(deferPrograms);
 	ShaderEffect* retval = loader.Load();
 	loader.SetReader(0);
-	reader->Close();
-	delete reader;
+
+	// if the effect loads programs on demand, it needs its own copy of the data since the caller's buffer might go away
+	if (retval != NULL && retval->deferredReader == reader)
+	{
+		unsigned pos = reader->Tell();
+		retval->deferredData.assign((const char*)data, (const char*)data + size);
+		reader->Open(retval->deferredData.data(), size);
+		reader->Seek(pos);
+	}
+	else
+	{
+		reader->Close();
+		delete reader;
+	}
+	if (retval != NULL) this->AddStatistics(retval);
 	return retval;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+EffectPack*
+EffectFactory::MountEffectPack(const std::string& file)
+{
+	EffectPack* pack = new EffectPack;
+	if (!pack->Mount(file))
+	{
+		printf("Failed to mount effect pack '%s'\n", file.c_str());
+		delete pack;
+		return NULL;
+	}
+	return pack;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::UnmountEffectPack(EffectPack* pack)
+{
+	assert(pack != NULL);
+	pack->Unmount();
+	delete pack;
+}
+
+//------------------------------------------------------------------------------
+/**
+	The effect reads straight from the mapped pack, even when programs are deferred, so no copy is made.
+*/
+ShaderEffect*
+EffectFactory::CreateShaderEffectFromPack(const EffectPack* pack, const std::string& name, bool deferPrograms)
+{
+	const void* data;
+	size_t size;
+	if (!pack->FindEffect(name, data, size))
+	{
+		printf("Effect '%s' not found in effect pack\n", name.c_str());
+		return NULL;
+	}
+
+	StreamLoader loader;
+	BinReader* reader = new BinReader;
+	reader->Open((const char*)data, size);
+	loader.SetReader(reader);
+	loader.SetDeferPrograms(deferPrograms);
+	ShaderEffect* retval = loader.Load();
+	loader.SetReader(0);
+
+	// if the effect loads programs on demand it owns the reader
+	if (retval == NULL || retval->deferredReader != reader)
+	{
+		reader->Close();
+		delete reader;
+	}
+	if (retval != NULL) this->AddStatistics(retval);
+	return retval;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::SetNumWorkers(unsigned num)
+{
+	std::unique_lock<std::mutex> lock(this->jobLock);
+	bool running = !this->workers.empty();
+	lock.unlock();
+
+	// restart the pool with the new size, pending jobs are finished first
+	if (running) this->StopWorkers();
+	this->numWorkers = num;
+	if (running) this->StartWorkers();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::vector<std::future<ShaderEffect*>>
+EffectFactory::CreateShaderEffectsFromFiles(const std::vector<std::string>& files, bool deferPrograms)
+{
+	std::vector<std::future<ShaderEffect*>> retval;
+	retval.reserve(files.size());
+	unsigned i;
+	for (i = 0; i < files.size(); i++)
+	{
+		// std::function requires copyable targets, so share the task
+		std::string file = files[i];
+		auto task = std::make_shared<std::packaged_task<ShaderEffect*()>>([this, file, deferPrograms]() { return this->CreateShaderEffectFromFile(file, deferPrograms); });
+		retval.push_back(task->get_future());
+		this->Enqueue([task]() { (*task)(); });
+	}
+	return retval;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::CreateShaderEffectsFromFiles(const std::vector<std::string>& files, const std::function<void(const std::string&, ShaderEffect*)>& callback, bool deferPrograms)
+{
+	unsigned i;
+	for (i = 0; i < files.size(); i++)
+	{
+		std::string file = files[i];
+		this->Enqueue([this, file, callback, deferPrograms]() { callback(file, this->CreateShaderEffectFromFile(file, deferPrograms)); });
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::vector<std::future<ShaderEffect*>>
+EffectFactory::CreateShaderEffectsFromMemory(const std::vector<std::pair<void*, size_t>>& buffers, bool deferPrograms)
+{
+	std::vector<std::future<ShaderEffect*>> retval;
+	retval.reserve(buffers.size());
+	unsigned i;
+	for (i = 0; i < buffers.size(); i++)
+	{
+		std::pair<void*, size_t> buffer = buffers[i];
+		auto task = std::make_shared<std::packaged_task<ShaderEffect*()>>([this, buffer, deferPrograms]() { return this->CreateShaderEffectFromMemory(buffer.first, buffer.second, deferPrograms); });
+		retval.push_back(task->get_future());
+		this->Enqueue([task]() { (*task)(); });
+	}
+	return retval;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::CreateShaderEffectsFromMemory(const std::vector<std::pair<void*, size_t>>& buffers, const std::function<void(unsigned, ShaderEffect*)>& callback, bool deferPrograms)
+{
+	unsigned i;
+	for (i = 0; i < buffers.size(); i++)
+	{
+		std::pair<void*, size_t> buffer = buffers[i];
+		this->Enqueue([this, i, buffer, callback, deferPrograms]() { callback(i, this->CreateShaderEffectFromMemory(buffer.first, buffer.second, deferPrograms)); });
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::Wait()
+{
+	std::unique_lock<std::mutex> lock(this->jobLock);
+	this->idleSignal.wait(lock, [this]() { return this->jobs.empty() && this->numActiveJobs == 0; });
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ShaderEffect::Statistics
+EffectFactory::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(this->statisticsLock);
+	return this->statistics;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::ResetStatistics()
+{
+	std::lock_guard<std::mutex> lock(this->statisticsLock);
+	this->statistics = ShaderEffect::Statistics();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Effects are counted once when created, batches add theirs from the worker threads.
+*/
+void
+EffectFactory::AddStatistics(const ShaderEffect* effect)
+{
+	ShaderEffect::Statistics stats = effect->GetStatistics();
+	std::lock_guard<std::mutex> lock(this->statisticsLock);
+	this->statistics += stats;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::Enqueue(const std::function<void()>& job)
+{
+	std::unique_lock<std::mutex> lock(this->jobLock);
+	bool start = this->workers.empty();
+	lock.unlock();
+	if (start) this->StartWorkers();
+
+	lock.lock();
+	this->jobs.push_back(job);
+	lock.unlock();
+	this->jobSignal.notify_one();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::StartWorkers()
+{
+	std::unique_lock<std::mutex> lock(this->jobLock);
+
+	// another thread might have started the pool already
+	if (!this->workers.empty()) return;
+
+	unsigned num = this->numWorkers;
+	if (num == 0) num = std::thread::hardware_concurrency();
+	if (num == 0) num = 1;
+
+	this->stopWorkers = false;
+	unsigned i;
+	for (i = 0; i < num; i++)
+	{
+		this->workers.push_back(std::thread(&EffectFactory::WorkerLoop, this));
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectFactory::StopWorkers()
+{
+	std::vector<std::thread> threads;
+	std::unique_lock<std::mutex> lock(this->jobLock);
+	this->stopWorkers = true;
+	threads.swap(this->workers);
+	lock.unlock();
+	this->jobSignal.notify_all();
+
+	unsigned i;
+	for (i = 0; i < threads.size(); i++) threads[i].join();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Workers drain the queue before exiting so no future is left without a value.
+*/
+void
+EffectFactory::WorkerLoop()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(this->jobLock);
+		this->jobSignal.wait(lock, [this]() { return this->stopWorkers || !this->jobs.empty(); });
+		if (this->jobs.empty()) break;
+
+		std::function<void()> job = this->jobs.front();
+		this->jobs.pop_front();
+		this->numActiveJobs++;
+		lock.unlock();
+
+		job();
+
+		lock.lock();
+		this->numActiveJobs--;
+		bool idle = this->jobs.empty() && this->numActiveJobs == 0;
+		lock.unlock();
+		if (idle) this->idleSignal.notify_all();
+	}
+}
+
 } // namespace AnyFX
\ No newline at end of file
@@ -10,10 +10,19 @@
 //------------------------------------------------------------------------------
 #include <map>
 #include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #include "lowlevel/loaders/streamloader.h"
+#include "lowlevel/shadereffect.h"
 namespace AnyFX
 {
 class Effect;
+class EffectPack;
 class EffectFactory
 {
 public:
@@ -25,14 +34,74 @@ public:
 	/// returns instance to factory
 	static EffectFactory* Instance();
 
-	/// creates a low-level effect from file
-	ShaderEffect* CreateShaderEffectFromFile(const std::string& file);
-	/// creates a low-level effect from memory
-	ShaderEffect* CreateShaderEffectFromMemory(void* data, size_t size);
+	/// creates a low-level effect from file, if deferPrograms is set programs are loaded from the file when first requested
+	ShaderEffect* CreateShaderEffectFromFile(const std::string& file, bool deferPrograms = false);
+	/// creates a low-level effect from memory, if deferPrograms is set the effect keeps a copy of the data to load programs from when first requested
+	ShaderEffect* CreateShaderEffectFromMemory(void* data, size_t size, bool deferPrograms = false);
+
+	/// mounts an effect pack produced by anyfxpacker, returns NULL if the pack is invalid
+	EffectPack* MountEffectPack(const std::string& file);
+	/// unmounts and deletes effect pack, effects created from it with deferred programs must be deleted before this
+	void UnmountEffectPack(EffectPack* pack);
+	/// creates a low-level effect directly from the mapped pack data
+	ShaderEffect* CreateShaderEffectFromPack(const EffectPack* pack, const std::string& name, bool deferPrograms = false);
+
+	/// set the number of worker threads used for batch creation, 0 uses the hardware concurrency, must not be called while batches are being queued
+	void SetNumWorkers(unsigned num);
+	/// get the number of worker threads used for batch creation
+	unsigned GetNumWorkers() const;
+
+	/// creates low-level effects from a batch of files on the worker pool, futures are returned in the same order as the files
+	std::vector<std::future<ShaderEffect*>> CreateShaderEffectsFromFiles(const std::vector<std::string>& files, bool deferPrograms = false);
+	/// creates low-level effects from a batch of files on the worker pool, the callback is invoked from a worker thread for every effect as it is done
+	void CreateShaderEffectsFromFiles(const std::vector<std::string>& files, const std::function<void(const std::string&, ShaderEffect*)>& callback, bool deferPrograms = false);
+	/// creates low-level effects from a batch of buffers on the worker pool, the buffers must stay valid until their futures are ready
+	std::vector<std::future<ShaderEffect*>> CreateShaderEffectsFromMemory(const std::vector<std::pair<void*, size_t>>& buffers, bool deferPrograms = false);
+	/// creates low-level effects from a batch of buffers on the worker pool, the callback receives the index of the buffer in the batch
+	void CreateShaderEffectsFromMemory(const std::vector<std::pair<void*, size_t>>& buffers, const std::function<void(unsigned, ShaderEffect*)>& callback, bool deferPrograms = false);
+	/// blocks until all queued batch work is done
+	void Wait();
+
+	/// get statistics of every effect created so far added up, each as it was right after loading
+	ShaderEffect::Statistics GetStatistics() const;
+	/// start counting from zero
+	void ResetStatistics();
 
 private:
+
+	/// queue job on worker pool, starting the pool if needed
+	void Enqueue(const std::function<void()>& job);
+	/// start worker threads
+	void StartWorkers();
+	/// finish queued jobs and stop worker threads
+	void StopWorkers();
+	/// worker thread loop
+	void WorkerLoop();
+	/// add statistics of newly created effect
+	void AddStatistics(const ShaderEffect* effect);
 	
 	static EffectFactory* instance;
+
+	unsigned numWorkers;
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	unsigned numActiveJobs;
+	bool stopWorkers;
+	std::mutex jobLock;
+	std::condition_variable jobSignal;
+	std::condition_variable idleSignal;
+
+	ShaderEffect::Statistics statistics;
+	mutable std::mutex statisticsLock;
 }; 
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+EffectFactory::GetNumWorkers() const
+{
+	return this->numWorkers;
+}
 } // namespace AnyFX
 //------------------------------------------------------------------------------
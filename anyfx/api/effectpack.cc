@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+//  effectpack.cc
+//  (C) 2016 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "effectpack.h"
+#include "util.h"
+#include <assert.h>
+#include <string.h>
+#if __WIN32__
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace AnyFX
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+EffectPack::EffectPack() :
+	data(NULL),
+	size(0),
+	header(NULL),
+	entries(NULL),
+	strings(NULL),
+#if __WIN32__
+	fileHandle(NULL),
+	mappingHandle(NULL)
+#else
+	fileDescriptor(-1)
+#endif
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+EffectPack::~EffectPack()
+{
+	if (this->IsMounted()) this->Unmount();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+EffectPack::Mount(const std::string& path)
+{
+	assert(!this->IsMounted());
+#if __WIN32__
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	this->fileHandle = file;
+	this->mappingHandle = mapping;
+	this->data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	this->size = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) return false;
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+	this->fileDescriptor = fd;
+	this->data = (const char*)mapped;
+	this->size = (size_t)st.st_size;
+#endif
+
+	if (!this->Setup())
+	{
+		this->Unmount();
+		return false;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+EffectPack::Mount(const void* data, size_t size)
+{
+	assert(!this->IsMounted());
+	this->data = (const char*)data;
+	this->size = size;
+	if (!this->Setup())
+	{
+		this->Unmount();
+		return false;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectPack::Unmount()
+{
+#if __WIN32__
+	if (this->mappingHandle)
+	{
+		UnmapViewOfFile(this->data);
+		CloseHandle(this->mappingHandle);
+		CloseHandle(this->fileHandle);
+		this->mappingHandle = NULL;
+		this->fileHandle = NULL;
+	}
+#else
+	if (this->fileDescriptor != -1)
+	{
+		munmap((void*)this->data, this->size);
+		close(this->fileDescriptor);
+		this->fileDescriptor = -1;
+	}
+#endif
+	this->data = NULL;
+	this->size = 0;
+	this->header = NULL;
+	this->entries = NULL;
+	this->strings = NULL;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+EffectPack::GetName(const unsigned i) const
+{
+	assert(i < this->GetNumEntries());
+	const Entry& entry = this->entries[i];
+	return std::string(this->strings + entry.nameOffset - this->header->stringsOffset, entry.nameLength);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+EffectPack::FindEffect(const std::string& name, const void*& data, size_t& size) const
+{
+	int i = this->FindEntry(name);
+	if (i == -1) return false;
+	data = this->data + this->entries[i].dataOffset;
+	size = this->entries[i].dataSize;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+	The index is sorted on hash, so binary search for the first matching hash and compare names to resolve collisions.
+*/
+int
+EffectPack::FindEntry(const std::string& name) const
+{
+	if (!this->IsMounted()) return -1;
+	unsigned hash = HashString(name.c_str(), name.length());
+	unsigned lo = 0;
+	unsigned hi = this->header->numEntries;
+	while (lo < hi)
+	{
+		unsigned mid = (lo + hi) / 2;
+		if (this->entries[mid].hash < hash) lo = mid + 1;
+		else hi = mid;
+	}
+
+	for (; lo < this->header->numEntries && this->entries[lo].hash == hash; lo++)
+	{
+		const Entry& entry = this->entries[lo];
+		if (entry.nameLength == name.length() &&
+			memcmp(this->strings + entry.nameOffset - this->header->stringsOffset, name.c_str(), entry.nameLength) == 0)
+			return (int)lo;
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+EffectPack::Setup()
+{
+	if (this->size < sizeof(Header))
+	{
+		printf("Effect pack is too small, corrupt file suspected\n");
+		return false;
+	}
+
+	this->header = (const Header*)this->data;
+	if (this->header->magic != Magic || this->header->version > Version)
+	{
+		printf("Magic number %d or version %d is not valid for AnyFX effect pack, corrupt file suspected\n", this->header->magic, this->header->version);
+		return false;
+	}
+
+	size_t indexEnd = sizeof(Header) + (size_t)this->header->numEntries * sizeof(Entry);
+	if (indexEnd > this->size || (size_t)this->header->stringsOffset + this->header->stringsSize > this->size)
+	{
+		printf("Effect pack index is out of bounds, corrupt file suspected\n");
+		return false;
+	}
+
+	this->entries = (const Entry*)(this->data + sizeof(Header));
+	this->strings = this->data + this->header->stringsOffset;
+
+	unsigned i;
+	for (i = 0; i < this->header->numEntries; i++)
+	{
+		const Entry& entry = this->entries[i];
+		if ((size_t)entry.dataOffset + entry.dataSize > this->size ||
+			entry.nameOffset < this->header->stringsOffset ||
+			entry.nameOffset + entry.nameLength > this->header->stringsOffset + this->header->stringsSize)
+		{
+			printf("Effect pack entry %d is out of bounds, corrupt file suspected\n", i);
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace AnyFX
@@ -0,0 +1,120 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class AnyFX::EffectPack
+
+    A read-only archive of compiled effects, produced by anyfxpacker.
+
+	The pack starts with a header, followed by an index of entries sorted by
+	name hash, a string table of entry names and finally the effect payloads,
+	each starting on an aligned offset. Mounting a pack from file maps it into
+	memory, so effects are created directly from the mapped payloads.
+
+    (C) 2016 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <string>
+#include <stddef.h>
+namespace AnyFX
+{
+class EffectPack
+{
+public:
+	/// file header, all fields are 32 bit
+	struct Header
+	{
+		int magic;
+		unsigned version;
+		unsigned numEntries;
+		unsigned alignment;
+		unsigned stringsOffset;
+		unsigned stringsSize;
+	};
+
+	/// index entry, all offsets are absolute within the pack
+	struct Entry
+	{
+		unsigned hash;
+		unsigned nameOffset;
+		unsigned nameLength;
+		unsigned dataOffset;
+		unsigned dataSize;
+	};
+
+	static const int Magic = 'AFXP';
+	static const unsigned Version = 1;
+	static const unsigned DefaultAlignment = 64;
+
+	/// constructor
+	EffectPack();
+	/// destructor
+	virtual ~EffectPack();
+
+	/// map pack file into memory
+	bool Mount(const std::string& path);
+	/// use pack already in memory, the data must outlive the pack
+	bool Mount(const void* data, size_t size);
+	/// unmount pack, effects created with deferred programs from this pack must be deleted before this
+	void Unmount();
+	/// returns true if mounted
+	bool IsMounted() const;
+
+	/// get number of effects in pack
+	unsigned GetNumEntries() const;
+	/// get name of effect by index
+	std::string GetName(const unsigned i) const;
+	/// returns true if pack contains effect
+	bool HasEffect(const std::string& name) const;
+	/// find effect payload by name, returns false if not found
+	bool FindEffect(const std::string& name, const void*& data, size_t& size) const;
+
+private:
+
+	/// validate header and setup index pointers
+	bool Setup();
+	/// find index of entry, or -1 if not found
+	int FindEntry(const std::string& name) const;
+
+	const char* data;
+	size_t size;
+	const Header* header;
+	const Entry* entries;
+	const char* strings;
+
+#if __WIN32__
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+EffectPack::IsMounted() const
+{
+	return this->data != NULL;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+EffectPack::GetNumEntries() const
+{
+	return this->header ? this->header->numEntries : 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+EffectPack::HasEffect(const std::string& name) const
+{
+	return this->FindEntry(name) != -1;
+}
+
+} // namespace AnyFX
+//------------------------------------------------------------------------------
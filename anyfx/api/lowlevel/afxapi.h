@@ -13,4 +13,5 @@
 #define AFX_LOWLEVEL_API
 #endif
 
-#include "shadereffect.h"
\ No newline at end of file
+#include "shadereffect.h"
+#include "varblockinstance.h"
\ No newline at end of file
@@ -3,6 +3,10 @@
 // (C) 2016 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "programbase.h"
+#include "compression.h"
+#include <string.h>
+#include <stdio.h>
+#include <utility>
 
 namespace AnyFX
 {
@@ -14,9 +18,17 @@ ProgramBase::ProgramBase() :
 	patchSize(0),
 	numVsInputs(0),
 	numPsOutputs(0),
-	valid(false)
+	vsInputStride(0),
+	valid(false),
+	pushConstantOffset(0),
+	pushConstantSize(0)
 {
 	memset(&this->shaderBlock, 0, sizeof(this->shaderBlock));
+	memset(this->compression, 0, sizeof(this->compression));
+	memset(this->compressedSize, 0, sizeof(this->compressedSize));
+	memset(this->uncompressedSize, 0, sizeof(this->uncompressedSize));
+	memset(this->compressedBinary, 0, sizeof(this->compressedBinary));
+	memset(this->binaryHash, 0, sizeof(this->binaryHash));
 }
 
 //------------------------------------------------------------------------------
@@ -24,7 +36,46 @@ ProgramBase::ProgramBase() :
 */
 ProgramBase::~ProgramBase()
 {
-	// empty
+	delete[] this->shaderBlock.vsBinary;
+	delete[] this->shaderBlock.hsBinary;
+	delete[] this->shaderBlock.dsBinary;
+	delete[] this->shaderBlock.gsBinary;
+	delete[] this->shaderBlock.psBinary;
+	delete[] this->shaderBlock.csBinary;
+	unsigned i;
+	for (i = 0; i < NumStages; i++) delete[] this->compressedBinary[i];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const char*
+ProgramBase::GetBinary(const Stage stage, unsigned& size)
+{
+	unsigned* sizes[] = { &this->shaderBlock.vsBinarySize, &this->shaderBlock.hsBinarySize, &this->shaderBlock.dsBinarySize, &this->shaderBlock.gsBinarySize, &this->shaderBlock.psBinarySize, &this->shaderBlock.csBinarySize };
+	char** binaries[] = { &this->shaderBlock.vsBinary, &this->shaderBlock.hsBinary, &this->shaderBlock.dsBinary, &this->shaderBlock.gsBinary, &this->shaderBlock.psBinary, &this->shaderBlock.csBinary };
+
+	std::lock_guard<std::mutex> lock(this->binaryLock);
+	if (this->compressedBinary[stage] != NULL)
+	{
+		size = this->uncompressedSize[stage];
+		char* binary = new char[size];
+		if (!LZDecompress(this->compressedBinary[stage], this->compressedSize[stage], binary, size))
+		{
+			printf("Failed to decompress binary for stage %d in program '%s', suspected file corruption.\n", stage, this->name.c_str());
+			delete[] binary;
+			size = 0;
+			return NULL;
+		}
+		*binaries[stage] = binary;
+		*sizes[stage] = size;
+		delete[] this->compressedBinary[stage];
+		this->compressedBinary[stage] = NULL;
+		this->compressedSize[stage] = 0;
+		this->uncompressedSize[stage] = 0;
+	}
+	size = *sizes[stage];
+	return *binaries[stage];
 }
 
 //------------------------------------------------------------------------------
@@ -36,4 +87,42 @@ ProgramBase::OnLoaded()
 	// empty, override in subclass
 }
 
+//------------------------------------------------------------------------------
+/**
+	The name is the same for both, so it is left alone.
+*/
+void
+ProgramBase::Swap(ProgramBase* other)
+{
+	std::lock_guard<std::mutex> lock(this->binaryLock);
+	std::lock_guard<std::mutex> otherLock(other->binaryLock);
+	std::swap(this->shaderBlock, other->shaderBlock);
+	std::swap(this->supportsTessellation, other->supportsTessellation);
+	std::swap(this->supportsTransformFeedback, other->supportsTransformFeedback);
+	std::swap(this->patchSize, other->patchSize);
+	std::swap(this->numVsInputs, other->numVsInputs);
+	this->vsInputSlots.swap(other->vsInputSlots);
+	std::swap(this->numPsOutputs, other->numPsOutputs);
+	this->psOutputSlots.swap(other->psOutputSlots);
+	this->vsInputTypes.swap(other->vsInputTypes);
+	this->vsInputArraySizes.swap(other->vsInputArraySizes);
+	this->vsInputOffsets.swap(other->vsInputOffsets);
+	std::swap(this->vsInputStride, other->vsInputStride);
+	std::swap(this->valid, other->valid);
+	this->activeVarblockNames.swap(other->activeVarblockNames);
+	this->activeVariableNames.swap(other->activeVariableNames);
+	this->variableBlockOffsets.swap(other->variableBlockOffsets);
+	std::swap(this->renderState, other->renderState);
+	std::swap(this->binaryHash, other->binaryHash);
+	this->specializationIds.swap(other->specializationIds);
+	this->specializationValues.swap(other->specializationValues);
+	std::swap(this->pushConstantOffset, other->pushConstantOffset);
+	std::swap(this->pushConstantSize, other->pushConstantSize);
+	std::swap(this->compression, other->compression);
+	std::swap(this->compressedSize, other->compressedSize);
+	std::swap(this->uncompressedSize, other->uncompressedSize);
+	std::swap(this->compressedBinary, other->compressedBinary);
+	this->SwapAnnotations(*other);
+}
+
 } // namespace AnyFX
\ No newline at end of file
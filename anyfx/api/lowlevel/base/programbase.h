@@ -10,6 +10,7 @@
 #include "shaderbase.h"
 #include "renderstatebase.h"
 #include <unordered_set>
+#include <mutex>
 namespace AnyFX
 {
 struct ProgramBase : public Annotable
@@ -20,6 +21,23 @@ public:
 	/// destructor
 	virtual ~ProgramBase();
 
+	enum Stage
+	{
+		VertexStage,
+		HullStage,
+		DomainStage,
+		GeometryStage,
+		PixelStage,
+		ComputeStage,
+
+		NumStages
+	};
+
+	/// get binary for stage, decompresses it on first access if the effect was compiled with /COMPRESS, returns NULL if stage is unused
+	const char* GetBinary(const Stage stage, unsigned& size);
+
+	// binaries of compressed stages are NULL with a size of 0 until GetBinary has decompressed them, so use it rather than reading the block
+
 	struct ShaderBlock
 	{
 		ShaderBase* vs;		                                        // vertex shader
@@ -55,6 +73,12 @@ public:
 	std::vector<unsigned> vsInputSlots;
 	unsigned numPsOutputs;
 	std::vector<unsigned> psOutputSlots;
+
+	// type, array size and offset in a tightly packed vertex of each vertex shader input, in the same order as the input slots
+	std::vector<VariableType> vsInputTypes;
+	std::vector<unsigned> vsInputArraySizes;
+	std::vector<unsigned> vsInputOffsets;
+	unsigned vsInputStride;
 	std::string name;
 	bool valid;
 
@@ -63,10 +87,31 @@ public:
 	std::map<std::string, unsigned> variableBlockOffsets;
 	RenderStateBase* renderState;
 
+	// hash of each stage binary as stored in the file, tells which programs changed when reloading
+	unsigned long long binaryHash[NumStages];
+
+	// specialization constant ids and the values this program sets them to, values are 32 bits each and packed so they can be handed to the API as is
+	std::vector<unsigned> specializationIds;
+	std::vector<unsigned> specializationValues;
+
+	// range of the promoted push constants this program uses, size is 0 if it uses none
+	unsigned pushConstantOffset;
+	unsigned pushConstantSize;
+
 protected:
 	friend class ProgramLoader;
+	friend class ShaderEffect;
 
 	/// callback for when program is done loading
 	virtual void OnLoaded();
+	/// swap contents with a reloaded program of the same type, keeps both addresses
+	virtual void Swap(ProgramBase* other);
+
+	// compressed stage binaries, the matching binary and size in the shader block are NULL and 0 until decompressed
+	unsigned compression[NumStages];
+	unsigned compressedSize[NumStages];
+	unsigned uncompressedSize[NumStages];
+	char* compressedBinary[NumStages];
+	std::mutex binaryLock;
 };
 } // namespace AnyFX
\ No newline at end of file
@@ -3,6 +3,8 @@
 // (C) 2016 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "renderstatebase.h"
+#include <string.h>
+#include <utility>
 
 namespace AnyFX
 {
@@ -12,7 +14,9 @@ namespace AnyFX
 */
 RenderStateBase::RenderStateBase()
 {
-	// empty
+	// clear padding too, so settings can be compared bytewise
+	memset(&this->renderSettings, 0, sizeof(this->renderSettings));
+	memset(&this->defaultRenderSettings, 0, sizeof(this->defaultRenderSettings));
 }
 
 //------------------------------------------------------------------------------
@@ -32,4 +36,16 @@ RenderStateBase::OnLoaded()
 	// empty, override in subclass
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+RenderStateBase::Swap(RenderStateBase* other)
+{
+	std::swap(this->renderSettings, other->renderSettings);
+	std::swap(this->defaultRenderSettings, other->defaultRenderSettings);
+	this->SwapAnnotations(*other);
+	this->OnLoaded();
+}
+
 } // namespace AnyFX
\ No newline at end of file
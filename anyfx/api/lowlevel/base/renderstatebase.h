@@ -74,8 +74,11 @@ public:
 
 protected:
 	friend class RenderStateLoader;
+	friend class ShaderEffect;
 
 	/// callback for when program is done loading
 	virtual void OnLoaded();
+	/// swap settings with a reloaded render state of the same type, keeps both addresses
+	void Swap(RenderStateBase* other);
 };
 } // namespace AnyFX
\ No newline at end of file
@@ -10,7 +10,10 @@ namespace AnyFX
 //------------------------------------------------------------------------------
 /**
 */
-SamplerBase::SamplerBase()
+SamplerBase::SamplerBase() :
+	binding(0),
+	set(0),
+	isStatic(false)
 {
 	// empty
 }
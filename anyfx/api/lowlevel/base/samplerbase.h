@@ -40,6 +40,7 @@ public:
 	std::string name;
 	unsigned binding;
 	unsigned set;
+	bool isStatic;		// settings never change, so the sampler can be baked into the descriptor set layout
 	std::vector<VariableBase*> textureVariables;
 
 protected:
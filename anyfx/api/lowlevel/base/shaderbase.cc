@@ -3,6 +3,7 @@
 // (C) 2016 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "shaderbase.h"
+#include <utility>
 
 namespace AnyFX
 {
@@ -32,4 +33,19 @@ ShaderBase::OnLoaded()
 	// empty, override in subclass
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderBase::Swap(ShaderBase* other)
+{
+	std::swap(this->type, other->type);
+	this->sourceCode.swap(other->sourceCode);
+	this->error.swap(other->error);
+	this->warning.swap(other->warning);
+	std::swap(this->localSizes, other->localSizes);
+	this->SwapAnnotations(*other);
+	this->OnLoaded();
+}
+
 } // namespace AnyFX
\ No newline at end of file
@@ -27,8 +27,11 @@ public:
 
 protected:
 	friend class ShaderLoader;
+	friend class ShaderEffect;
 
 	/// callback for when program is done loading
 	virtual void OnLoaded();
+	/// swap contents with a reloaded shader of the same type, keeps both addresses
+	void Swap(ShaderBase* other);
 };
 } // namespace AnyFX
\ No newline at end of file
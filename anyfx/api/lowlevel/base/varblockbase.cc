@@ -4,6 +4,7 @@
 //------------------------------------------------------------------------------
 #include "varblockbase.h"
 #include "variablebase.h"
+#include <utility>
 
 namespace AnyFX
 {
@@ -40,7 +41,9 @@ VarblockBase::~VarblockBase()
 void
 VarblockBase::OnLoaded()
 {
-	// setup this varblock
+	// setup this varblock, starting over since this is called again when reloaded
+	this->byteSize = 0;
+	this->signature.clear();
 	unsigned i;
 	for (i = 0; i < this->variables.size(); i++)
 	{
@@ -60,4 +63,19 @@ VarblockBase::OnLoaded()
 	this->signature.append("}");
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+VarblockBase::SwapLayout(VarblockBase* other)
+{
+	std::swap(this->alignedSize, other->alignedSize);
+	this->offsetsByName.swap(other->offsetsByName);
+	std::swap(this->qualifiers, other->qualifiers);
+	std::swap(this->binding, other->binding);
+	std::swap(this->set, other->set);
+	this->SwapAnnotations(*other);
+	this->OnLoaded();
+}
+
 } // namespace AnyFX
\ No newline at end of file
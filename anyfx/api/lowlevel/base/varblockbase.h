@@ -48,8 +48,11 @@ public:
 
 protected:
 	friend class VarblockLoader;
+	friend class ShaderEffect;
 
 	/// callback for when program is done loading
 	virtual void OnLoaded();
+	/// swap layout with a reloaded varblock of the same type, the variables are kept since they must be the same
+	void SwapLayout(VarblockBase* other);
 };
 } // namespace AnyFX
\ No newline at end of file
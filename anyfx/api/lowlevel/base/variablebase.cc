@@ -47,18 +47,21 @@ VariableBase::OnLoaded()
 
 	this->byteSize = TypeToByteSize(this->type) * this->arraySize;
 	this->currentValue = new char[this->byteSize];
+	memset(this->currentValue, 0, this->byteSize);
 	if (this->hasDefaultValue)
 	{
-		this->SetupDefaultValue(this->defaultValueString);
-	}
-	else
-	{
-		memset(this->currentValue, 0, this->byteSize);
+		if (!this->defaultValue.empty())
+		{
+			size_t size = this->defaultValue.size() < (size_t)this->byteSize ? this->defaultValue.size() : (size_t)this->byteSize;
+			memcpy(this->currentValue, this->defaultValue.data(), size);
+		}
+		else this->SetupDefaultValue(this->defaultValueString);
 	}
 }
 
 //------------------------------------------------------------------------------
 /**
+	Only used for files older than 2.4, newer files have the default value precomputed.
 */
 void
 VariableBase::SetupDefaultValue(const std::string& string)
@@ -72,14 +75,19 @@ VariableBase::SetupDefaultValue(const std::string& string)
 	{
 		switch (this->type)
 		{
-		case Float:
-		case Float2:
-		case Float3:
-		case Float4:
 		case Double:
 		case Double2:
 		case Double3:
 		case Double4:
+		{
+			double value = atof(str);
+			memcpy((void*)(this->currentValue + numValues * sizeof(double)), (void*)&value, sizeof(double));
+			break;
+		}
+		case Float:
+		case Float2:
+		case Float3:
+		case Float4:
 		case Matrix2x2:
 		case Matrix2x3:
 		case Matrix2x4:
@@ -112,7 +120,7 @@ VariableBase::SetupDefaultValue(const std::string& string)
 		case Bool3:
 		case Bool4:
 		{
-			int value = atoi(str);
+			bool value = atoi(str) != 0;
 			memcpy((void*)(this->currentValue + numValues * sizeof(bool)), (void*)&value, sizeof(bool));
 			break;
 		}
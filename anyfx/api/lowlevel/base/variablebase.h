@@ -8,6 +8,7 @@
 //------------------------------------------------------------------------------
 #include "annotable.h"
 #include <string>
+#include <vector>
 namespace AnyFX
 {
 struct VarblockBase;
@@ -23,6 +24,7 @@ public:
 	std::string name;
 	std::string signature;
 	std::string defaultValueString;
+	std::vector<char> defaultValue;			// default value precomputed by the compiler, empty for files older than 2.4
 
 	int format;
 	int access;
@@ -14,6 +14,8 @@
 #include "gl4/gl4program.h"
 #include "vk/vkprogram.h"
 #include "shadertypes.h"
+#include "compression.h"
+#include "util.h"
 #include <assert.h>
 
 namespace AnyFX
@@ -35,6 +37,36 @@ ProgramLoader::~ProgramLoader()
 	// empty
 }
 
+//------------------------------------------------------------------------------
+/**
+	From version 2.3 each binary is tagged with its compression, compressed binaries are kept as is until first requested.
+*/
+void
+ProgramLoader::ReadBinary(BinReader* reader, ShaderEffect* effect, ProgramBase* program, unsigned stage, unsigned& size, char*& binary)
+{
+	size = reader->ReadUInt();
+	unsigned compression = NoCompression;
+	if (effect->fileMinor >= 3) compression = reader->ReadUInt();
+	if (compression == NoCompression)
+	{
+		binary = reader->ReadBytes(size);
+		program->binaryHash[stage] = HashString64(binary, size, size);
+	}
+	else
+	{
+		assert(compression == LZCompression);
+		program->compression[stage] = compression;
+		program->compressedSize[stage] = reader->ReadUInt();
+		program->compressedBinary[stage] = reader->ReadBytes(program->compressedSize[stage]);
+		program->binaryHash[stage] = HashString64(program->compressedBinary[stage], program->compressedSize[stage], size);
+		program->uncompressedSize[stage] = size;
+
+		// the block only shows the binary once it is there
+		size = 0;
+		binary = NULL;
+	}
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -90,6 +122,20 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
 		program->psOutputSlots[i] = reader->ReadUInt();
 	}
 
+	if (effect->fileMinor >= 9)
+	{
+		program->vsInputTypes.resize(program->numVsInputs);
+		program->vsInputArraySizes.resize(program->numVsInputs);
+		program->vsInputOffsets.resize(program->numVsInputs);
+		for (i = 0; i < program->numVsInputs; i++)
+		{
+			program->vsInputTypes[i] = (VariableType)reader->ReadInt();
+			program->vsInputArraySizes[i] = reader->ReadUInt();
+			program->vsInputOffsets[i] = reader->ReadUInt();
+		}
+		program->vsInputStride = reader->ReadUInt();
+	}
+
     // read and set transform feedback support
     bool supportsTransformFeedback = reader->ReadBool();
 	program->supportsTransformFeedback = supportsTransformFeedback;
@@ -105,8 +151,7 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
         std::string var = reader->ReadString().c_str();
         std::string imp = reader->ReadString().c_str();
     }
-	program->shaderBlock.vsBinarySize = reader->ReadUInt();
-	program->shaderBlock.vsBinary = reader->ReadBytes(program->shaderBlock.vsBinarySize);
+	this->ReadBinary(reader, effect, program, ProgramBase::VertexStage, program->shaderBlock.vsBinarySize, program->shaderBlock.vsBinary);
 
 	magic = reader->ReadInt();
 	assert('HULL' == magic);
@@ -117,8 +162,7 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
         std::string var = reader->ReadString().c_str();
         std::string imp = reader->ReadString().c_str();
     }
-	program->shaderBlock.hsBinarySize = reader->ReadUInt();
-	program->shaderBlock.hsBinary = reader->ReadBytes(program->shaderBlock.hsBinarySize);
+	this->ReadBinary(reader, effect, program, ProgramBase::HullStage, program->shaderBlock.hsBinarySize, program->shaderBlock.hsBinary);
 
 	magic = reader->ReadInt();
 	assert('DOMA' == magic);
@@ -129,8 +173,7 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
         std::string var = reader->ReadString().c_str();
         std::string imp = reader->ReadString().c_str();
     }
-	program->shaderBlock.dsBinarySize = reader->ReadUInt();
-	program->shaderBlock.dsBinary = reader->ReadBytes(program->shaderBlock.dsBinarySize);
+	this->ReadBinary(reader, effect, program, ProgramBase::DomainStage, program->shaderBlock.dsBinarySize, program->shaderBlock.dsBinary);
 
 	magic = reader->ReadInt();
 	assert('GEOM' == magic);
@@ -141,8 +184,7 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
         std::string var = reader->ReadString().c_str();
         std::string imp = reader->ReadString().c_str();
     }
-	program->shaderBlock.gsBinarySize = reader->ReadUInt();
-	program->shaderBlock.gsBinary = reader->ReadBytes(program->shaderBlock.gsBinarySize);
+	this->ReadBinary(reader, effect, program, ProgramBase::GeometryStage, program->shaderBlock.gsBinarySize, program->shaderBlock.gsBinary);
 
 	magic = reader->ReadInt();
 	assert('PIXL' == magic);
@@ -153,8 +195,7 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
 		std::string var = reader->ReadString().c_str();
 		std::string imp = reader->ReadString().c_str();
 	}
-	program->shaderBlock.psBinarySize = reader->ReadUInt();
-	program->shaderBlock.psBinary = reader->ReadBytes(program->shaderBlock.psBinarySize);
+	this->ReadBinary(reader, effect, program, ProgramBase::PixelStage, program->shaderBlock.psBinarySize, program->shaderBlock.psBinary);
 
 	magic = reader->ReadInt();
 	assert('COMP' == magic);
@@ -165,8 +206,7 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
         std::string var = reader->ReadString().c_str();
         std::string imp = reader->ReadString().c_str();
     }
-	program->shaderBlock.csBinarySize = reader->ReadUInt();
-	program->shaderBlock.csBinary = reader->ReadBytes(program->shaderBlock.csBinarySize);
+	this->ReadBinary(reader, effect, program, ProgramBase::ComputeStage, program->shaderBlock.csBinarySize, program->shaderBlock.csBinary);
 
 	// read names of active blocks
 	unsigned numActiveBlocks = reader->ReadUInt();
@@ -195,6 +235,24 @@ ProgramLoader::Load(BinReader* reader, ShaderEffect* effect)
 	assert('RSTA' == magic);
     std::string rs = reader->ReadString().c_str();
 
+	if (effect->fileMinor >= 5)
+	{
+		unsigned numSpecializations = reader->ReadUInt();
+		program->specializationIds.resize(numSpecializations);
+		program->specializationValues.resize(numSpecializations);
+		for (i = 0; i < numSpecializations; i++)
+		{
+			program->specializationIds[i] = reader->ReadUInt();
+			program->specializationValues[i] = reader->ReadUInt();
+		}
+	}
+
+	if (effect->fileMinor >= 7)
+	{
+		program->pushConstantOffset = reader->ReadUInt();
+		program->pushConstantSize = reader->ReadUInt();
+	}
+
 	// find shaders previously loaded in the effect and attach them to this program
 	if (!vs.empty())
 	{
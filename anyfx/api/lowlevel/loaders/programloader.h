@@ -24,8 +24,11 @@ public:
 
 private:
 	friend class StreamLoader;
+	friend class ShaderEffect;
 
 	ProgramBase* Load(BinReader* reader, ShaderEffect* effect);
+	/// read stage binary, keeping it compressed if it was stored compressed
+	void ReadBinary(BinReader* reader, ShaderEffect* effect, ProgramBase* program, unsigned stage, unsigned& size, char*& binary);
 }; 
 } // namespace AnyFX
 //------------------------------------------------------------------------------
\ No newline at end of file
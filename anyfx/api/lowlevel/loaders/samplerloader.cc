@@ -82,6 +82,7 @@ SamplerLoader::Load(BinReader* reader, ShaderEffect* effect)
 		var->sampler = sampler;
 		sampler->textureVariables[i] = var;		
 	}
+	if (effect->fileMinor >= 8) sampler->isStatic = reader->ReadBool();
 
 	sampler->OnLoaded();
 	return sampler;
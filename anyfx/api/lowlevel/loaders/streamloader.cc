@@ -14,6 +14,7 @@
 #include "base/subroutinebase.h"
 #include <assert.h>
 #include <string.h>
+#include <chrono>
 
 
 namespace AnyFX
@@ -22,7 +23,10 @@ namespace AnyFX
 //------------------------------------------------------------------------------
 /**
 */
-StreamLoader::StreamLoader()
+StreamLoader::StreamLoader() :
+	reader(NULL),
+	deferPrograms(false),
+	programChunkEnd(0)
 {
 	// empty
 }
@@ -46,14 +50,16 @@ StreamLoader::Load()
 
 	// read magic integer
 	int magic = this->reader->ReadInt();
-	int major = this->reader->ReadInt();
-	int minor = this->reader->ReadInt();
+	int fileMajor = this->reader->ReadInt();
+	int fileMinor = this->reader->ReadInt();
 
 	// check magic is right, then check version numbering
 	if (magic == 'ANFX' &&
-		major <= 2 &&
-		minor <= 1)
+		fileMajor <= 2 &&
+		fileMinor <= 11)
 	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
 		// load header, this must always come first!
 		int magic = this->reader->ReadInt();
 		assert(magic == 'HEAD');
@@ -66,12 +72,24 @@ StreamLoader::Load()
 		effect->header = (Implementation)profile;
 		effect->major = major;
 		effect->minor = minor;
+		effect->fileMajor = fileMajor;
+		effect->fileMinor = fileMinor;
+
+		// version 2.2 and up has a directory of chunk and program offsets right after the header
+		if (fileMajor == 2 && fileMinor >= 2)
+		{
+			int magic = this->reader->ReadInt();
+			assert(magic == 'DIRE');
+			this->LoadDirectory(effect);
+		}
 
 		// while we are not at the end of the file, read stuff
 		while (true)
 		{			
 			// get fourcc code for object
 			int fourcc = this->reader->ReadInt();
+			std::chrono::steady_clock::time_point chunkStart = std::chrono::steady_clock::now();
+			double* loadTime = NULL;
 
 			// check what to load
 			if (this->reader->Eof())
@@ -81,6 +99,8 @@ StreamLoader::Load()
 			}
 			else if (fourcc == 'SHAD')
 			{
+				loadTime = &effect->loadStatistics.shaderLoadTime;
+
 				// get number of shaders and pre-allocate size
 				unsigned numShaders = this->reader->ReadUInt();
 				if (numShaders > 0)
@@ -98,6 +118,8 @@ StreamLoader::Load()
 			}
             else if (fourcc == 'SUBR')
             {
+                loadTime = &effect->loadStatistics.subroutineLoadTime;
+
                 unsigned numSubroutines = this->reader->ReadUInt();
 
 				if (numSubroutines > 0)
@@ -112,8 +134,18 @@ StreamLoader::Load()
 					}
 				}
             }
+			else if (fourcc == 'PROG' && effect->deferredReader != NULL)
+			{
+				loadTime = &effect->loadStatistics.programLoadTime;
+
+				// programs are registered from the directory and loaded on first access, so skip the whole chunk
+				if (this->programChunkEnd == 0) break;
+				this->reader->Seek(this->programChunkEnd);
+			}
 			else if (fourcc == 'PROG')
 			{
+				loadTime = &effect->loadStatistics.programLoadTime;
+
 				// read number of programs and pre-allocate size
 				unsigned numProgs = this->reader->ReadUInt();
 
@@ -132,6 +164,8 @@ StreamLoader::Load()
 			}
 			else if (fourcc == 'RENS')
 			{
+				loadTime = &effect->loadStatistics.renderStateLoadTime;
+
 				unsigned numStates = this->reader->ReadUInt();
 				if (numStates > 0)
 				{
@@ -148,6 +182,8 @@ StreamLoader::Load()
 			}
 			else if (fourcc == 'VARI')
 			{
+				loadTime = &effect->loadStatistics.variableLoadTime;
+
 				unsigned numVars = this->reader->ReadUInt();
 				if (numVars > 0)
 				{
@@ -165,6 +201,8 @@ StreamLoader::Load()
 			}
 			else if (fourcc == 'SAMP')
 			{
+				loadTime = &effect->loadStatistics.samplerLoadTime;
+
 				unsigned numSamplers = this->reader->ReadUInt();
 
 				if (numSamplers > 0)
@@ -182,6 +220,8 @@ StreamLoader::Load()
 			}
 			else if (fourcc == 'VARB')
 			{
+				loadTime = &effect->loadStatistics.varblockLoadTime;
+
 				unsigned numBlocks = this->reader->ReadUInt();
 				if (numBlocks > 0)
 				{
@@ -215,6 +255,8 @@ StreamLoader::Load()
 			}
             else if (fourcc == 'VRBF')
             {
+                loadTime = &effect->loadStatistics.varbufferLoadTime;
+
                 unsigned numBuffers = this->reader->ReadUInt();
 				if (numBuffers > 0)
 				{
@@ -229,15 +271,78 @@ StreamLoader::Load()
 					}
 				}
             }
+			else if (fourcc == 'PERM')
+			{
+				unsigned numGroups = this->reader->ReadUInt();
+				effect->permutationGroups.resize(numGroups);
+
+				unsigned i, j, k;
+				for (i = 0; i < numGroups; i++)
+				{
+					ShaderEffect::PermutationGroup& group = effect->permutationGroups[i];
+					group.name = this->reader->ReadString();
+					group.axes.resize(this->reader->ReadUInt());
+					for (j = 0; j < group.axes.size(); j++)
+					{
+						ShaderEffect::PermutationAxis& axis = group.axes[j];
+						axis.name = this->reader->ReadString();
+						axis.shift = this->reader->ReadUInt();
+						axis.bits = this->reader->ReadUInt();
+						axis.flags.resize(this->reader->ReadUInt());
+						for (k = 0; k < axis.flags.size(); k++) axis.flags[k] = this->reader->ReadString();
+					}
+					group.programs.resize(this->reader->ReadUInt());
+					for (j = 0; j < group.programs.size(); j++) group.programs[j] = this->reader->ReadUInt();
+				}
+			}
+			else if (fourcc == 'PIPE')
+			{
+				unsigned numSets = this->reader->ReadUInt();
+				effect->setLayouts.resize(numSets);
+				unsigned i, j;
+				for (i = 0; i < numSets; i++)
+				{
+					effect->setLayouts[i].set = this->reader->ReadUInt();
+					effect->setLayouts[i].hash = this->reader->ReadUInt64();
+				}
+
+				unsigned numRecipes = this->reader->ReadUInt();
+				effect->pipelineRecipes.resize(numRecipes);
+				for (i = 0; i < numRecipes; i++)
+				{
+					ShaderEffect::PipelineRecipe& recipe = effect->pipelineRecipes[i];
+					recipe.program = this->reader->ReadUInt();
+					for (j = 0; j < ProgramBase::NumStages; j++) recipe.stageHashes[j] = this->reader->ReadUInt64();
+					recipe.renderStateHash = this->reader->ReadUInt64();
+					recipe.vertexLayoutHash = this->reader->ReadUInt64();
+					recipe.pipelineLayoutHash = this->reader->ReadUInt64();
+				}
+			}
+			else if (fourcc == 'PART')
+			{
+				// only some programs were compiled, the selection is informational
+				effect->partial = true;
+				this->reader->ReadString();
+			}
 			else
 			{
 				// unknown FourCC found, so terminate parsing, delete effect and return NULL pointer
 				printf("Unknown FourCC code %d in file, suspected file corruption.\n", fourcc);
+				effect->deferredReader = NULL;		// the reader still belongs to the caller, who deletes it when we fail
 				delete effect;
 				return NULL;
 			}
+
+			if (loadTime != NULL)
+			{
+				std::chrono::duration<double> time = std::chrono::steady_clock::now() - chunkStart;
+				*loadTime += time.count();
+			}
 		}
 
+		std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		effect->loadStatistics.totalLoadTime = time.count();
+
 		// everything went smooth, so return effect
 		return effect;
 	}
@@ -248,4 +353,52 @@ StreamLoader::Load()
 	}
 }
 
+//------------------------------------------------------------------------------
+/**
+	The directory lists every chunk with its absolute offset, followed by every program with the offset of its record.
+	If programs are deferred, the effect takes over the reader and loads programs from these offsets when they are first requested.
+*/
+void
+StreamLoader::LoadDirectory(ShaderEffect* effect)
+{
+	unsigned numChunks = this->reader->ReadUInt();
+	unsigned programChunk = 0;
+	std::vector<unsigned> chunkOffsets(numChunks);
+	unsigned i;
+	for (i = 0; i < numChunks; i++)
+	{
+		int fourcc = this->reader->ReadInt();
+		chunkOffsets[i] = this->reader->ReadUInt();
+		if (fourcc == 'PROG') programChunk = chunkOffsets[i];
+	}
+
+	// find where the program chunk ends, which is the closest chunk after it, or the end of the file
+	this->programChunkEnd = 0;
+	for (i = 0; i < numChunks; i++)
+	{
+		if (chunkOffsets[i] > programChunk && (this->programChunkEnd == 0 || chunkOffsets[i] < this->programChunkEnd))
+			this->programChunkEnd = chunkOffsets[i];
+	}
+
+	unsigned numProgs = this->reader->ReadUInt();
+	if (this->deferPrograms)
+	{
+		effect->deferredReader = this->reader;
+		effect->deferredProgramOffsets.resize(numProgs);
+	}
+	for (i = 0; i < numProgs; i++)
+	{
+		std::string name = this->reader->ReadString();
+		unsigned offset = this->reader->ReadUInt();
+		if (this->deferPrograms)
+		{
+			assert(effect->programs.find(name) == effect->programs.end());
+			effect->programs[name] = NULL;
+			effect->programsByIndex.push_back(NULL);
+			effect->deferredProgramIndices[name] = i;
+			effect->deferredProgramOffsets[i] = offset;
+		}
+	}
+}
+
 } // namespace AnyFX
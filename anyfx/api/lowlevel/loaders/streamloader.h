@@ -33,12 +33,19 @@ public:
 	void SetReader(BinReader* reader);
 	/// get binary reader
 	BinReader* GetReader() const;
+	/// set if programs should be loaded on first access instead of up front, requires the reader to outlive the loader
+	void SetDeferPrograms(bool b);
+	/// get if programs are loaded on first access
+	bool GetDeferPrograms() const;
 
 private:
 	friend class EffectFactory;
+	friend class ShaderEffect;
 
 	/// loads effect
 	ShaderEffect* Load();
+	/// reads chunk directory, and if programs are deferred, registers them for loading on first access
+	void LoadDirectory(ShaderEffect* effect);
 
 	ShaderLoader shaderLoader;
 	VariableLoader variableLoader;
@@ -49,6 +56,8 @@ private:
 	VarbufferLoader varbufferLoader;
 	SubroutineLoader subroutineLoader;
 	BinReader* reader;
+	bool deferPrograms;
+	unsigned programChunkEnd;
 }; 
 
 //------------------------------------------------------------------------------
@@ -69,5 +78,23 @@ StreamLoader::GetReader() const
 	return this->reader;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+StreamLoader::SetDeferPrograms(bool b)
+{
+	this->deferPrograms = b;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+StreamLoader::GetDeferPrograms() const
+{
+	return this->deferPrograms;
+}
+
 } // namespace AnyFX
 //------------------------------------------------------------------------------
\ No newline at end of file
@@ -97,6 +97,14 @@ VariableLoader::Load(BinReader* reader, ShaderEffect* effect, VarblockBase* varb
 		defaultValue = reader->ReadString().c_str();
 		var->hasDefaultValue = true;
 		var->defaultValueString = defaultValue;
+
+		// from 2.4 the value is also stored in binary, ready to be copied
+		if (effect->fileMinor >= 4)
+		{
+			unsigned size = reader->ReadUInt();
+			var->defaultValue.resize(size);
+			reader->ReadBytes(var->defaultValue.data(), size);
+		}
 	}	
 
 	var->name = name;
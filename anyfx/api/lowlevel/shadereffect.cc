@@ -3,7 +3,14 @@
 // (C) 2016 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "shadereffect.h"
+#include "binreader.h"
+#include "loaders/programloader.h"
+#include "loaders/streamloader.h"
 #include <assert.h>
+#include <string.h>
+#include <set>
+#include <chrono>
+#include <algorithm>
 
 namespace AnyFX
 {
@@ -11,7 +18,11 @@ namespace AnyFX
 //------------------------------------------------------------------------------
 /**
 */
-ShaderEffect::ShaderEffect()
+ShaderEffect::ShaderEffect() :
+	fileMajor(0),
+	fileMinor(0),
+	partial(false),
+	deferredReader(NULL)
 {
 	// empty
 }
@@ -29,6 +40,15 @@ ShaderEffect::~ShaderEffect()
 	for (i = 0; i < this->subroutinesByIndex.size(); i++) delete this->subroutinesByIndex[i];
 	for (i = 0; i < this->varbuffersByIndex.size(); i++) delete this->varbuffersByIndex[i];
 	for (i = 0; i < this->samplersByIndex.size(); i++) delete this->samplersByIndex[i];
+	for (i = 0; i < this->retiredPrograms.size(); i++) delete this->retiredPrograms[i];
+	for (i = 0; i < this->retiredShaders.size(); i++) delete this->retiredShaders[i];
+	for (i = 0; i < this->retiredRenderStates.size(); i++) delete this->retiredRenderStates[i];
+
+	if (this->deferredReader)
+	{
+		this->deferredReader->Close();
+		delete this->deferredReader;
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -46,6 +66,7 @@ ShaderEffect::GetNumPrograms() const
 ProgramBase*
 ShaderEffect::GetProgram(const unsigned i) const
 {
+	if (this->deferredReader) return this->LoadDeferredProgram(i);
 	return this->programsByIndex[i];
 }
 
@@ -57,6 +78,7 @@ ShaderEffect::GetProgram(const std::string& name) const
 {
 	const auto it = this->programs.find(name);
 	assert(it != this->programs.end());
+	if (this->deferredReader) return this->LoadDeferredProgram(this->deferredProgramIndices.find(name)->second);
 	return it->second;
 }
 
@@ -66,9 +88,700 @@ ShaderEffect::GetProgram(const std::string& name) const
 const std::vector<ProgramBase*>&
 ShaderEffect::GetPrograms() const
 {
+	if (this->deferredReader)
+	{
+		unsigned i;
+		for (i = 0; i < this->programsByIndex.size(); i++) this->LoadDeferredProgram(i);
+	}
 	return this->programsByIndex;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderEffect::IsPartial() const
+{
+	return this->partial;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ShaderEffect::Statistics::Statistics()
+{
+	memset(this, 0, sizeof(Statistics));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ShaderEffect::Statistics&
+ShaderEffect::Statistics::operator+=(const Statistics& rhs)
+{
+	this->binaryBytes += rhs.binaryBytes;
+	this->nameBytes += rhs.nameBytes;
+	this->valueBytes += rhs.valueBytes;
+	this->containerBytes += rhs.containerBytes;
+	this->numEffects += rhs.numEffects;
+	this->numPrograms += rhs.numPrograms;
+	this->numShaders += rhs.numShaders;
+	this->numRenderStates += rhs.numRenderStates;
+	this->numVariables += rhs.numVariables;
+	this->numVarblocks += rhs.numVarblocks;
+	this->numVarbuffers += rhs.numVarbuffers;
+	this->numSamplers += rhs.numSamplers;
+	this->numSubroutines += rhs.numSubroutines;
+	this->shaderLoadTime += rhs.shaderLoadTime;
+	this->programLoadTime += rhs.programLoadTime;
+	this->renderStateLoadTime += rhs.renderStateLoadTime;
+	this->variableLoadTime += rhs.variableLoadTime;
+	this->varblockLoadTime += rhs.varblockLoadTime;
+	this->varbufferLoadTime += rhs.varbufferLoadTime;
+	this->samplerLoadTime += rhs.samplerLoadTime;
+	this->subroutineLoadTime += rhs.subroutineLoadTime;
+	this->totalLoadTime += rhs.totalLoadTime;
+	return *this;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Tree nodes hold the pair and three links and a color, the keys are names and hold their own copy.
+*/
+template <class MAP>
+static size_t
+MapBytes(const MAP& map)
+{
+	size_t bytes = map.size() * (sizeof(typename MAP::value_type) + 4 * sizeof(void*));
+	typename MAP::const_iterator it;
+	for (it = map.begin(); it != map.end(); it++) bytes += it->first.capacity();
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+static size_t
+GroupBytes(const std::map<unsigned, std::vector<TYPE*>>& groups)
+{
+	size_t bytes = groups.size() * (sizeof(std::pair<const unsigned, std::vector<TYPE*>>) + 4 * sizeof(void*));
+	typename std::map<unsigned, std::vector<TYPE*>>::const_iterator it;
+	for (it = groups.begin(); it != groups.end(); it++) bytes += it->second.capacity() * sizeof(TYPE*);
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class SET>
+static size_t
+StringSetBytes(const SET& set)
+{
+	size_t bytes = set.size() * (sizeof(std::string) + 2 * sizeof(void*)) + set.bucket_count() * sizeof(void*);
+	typename SET::const_iterator it;
+	for (it = set.begin(); it != set.end(); it++) bytes += it->capacity();
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Strings are counted by their capacity, so short ones kept inside the string itself are counted twice, which is close enough for budgeting.
+*/
+ShaderEffect::Statistics
+ShaderEffect::GetStatistics() const
+{
+	Statistics stats = this->loadStatistics;
+	stats.numEffects = 1;
+	stats.containerBytes += sizeof(ShaderEffect);
+	unsigned i, j;
+
+	{
+		std::lock_guard<std::mutex> lock(this->deferredLock);
+		for (i = 0; i < this->programsByIndex.size(); i++)
+		{
+			ProgramBase* program = this->programsByIndex[i];
+			if (program == NULL) continue;
+			stats.numPrograms++;
+
+			std::lock_guard<std::mutex> binaryLock(program->binaryLock);
+			const unsigned sizes[] = { program->shaderBlock.vsBinarySize, program->shaderBlock.hsBinarySize, program->shaderBlock.dsBinarySize, program->shaderBlock.gsBinarySize, program->shaderBlock.psBinarySize, program->shaderBlock.csBinarySize };
+			const char* binaries[] = { program->shaderBlock.vsBinary, program->shaderBlock.hsBinary, program->shaderBlock.dsBinary, program->shaderBlock.gsBinary, program->shaderBlock.psBinary, program->shaderBlock.csBinary };
+			for (j = 0; j < ProgramBase::NumStages; j++)
+			{
+				if (binaries[j] != NULL) stats.binaryBytes += sizes[j];
+				if (program->compressedBinary[j] != NULL) stats.binaryBytes += program->compressedSize[j];
+			}
+
+			stats.nameBytes += program->name.capacity() + program->GetAnnotationBytes();
+			stats.containerBytes += sizeof(ProgramBase) +
+				(program->vsInputSlots.capacity() + program->psOutputSlots.capacity() + program->vsInputArraySizes.capacity() + program->vsInputOffsets.capacity()) * sizeof(unsigned) +
+				program->vsInputTypes.capacity() * sizeof(VariableType) +
+				(program->specializationIds.capacity() + program->specializationValues.capacity()) * sizeof(unsigned) +
+				StringSetBytes(program->activeVarblockNames) + StringSetBytes(program->activeVariableNames) + MapBytes(program->variableBlockOffsets);
+		}
+		stats.containerBytes += MapBytes(this->programs) + this->programsByIndex.capacity() * sizeof(ProgramBase*) + MapBytes(this->deferredProgramIndices) +
+			this->deferredProgramOffsets.capacity() * sizeof(unsigned);
+		stats.binaryBytes += this->deferredData.capacity();
+	}
+
+	for (i = 0; i < this->shadersByIndex.size(); i++)
+	{
+		const ShaderBase* shader = this->shadersByIndex[i];
+		stats.numShaders++;
+		stats.binaryBytes += shader->sourceCode.capacity();
+		stats.nameBytes += shader->name.capacity() + shader->error.capacity() + shader->warning.capacity() + shader->GetAnnotationBytes();
+		stats.containerBytes += sizeof(ShaderBase);
+	}
+
+	for (i = 0; i < this->renderstatesByIndex.size(); i++)
+	{
+		const RenderStateBase* state = this->renderstatesByIndex[i];
+		stats.numRenderStates++;
+		stats.nameBytes += state->name.capacity() + state->GetAnnotationBytes();
+		stats.containerBytes += sizeof(RenderStateBase);
+	}
+
+	for (i = 0; i < this->variablesByIndex.size(); i++)
+	{
+		const VariableBase* var = this->variablesByIndex[i];
+		stats.numVariables++;
+		stats.nameBytes += var->name.capacity() + var->signature.capacity() + var->GetAnnotationBytes();
+		stats.valueBytes += var->defaultValueString.capacity() + var->defaultValue.capacity() + (var->currentValue != NULL ? var->byteSize : 0);
+		stats.containerBytes += sizeof(VariableBase);
+	}
+
+	for (i = 0; i < this->varblocksByIndex.size(); i++)
+	{
+		const VarblockBase* block = this->varblocksByIndex[i];
+		stats.numVarblocks++;
+		stats.nameBytes += block->name.capacity() + block->signature.capacity() + block->GetAnnotationBytes();
+		stats.containerBytes += sizeof(VarblockBase) + block->variables.capacity() * sizeof(VariableBase*) + MapBytes(block->variablesByName) + MapBytes(block->offsetsByName);
+	}
+
+	for (i = 0; i < this->varbuffersByIndex.size(); i++)
+	{
+		const VarbufferBase* buffer = this->varbuffersByIndex[i];
+		stats.numVarbuffers++;
+		stats.nameBytes += buffer->name.capacity() + buffer->signature.capacity() + buffer->GetAnnotationBytes();
+		stats.containerBytes += sizeof(VarbufferBase) + MapBytes(buffer->offsetsByName);
+	}
+
+	for (i = 0; i < this->samplersByIndex.size(); i++)
+	{
+		const SamplerBase* sampler = this->samplersByIndex[i];
+		stats.numSamplers++;
+		stats.nameBytes += sampler->name.capacity() + sampler->GetAnnotationBytes();
+		stats.containerBytes += sizeof(SamplerBase) + sampler->textureVariables.capacity() * sizeof(VariableBase*);
+	}
+
+	for (i = 0; i < this->subroutinesByIndex.size(); i++)
+	{
+		const SubroutineBase* subroutine = this->subroutinesByIndex[i];
+		stats.numSubroutines++;
+		stats.nameBytes += subroutine->name.capacity() + subroutine->GetAnnotationBytes();
+		stats.containerBytes += sizeof(SubroutineBase);
+	}
+
+	stats.containerBytes += GroupBytes(this->variablesByGroup) + GroupBytes(this->varblocksByGroup) + GroupBytes(this->varbuffersByGroup);
+	stats.containerBytes += MapBytes(this->shaders) + MapBytes(this->variables) + MapBytes(this->renderstates) + MapBytes(this->subroutines) +
+		MapBytes(this->varblocks) + MapBytes(this->varbuffers) + MapBytes(this->samplers) +
+		(this->shadersByIndex.capacity() + this->variablesByIndex.capacity() + this->renderstatesByIndex.capacity() + this->subroutinesByIndex.capacity() +
+		this->varblocksByIndex.capacity() + this->varbuffersByIndex.capacity() + this->samplersByIndex.capacity()) * sizeof(void*);
+	for (i = 0; i < this->permutationGroups.size(); i++)
+	{
+		const PermutationGroup& group = this->permutationGroups[i];
+		stats.containerBytes += sizeof(PermutationGroup) + group.axes.capacity() * sizeof(PermutationAxis) + group.programs.capacity() * sizeof(unsigned);
+	}
+	stats.containerBytes += this->pipelineRecipes.capacity() * sizeof(PipelineRecipe) + this->setLayouts.capacity() * sizeof(SetLayout);
+	return stats;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned
+ShaderEffect::GetNumPermutationGroups() const
+{
+	return this->permutationGroups.size();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const ShaderEffect::PermutationGroup&
+ShaderEffect::GetPermutationGroup(const unsigned i) const
+{
+	return this->permutationGroups[i];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const unsigned
+ShaderEffect::FindPermutationGroup(const std::string& name) const
+{
+	unsigned i;
+	for (i = 0; i < this->permutationGroups.size(); i++)
+	{
+		if (this->permutationGroups[i].name == name) return i;
+	}
+	return UINT_MAX;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Meant to be called once per feature when setting up, the result is combined with | into the masks used for lookups.
+*/
+unsigned
+ShaderEffect::GetPermutationBits(const unsigned group, const std::string& axis, const std::string& value) const
+{
+	const PermutationGroup& perm = this->permutationGroups[group];
+	unsigned i;
+	for (i = 0; i < perm.axes.size(); i++)
+	{
+		const PermutationAxis& permAxis = perm.axes[i];
+		if (permAxis.name != axis) continue;
+
+		const std::string valueFlag = axis + "=" + value;
+		unsigned j;
+		for (j = 0; j < permAxis.flags.size(); j++)
+		{
+			if (permAxis.flags[j] == value || permAxis.flags[j] == valueFlag) return j << permAxis.shift;
+		}
+		break;
+	}
+	assert(false && "Permutation axis or value doesn't exist");
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ProgramBase*
+ShaderEffect::GetPermutation(const unsigned group, const unsigned mask) const
+{
+	const std::vector<unsigned>& programs = this->permutationGroups[group].programs;
+	if (mask >= programs.size() || programs[mask] == UINT_MAX) return NULL;
+	return this->GetProgram(programs[mask]);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Meant to create pipelines up front, for instance on worker threads while loading, instead of when a draw first needs them.
+*/
+const std::vector<ShaderEffect::PipelineRecipe>&
+ShaderEffect::GetPipelineRecipes() const
+{
+	return this->pipelineRecipes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const std::vector<ShaderEffect::SetLayout>&
+ShaderEffect::GetSetLayouts() const
+{
+	return this->setLayouts;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderEffect::IsProgramLoaded(const unsigned i) const
+{
+	std::lock_guard<std::mutex> lock(this->deferredLock);
+	return this->programsByIndex[i] != NULL;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Programs are read from the offset recorded in the file directory, the reader is shared so loading is serialized.
+*/
+ProgramBase*
+ShaderEffect::LoadDeferredProgram(const unsigned i) const
+{
+	assert(this->deferredReader != NULL);
+	std::lock_guard<std::mutex> lock(this->deferredLock);
+
+	// already loaded, or another thread loaded it while we waited
+	if (this->programsByIndex[i] != NULL) return this->programsByIndex[i];
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ProgramLoader loader;
+	this->deferredReader->Seek(this->deferredProgramOffsets[i]);
+	ProgramBase* program = loader.Load(this->deferredReader, const_cast<ShaderEffect*>(this));
+	std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+	this->loadStatistics.programLoadTime += time.count();
+	this->loadStatistics.totalLoadTime += time.count();
+	assert(this->programs.find(program->name) != this->programs.end());
+	this->programs[program->name] = program;
+	this->programsByIndex[i] = program;
+	return program;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Matches incoming objects to ours by name. Changed ones are swapped into our object so its address
+	stays the same, new ones are taken over from the incoming effect, and ours which are gone are retired.
+	When keeping missing objects, the incoming ones are only a part of the effect, so ours stay where they
+	are and new ones are appended, which leaves every index valid.
+*/
+template <class TYPE, class COMPARE>
+void
+ShaderEffect::ReloadObjects(
+	std::map<std::string, TYPE*>& objects,
+	std::vector<TYPE*>& objectsByIndex,
+	std::vector<TYPE*>& incoming,
+	std::vector<TYPE*>& retired,
+	std::vector<TYPE*>* changed,
+	std::vector<TYPE*>* added,
+	std::vector<TYPE*>* removed,
+	bool keepMissing,
+	COMPARE hasChanged)
+{
+	unsigned i;
+	if (keepMissing)
+	{
+		for (i = 0; i < incoming.size(); i++)
+		{
+			TYPE* object = incoming[i];
+			typename std::map<std::string, TYPE*>::iterator it = objects.find(object->name);
+			if (it == objects.end())
+			{
+				incoming[i] = NULL;
+				objects[object->name] = object;
+				objectsByIndex.push_back(object);
+				if (added) added->push_back(object);
+			}
+			else if (hasChanged(it->second, object))
+			{
+				it->second->Swap(object);
+				if (changed) changed->push_back(it->second);
+			}
+		}
+		return;
+	}
+
+	std::map<std::string, TYPE*> reloaded;
+	std::vector<TYPE*> reloadedByIndex;
+	for (i = 0; i < incoming.size(); i++)
+	{
+		TYPE* object = incoming[i];
+		typename std::map<std::string, TYPE*>::iterator it = objects.find(object->name);
+		if (it == objects.end())
+		{
+			// take ownership, the incoming effect must not delete it
+			incoming[i] = NULL;
+			if (added) added->push_back(object);
+		}
+		else
+		{
+			TYPE* current = it->second;
+			if (hasChanged(current, object))
+			{
+				current->Swap(object);
+				if (changed) changed->push_back(current);
+			}
+			objects.erase(it);
+			object = current;
+		}
+		reloaded[object->name] = object;
+		reloadedByIndex.push_back(object);
+	}
+
+	// what's left is gone from the new version
+	typename std::map<std::string, TYPE*>::iterator it;
+	for (it = objects.begin(); it != objects.end(); it++)
+	{
+		retired.push_back(it->second);
+		if (removed) removed->push_back(it->second);
+	}
+	objects.swap(reloaded);
+	objectsByIndex.swap(reloadedByIndex);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+SamplerSettingsEqual(const SamplerBase::SamplerSettings& a, const SamplerBase::SamplerSettings& b)
+{
+	return a.filterMode == b.filterMode && a.addressU == b.addressU && a.addressV == b.addressV && a.addressW == b.addressW &&
+		a.comparisonFunc == b.comparisonFunc && a.isComparison == b.isComparison &&
+		a.minLod == b.minLod && a.maxLod == b.maxLod && a.lodBias == b.lodBias && a.maxAnisotropic == b.maxAnisotropic &&
+		memcmp(a.borderColor, b.borderColor, sizeof(a.borderColor)) == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Loads the buffer as a new effect, and moves whatever changed into this one. Resources the engine binds
+	itself, variables, buffers, samplers and the members of blocks, have to stay the same since engine side
+	objects are built from them, if they don't this fails and leaves the effect as it was.
+
+	A program counts as changed if it needs a new pipeline, which includes its render state having changed.
+	A partial effect only replaces the programs it contains and the shaders they use, everything else is kept.
+	Not thread safe, nothing may use the effect while it is reloaded.
+*/
+bool
+ShaderEffect::Reload(const char* data, size_t size, ReloadReport* report)
+{
+	BinReader reader;
+	reader.Open(data, size);
+	StreamLoader loader;
+	loader.SetReader(&reader);
+	ShaderEffect* fresh = loader.Load();
+	loader.SetReader(0);
+	reader.Close();
+	if (fresh == NULL) return false;
+
+	if (!this->IsReloadCompatible(fresh))
+	{
+		delete fresh;
+		return false;
+	}
+
+	// deferred programs need to be loaded to be compared, afterwards the stream isn't needed anymore
+	if (this->deferredReader != NULL)
+	{
+		this->GetPrograms();
+		this->deferredReader->Close();
+		delete this->deferredReader;
+		this->deferredReader = NULL;
+		this->deferredData.clear();
+		this->deferredProgramIndices.clear();
+		this->deferredProgramOffsets.clear();
+	}
+
+	ReloadReport localReport;
+	ReloadReport& res = report != NULL ? *report : localReport;
+	res = ReloadReport();
+
+	// permutation tables of a partial effect index its own programs, which are only known by name once merged
+	std::vector<std::string> freshProgramNames;
+	std::set<ProgramBase*> freshPrograms;
+	unsigned i;
+	if (fresh->partial)
+	{
+		for (i = 0; i < fresh->programsByIndex.size(); i++) freshProgramNames.push_back(fresh->programsByIndex[i]->name);
+	}
+
+	// shaders go first, programs are compared by which shaders they use
+	std::set<std::string> changedShaders;
+	ReloadObjects<ShaderBase>(this->shaders, this->shadersByIndex, fresh->shadersByIndex, this->retiredShaders, NULL, NULL, NULL, fresh->partial,
+		[&changedShaders](ShaderBase* a, ShaderBase* b)
+	{
+		bool changed = a->type != b->type || a->sourceCode != b->sourceCode || memcmp(a->localSizes, b->localSizes, sizeof(a->localSizes)) != 0;
+		if (changed) changedShaders.insert(a->name);
+		return changed;
+	});
+
+	std::set<std::string> changedRenderStates;
+	ReloadObjects(this->renderstates, this->renderstatesByIndex, fresh->renderstatesByIndex, this->retiredRenderStates, &res.changedRenderStates, &res.addedRenderStates, &res.removedRenderStates, false,
+		[&changedRenderStates](RenderStateBase* a, RenderStateBase* b)
+	{
+		bool changed = memcmp(&a->renderSettings, &b->renderSettings, sizeof(a->renderSettings)) != 0 || memcmp(&a->defaultRenderSettings, &b->defaultRenderSettings, sizeof(a->defaultRenderSettings)) != 0;
+		if (changed) changedRenderStates.insert(a->name);
+		return changed;
+	});
+
+	ReloadObjects(this->programs, this->programsByIndex, fresh->programsByIndex, this->retiredPrograms, &res.changedPrograms, &res.addedPrograms, &res.removedPrograms, fresh->partial,
+		[&changedShaders, &changedRenderStates](ProgramBase* a, ProgramBase* b)
+	{
+		if (memcmp(a->binaryHash, b->binaryHash, sizeof(a->binaryHash)) != 0) return true;
+		if (a->specializationIds != b->specializationIds || a->specializationValues != b->specializationValues) return true;
+		if (a->pushConstantOffset != b->pushConstantOffset || a->pushConstantSize != b->pushConstantSize) return true;
+		if (a->renderState->name != b->renderState->name || changedRenderStates.find(a->renderState->name) != changedRenderStates.end()) return true;
+
+		ShaderBase* stagesA[] = { a->shaderBlock.vs, a->shaderBlock.hs, a->shaderBlock.ds, a->shaderBlock.gs, a->shaderBlock.ps, a->shaderBlock.cs };
+		ShaderBase* stagesB[] = { b->shaderBlock.vs, b->shaderBlock.hs, b->shaderBlock.ds, b->shaderBlock.gs, b->shaderBlock.ps, b->shaderBlock.cs };
+		unsigned i;
+		for (i = 0; i < ProgramBase::NumStages; i++)
+		{
+			if ((stagesA[i] == NULL) != (stagesB[i] == NULL)) return true;
+			if (stagesA[i] != NULL && (stagesA[i]->name != stagesB[i]->name || changedShaders.find(stagesA[i]->name) != changedShaders.end())) return true;
+		}
+
+		return a->supportsTessellation != b->supportsTessellation || a->supportsTransformFeedback != b->supportsTransformFeedback || a->patchSize != b->patchSize ||
+			a->vsInputSlots != b->vsInputSlots || a->psOutputSlots != b->psOutputSlots || a->vsInputTypes != b->vsInputTypes ||
+			a->vsInputArraySizes != b->vsInputArraySizes || a->vsInputOffsets != b->vsInputOffsets || a->vsInputStride != b->vsInputStride ||
+			a->activeVarblockNames != b->activeVarblockNames || a->activeVariableNames != b->activeVariableNames || a->variableBlockOffsets != b->variableBlockOffsets;
+	});
+
+	// programs left out of a partial effect may still share a shader or render state which changed
+	if (fresh->partial)
+	{
+		for (i = 0; i < freshProgramNames.size(); i++) freshPrograms.insert(this->programs[freshProgramNames[i]]);
+		for (i = 0; i < this->programsByIndex.size(); i++)
+		{
+			ProgramBase* program = this->programsByIndex[i];
+			if (freshPrograms.find(program) != freshPrograms.end()) continue;
+			bool changed = changedRenderStates.find(program->renderState->name) != changedRenderStates.end();
+			ShaderBase* stages[] = { program->shaderBlock.vs, program->shaderBlock.hs, program->shaderBlock.ds, program->shaderBlock.gs, program->shaderBlock.ps, program->shaderBlock.cs };
+			unsigned j;
+			for (j = 0; j < ProgramBase::NumStages && !changed; j++)
+			{
+				changed = stages[j] != NULL && changedShaders.find(stages[j]->name) != changedShaders.end();
+			}
+			if (changed) res.changedPrograms.push_back(program);
+		}
+	}
+
+	// programs taken over or swapped still point into the new effect, point them to our objects instead
+	for (i = 0; i < this->programsByIndex.size(); i++)
+	{
+		ProgramBase* program = this->programsByIndex[i];
+		program->renderState = this->renderstates[program->renderState->name];
+		ShaderBase** stages[] = { &program->shaderBlock.vs, &program->shaderBlock.hs, &program->shaderBlock.ds, &program->shaderBlock.gs, &program->shaderBlock.ps, &program->shaderBlock.cs };
+		unsigned j;
+		for (j = 0; j < ProgramBase::NumStages; j++)
+		{
+			if (*stages[j] != NULL) *stages[j] = this->shaders[(*stages[j])->name];
+		}
+	}
+
+	// blocks keep their members, only their layout may change
+	for (i = 0; i < fresh->varblocksByIndex.size(); i++)
+	{
+		VarblockBase* block = fresh->varblocksByIndex[i];
+		VarblockBase* current = this->varblocks[block->name];
+		if (current->alignedSize != block->alignedSize || current->binding != block->binding || current->set != block->set ||
+			current->qualifiers != block->qualifiers || current->offsetsByName != block->offsetsByName)
+		{
+			current->SwapLayout(block);
+			res.changedVarblocks.push_back(current);
+		}
+	}
+
+	// program indices follow the new effect now, so its tables apply as they are, unless it only held some of them
+	if (fresh->partial) this->MergePermutationGroups(fresh, freshProgramNames);
+	else				this->permutationGroups.swap(fresh->permutationGroups);
+
+	// recipes of a partial effect replace ours for the same programs, set layouts can't change since the resources are the same
+	if (fresh->partial)
+	{
+		std::map<unsigned, unsigned> recipesByProgram;
+		for (i = 0; i < this->pipelineRecipes.size(); i++) recipesByProgram[this->pipelineRecipes[i].program] = i;
+		for (i = 0; i < fresh->pipelineRecipes.size(); i++)
+		{
+			PipelineRecipe recipe = fresh->pipelineRecipes[i];
+			recipe.program = (unsigned)(std::find(this->programsByIndex.begin(), this->programsByIndex.end(), this->programs[freshProgramNames[recipe.program]]) - this->programsByIndex.begin());
+			const auto it = recipesByProgram.find(recipe.program);
+			if (it != recipesByProgram.end()) this->pipelineRecipes[it->second] = recipe;
+			else							  this->pipelineRecipes.push_back(recipe);
+		}
+	}
+	else
+	{
+		this->pipelineRecipes.swap(fresh->pipelineRecipes);
+		this->setLayouts.swap(fresh->setLayouts);
+	}
+
+	this->minor = fresh->minor;
+	this->fileMajor = fresh->fileMajor;
+	this->fileMinor = fresh->fileMinor;
+	delete fresh;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Groups with the same axes only have the masks of the compiled permutations replaced, the other
+	permutations stay as they were. Groups which are new, or whose axes changed, are taken as they are.
+*/
+void
+ShaderEffect::MergePermutationGroups(const ShaderEffect* partial, const std::vector<std::string>& programNames)
+{
+	std::map<std::string, unsigned> indices;
+	unsigned i, j;
+	for (i = 0; i < this->programsByIndex.size(); i++) indices[this->programsByIndex[i]->name] = i;
+
+	for (i = 0; i < partial->permutationGroups.size(); i++)
+	{
+		PermutationGroup group = partial->permutationGroups[i];
+		for (j = 0; j < group.programs.size(); j++)
+		{
+			if (group.programs[j] != UINT_MAX) group.programs[j] = indices[programNames[group.programs[j]]];
+		}
+
+		const unsigned existing = this->FindPermutationGroup(group.name);
+		if (existing == UINT_MAX)
+		{
+			this->permutationGroups.push_back(std::move(group));
+			continue;
+		}
+
+		PermutationGroup& current = this->permutationGroups[existing];
+		bool sameAxes = current.axes.size() == group.axes.size() && current.programs.size() == group.programs.size();
+		for (j = 0; j < current.axes.size() && sameAxes; j++)
+		{
+			const PermutationAxis& a = current.axes[j];
+			const PermutationAxis& b = group.axes[j];
+			sameAxes = a.name == b.name && a.shift == b.shift && a.bits == b.bits && a.flags == b.flags;
+		}
+		if (!sameAxes)
+		{
+			current = std::move(group);
+			continue;
+		}
+		for (j = 0; j < group.programs.size(); j++)
+		{
+			if (group.programs[j] != UINT_MAX) current.programs[j] = group.programs[j];
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderEffect::IsReloadCompatible(const ShaderEffect* other) const
+{
+	if (this->header != other->header || this->major != other->major) return false;
+	if (this->variables.size() != other->variables.size() ||
+		this->varblocks.size() != other->varblocks.size() ||
+		this->varbuffers.size() != other->varbuffers.size() ||
+		this->samplers.size() != other->samplers.size() ||
+		this->subroutines.size() != other->subroutines.size()) return false;
+
+	for (const auto& it : other->variables)
+	{
+		const auto var = this->variables.find(it.first);
+		if (var == this->variables.end()) return false;
+		if (var->second->signature != it.second->signature || var->second->binding != it.second->binding || var->second->set != it.second->set) return false;
+	}
+
+	for (const auto& it : other->varblocks)
+	{
+		const auto block = this->varblocks.find(it.first);
+		if (block == this->varblocks.end() || block->second->signature != it.second->signature) return false;
+	}
+
+	for (const auto& it : other->varbuffers)
+	{
+		const auto buffer = this->varbuffers.find(it.first);
+		if (buffer == this->varbuffers.end()) return false;
+		if (buffer->second->signature != it.second->signature || buffer->second->alignedSize != it.second->alignedSize ||
+			buffer->second->binding != it.second->binding || buffer->second->set != it.second->set ||
+			buffer->second->offsetsByName != it.second->offsetsByName) return false;
+	}
+
+	for (const auto& it : other->samplers)
+	{
+		const auto sampler = this->samplers.find(it.first);
+		if (sampler == this->samplers.end()) return false;
+		if (sampler->second->binding != it.second->binding || sampler->second->set != it.second->set || sampler->second->isStatic != it.second->isStatic ||
+			!SamplerSettingsEqual(sampler->second->samplerSettings, it.second->samplerSettings)) return false;
+	}
+
+	for (const auto& it : other->subroutines)
+	{
+		if (this->subroutines.find(it.first) == this->subroutines.end()) return false;
+	}
+	return true;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
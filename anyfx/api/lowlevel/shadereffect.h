@@ -8,6 +8,7 @@
 //------------------------------------------------------------------------------
 #include <vector>
 #include <string>
+#include <mutex>
 #include "shadertypes.h"
 #include "base/programbase.h"
 #include "base/shaderbase.h"
@@ -19,6 +20,7 @@
 #include "base/subroutinebase.h"
 namespace AnyFX
 {
+class BinReader;
 class ShaderEffect
 {
 public:
@@ -27,16 +29,118 @@ public:
 	/// destructor
 	virtual ~ShaderEffect();
 
+	struct ReloadReport
+	{
+		std::vector<ProgramBase*> changedPrograms;				// programs whose binaries, shaders, render state or layout changed
+		std::vector<ProgramBase*> addedPrograms;
+		std::vector<ProgramBase*> removedPrograms;				// no longer reachable by name, but stay valid until the effect is deleted
+		std::vector<RenderStateBase*> changedRenderStates;
+		std::vector<RenderStateBase*> addedRenderStates;
+		std::vector<RenderStateBase*> removedRenderStates;
+		std::vector<VarblockBase*> changedVarblocks;			// blocks whose binding, set or offsets changed
+	};
+
+	/// reload effect from a compiled buffer in place, keeps the address of every object which still exists, fails if variables, blocks, buffers or samplers were added, removed or retyped
+	bool Reload(const char* data, size_t size, ReloadReport* report = NULL);
+	/// returns true if the effect was compiled from a selection of its programs, reloading one merges it into the full effect
+	bool IsPartial() const;
+
+	struct Statistics
+	{
+		// bytes held by the effect, objects are counted by the size of their base type
+		size_t binaryBytes;							// stage binaries, compressed or not, and shader source
+		size_t nameBytes;							// names, signatures, annotations and messages
+		size_t valueBytes;							// current and default values of variables
+		size_t containerBytes;						// the objects themselves, and the maps and lists holding them
+
+		unsigned numEffects;
+		unsigned numPrograms;						// loaded programs, deferred ones count once they are loaded
+		unsigned numShaders;
+		unsigned numRenderStates;
+		unsigned numVariables;
+		unsigned numVarblocks;
+		unsigned numVarbuffers;
+		unsigned numSamplers;
+		unsigned numSubroutines;
+
+		// seconds spent in each loader, deferred programs are added as they are loaded
+		double shaderLoadTime;
+		double programLoadTime;
+		double renderStateLoadTime;
+		double variableLoadTime;
+		double varblockLoadTime;
+		double varbufferLoadTime;
+		double samplerLoadTime;
+		double subroutineLoadTime;
+		double totalLoadTime;						// the whole stream, including the header, directory and permutation tables
+
+		/// constructor, zeroes everything
+		Statistics();
+		/// add up statistics of another effect
+		Statistics& operator+=(const Statistics& rhs);
+	};
+
+	/// get memory held by the effect and how long loading it took, walks every object so it is not meant to be called per frame
+	Statistics GetStatistics() const;
+
 	/// returns number of programs
 	unsigned GetNumPrograms() const;
 	/// returns program by index
 	ProgramBase* GetProgram(const unsigned i) const;
 	/// returns program by name
 	ProgramBase* GetProgram(const std::string& name) const;
-	/// returns all programs as a list
+	/// returns all programs as a list, this loads all deferred programs
 	const std::vector<ProgramBase*>& GetPrograms() const;
 	/// returns true if program exists
 	bool HasProgram(const std::string& name) const;
+	/// returns true if program has been loaded
+	bool IsProgramLoaded(const unsigned i) const;
+
+	struct PermutationAxis
+	{
+		std::string name;
+		unsigned shift;								// position of the value index in the mask
+		unsigned bits;
+		std::vector<std::string> flags;				// compile flag each value sets, the first value of a switch sets none
+	};
+
+	struct PermutationGroup
+	{
+		std::string name;							// name of the program the permutations were generated from
+		std::vector<PermutationAxis> axes;
+		std::vector<unsigned> programs;				// program index for every mask, UINT_MAX if the mask doesn't denote a permutation
+	};
+
+	/// returns number of permutation groups
+	unsigned GetNumPermutationGroups() const;
+	/// returns permutation group by index
+	const PermutationGroup& GetPermutationGroup(const unsigned i) const;
+	/// returns index of permutation group generated from the named program, or -1 if it doesn't exist
+	const unsigned FindPermutationGroup(const std::string& name) const;
+	/// returns the mask bits which select a value on an axis, the value is either the flag as declared, the value alone, or the axis name to turn a switch on
+	unsigned GetPermutationBits(const unsigned group, const std::string& axis, const std::string& value) const;
+	/// returns program for a mask within permutation group, or NULL if the mask doesn't denote a permutation
+	ProgramBase* GetPermutation(const unsigned group, const unsigned mask) const;
+
+	struct PipelineRecipe
+	{
+		unsigned program;							// program index, the program itself need not be loaded to read the recipe
+		unsigned long long stageHashes[ProgramBase::NumStages];	// hash of each uncompressed stage binary, 0 if the stage is unused
+		unsigned long long renderStateHash;			// hash of the render settings, equal states hash the same whatever their name
+		unsigned long long vertexLayoutHash;		// hash of the vertex input slots, types and packed offsets, 0 if there is no vertex stage
+		unsigned long long pipelineLayoutHash;		// hash of every set layout and the push constant range of the program
+	};
+
+	struct SetLayout
+	{
+		unsigned set;
+		unsigned long long hash;					// hash of the bindings in the set, which every stage sees
+	};
+
+	/// returns what each program needs to create its pipeline, in program order, empty for files older than 2.11
+	const std::vector<PipelineRecipe>& GetPipelineRecipes() const;
+	/// returns layout hash of every set with bindings, ordered by set
+	const std::vector<SetLayout>& GetSetLayouts() const;
 
 	/// returns number of shaders
 	unsigned GetNumShaders() const;
@@ -148,14 +252,39 @@ private:
 	friend class SubroutineLoader;
 	friend class ShaderLoader;
 	friend class SamplerLoader;
+	friend class EffectFactory;
 
+	/// loads deferred program from stream
+	ProgramBase* LoadDeferredProgram(const unsigned i) const;
+	/// returns true if the resource interface of the other effect matches ours, so it can be reloaded in place
+	bool IsReloadCompatible(const ShaderEffect* other) const;
+	/// merge reloaded objects of one kind into ours
+	template <class TYPE, class COMPARE> static void ReloadObjects(
+		std::map<std::string, TYPE*>& objects, std::vector<TYPE*>& objectsByIndex, std::vector<TYPE*>& incoming, std::vector<TYPE*>& retired,
+		std::vector<TYPE*>* changed, std::vector<TYPE*>* added, std::vector<TYPE*>* removed, bool keepMissing, COMPARE hasChanged);
+	/// merge permutation groups of a partial effect into ours, mapping its program indices to ours by name
+	void MergePermutationGroups(const ShaderEffect* partial, const std::vector<std::string>& programNames);
 
 	Implementation header;
 	unsigned major;
 	unsigned minor;
+	unsigned fileMajor;
+	unsigned fileMinor;
+	bool partial;
+	mutable Statistics loadStatistics;			// only the load times are kept up to date
+
+	mutable std::map<std::string, ProgramBase*> programs;
+	mutable std::vector<ProgramBase*> programsByIndex;
 
-	std::map<std::string, ProgramBase*> programs;
-	std::vector<ProgramBase*> programsByIndex;
+	std::vector<PermutationGroup> permutationGroups;
+	std::vector<PipelineRecipe> pipelineRecipes;
+	std::vector<SetLayout> setLayouts;
+
+	BinReader* deferredReader;
+	std::vector<char> deferredData;
+	std::map<std::string, unsigned> deferredProgramIndices;
+	std::vector<unsigned> deferredProgramOffsets;
+	mutable std::mutex deferredLock;
 
 	std::map<std::string, ShaderBase*> shaders;
 	std::vector<ShaderBase*> shadersByIndex;
@@ -180,5 +309,10 @@ private:
 
 	std::map<std::string, SamplerBase*> samplers;
 	std::vector<SamplerBase*> samplersByIndex;
+
+	// objects removed by a reload, kept alive since users may still point to them
+	std::vector<ProgramBase*> retiredPrograms;
+	std::vector<ShaderBase*> retiredShaders;
+	std::vector<RenderStateBase*> retiredRenderStates;
 };
 } // namespace AnyFX
\ No newline at end of file
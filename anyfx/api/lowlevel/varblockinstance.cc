@@ -0,0 +1,237 @@
+//------------------------------------------------------------------------------
+//  varblockinstance.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "varblockinstance.h"
+#include "base/variablebase.h"
+#include <algorithm>
+
+namespace AnyFX
+{
+
+//------------------------------------------------------------------------------
+/**
+	Get columns and rows of a matrix type, returns false for anything else.
+*/
+static bool
+MatrixShape(VariableType type, unsigned& columns, unsigned& rows)
+{
+	if (type < Matrix2x2 || type > Matrix4x4) return false;
+	columns = 2 + (type - Matrix2x2) / 3;
+	rows = 2 + (type - Matrix2x2) % 3;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Matrix columns are laid out like an array of vectors, so std140 pads them to 16 bytes
+	while std430 only pads three component columns.
+*/
+static unsigned
+ColumnStride(unsigned rows, bool std140)
+{
+	return std140 || rows > 2 ? 16 : rows * sizeof(float);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Array elements are padded to 16 bytes in std140, push constant blocks use std430 where they keep their own alignment.
+*/
+static unsigned
+ArrayStride(VariableType type, bool std140)
+{
+	unsigned columns, rows;
+	unsigned size = MatrixShape(type, columns, rows) ? columns * ColumnStride(rows, std140) : TypeToByteSize(type);
+	unsigned alignment = std140 || size > 8 ? 16 : (size > 4 ? 8 : 4);
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Slots reach up to the next variable, so a value may include the padding the layout puts after it.
+	The compiler only records offsets for the unrolled members of a struct, so a struct variable gets
+	a slot spanning all of them, which takes raw bytes in the layout of the block and has no default.
+*/
+VarblockInstance::VarblockInstance(const VarblockBase* varblock) :
+	varblock(varblock),
+	dirtyBegin(0),
+	dirtyEnd(0),
+	committedRing(NULL),
+	committedFrame(0),
+	committedOffset(VarblockRing::InvalidOffset)
+{
+	const std::vector<VariableBase*>& variables = varblock->variables;
+	this->slots.resize(variables.size());
+
+	// promoted push constants have offsets within the push constant range, the block starts at its first variable
+	unsigned base = 0;
+	std::vector<unsigned> sorted;
+	std::map<std::string, unsigned>::const_iterator it;
+	for (it = varblock->offsetsByName.begin(); it != varblock->offsetsByName.end(); it++)
+	{
+		sorted.push_back(it->second);
+	}
+	std::sort(sorted.begin(), sorted.end());
+	if (HasFlags(varblock->qualifiers, Qualifiers::Promoted) && !sorted.empty())
+	{
+		base = sorted.front();
+	}
+
+	const unsigned size = varblock->alignedSize;
+	const bool std140 = !HasFlags(varblock->qualifiers, Qualifiers::Push);
+	this->buffer.resize(size, 0);
+	unsigned i;
+	for (i = 0; i < variables.size(); i++)
+	{
+		const VariableBase* var = variables[i];
+		Slot& slot = this->slots[i];
+
+		// the slot of a struct ends where whatever comes after its last member starts
+		unsigned first, last;
+		bool found = false;
+		bool unrolled = false;
+		it = varblock->offsetsByName.find(var->name);
+		if (it != varblock->offsetsByName.end())
+		{
+			first = last = it->second;
+			found = true;
+		}
+		else
+		{
+			for (it = varblock->offsetsByName.lower_bound(var->name); it != varblock->offsetsByName.end() && it->first.compare(0, var->name.size(), var->name) == 0; it++)
+			{
+				char next = it->first[var->name.size()];
+				if (next != '.' && next != '[') continue;
+				first = found ? std::min(first, it->second) : it->second;
+				last = found ? std::max(last, it->second) : it->second;
+				found = unrolled = true;
+			}
+		}
+		if (!found)
+		{
+			slot.offset = slot.size = slot.stride = 0;
+			continue;
+		}
+
+		slot.offset = first - base;
+		const auto next = std::upper_bound(sorted.begin(), sorted.end(), last);
+		slot.size = (next != sorted.end() ? *next - base : size) - slot.offset;
+		slot.stride = var->isArray ? ArrayStride(var->type, std140) : 0;
+		if (unrolled || var->currentValue == NULL) continue;
+
+		// the current value holds the default, packed without padding between elements or matrix columns
+		unsigned count = var->isArray ? var->arraySize : 1;
+		unsigned columns, rows;
+		if (MatrixShape(var->type, columns, rows) && ColumnStride(rows, std140) != rows * sizeof(float))
+		{
+			const unsigned columnSize = rows * sizeof(float);
+			const unsigned columnStride = ColumnStride(rows, std140);
+			const unsigned elementStride = var->isArray ? slot.stride : columns * columnStride;
+			unsigned element, column;
+			for (element = 0; element < count; element++)
+			{
+				for (column = 0; column < columns; column++)
+				{
+					unsigned dst = element * elementStride + column * columnStride;
+					if (dst + columnSize > slot.size) break;
+					memcpy(this->buffer.data() + slot.offset + dst, var->currentValue + (element * columns + column) * columnSize, columnSize);
+				}
+			}
+		}
+		else
+		{
+			unsigned elementSize = TypeToByteSize(var->type);
+			if (var->isArray) this->SetArray(i, var->currentValue, elementSize, var->arraySize);
+			else			  this->SetBytes(i, var->currentValue, std::min(elementSize, slot.size));
+		}
+	}
+
+	// everything needs to be uploaded the first time
+	this->dirtyBegin = 0;
+	this->dirtyEnd = size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+VarblockInstance::~VarblockInstance()
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+VarblockInstance::GetVariableIndex(const std::string& name) const
+{
+	unsigned i;
+	for (i = 0; i < this->varblock->variables.size(); i++)
+	{
+		if (this->varblock->variables[i]->name == name) return (int)i;
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+VarblockInstance::SetArray(unsigned index, const void* data, unsigned elementSize, unsigned count)
+{
+	assert(index < this->slots.size());
+	const Slot& slot = this->slots[index];
+	if (count == 0) return;
+	if (slot.stride == 0 || slot.stride == elementSize)
+	{
+		this->SetBytes(index, data, elementSize * count);
+		return;
+	}
+
+	assert(elementSize <= slot.stride && (count - 1) * slot.stride + elementSize <= slot.size);
+	const char* src = (const char*)data;
+	char* dst = this->buffer.data() + slot.offset;
+	unsigned i;
+	for (i = 0; i < count; i++)
+	{
+		memcpy(dst + i * slot.stride, src + i * elementSize, elementSize);
+	}
+	this->MarkDirty(slot.offset, slot.offset + (count - 1) * slot.stride + elementSize);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Mapped points to where the block starts in the buffer.
+*/
+void
+VarblockInstance::Flush(void* mapped)
+{
+	if (!this->IsDirty()) return;
+	memcpy((char*)mapped + this->dirtyBegin, this->buffer.data() + this->dirtyBegin, this->dirtyEnd - this->dirtyBegin);
+	this->dirtyBegin = (unsigned)this->buffer.size();
+	this->dirtyEnd = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Mapped points to the start of the ring's buffer. A new range has nothing in it yet, so the whole
+	block is copied, an unchanged block reuses the range it got earlier in the same frame.
+*/
+unsigned
+VarblockInstance::Commit(VarblockRing& ring, void* mapped)
+{
+	if (!this->IsDirty() && this->committedRing == &ring && this->committedFrame == ring.GetFrame()) return this->committedOffset;
+
+	unsigned offset = ring.Allocate((unsigned)this->buffer.size());
+	if (offset == VarblockRing::InvalidOffset) return offset;
+	memcpy((char*)mapped + offset, this->buffer.data(), this->buffer.size());
+
+	this->dirtyBegin = (unsigned)this->buffer.size();
+	this->dirtyEnd = 0;
+	this->committedRing = &ring;
+	this->committedFrame = ring.GetFrame();
+	this->committedOffset = offset;
+	return offset;
+}
+
+} // namespace AnyFX
@@ -0,0 +1,179 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class AnyFX::VarblockInstance
+
+	CPU side copy of a varblock, laid out exactly like the buffer the shader
+	reads, so updating the GPU side is a plain copy.
+
+	Variables are addressed by their index in the varblock, setters copy the
+	value in place and grow the dirty range. The range can then be copied to
+	a buffer which keeps the block at a fixed place, or the whole block is
+	committed to a VarblockRing, which gives the dynamic offset to bind.
+
+	Values are copied as they are given, they must already be in the layout
+	of the block. That is the natural one for everything but matrices with
+	less than 4 rows, whose columns are padded. Defaults are padded when the
+	instance is created. A struct variable takes the bytes of all its members
+	at once.
+
+	(C) 2019 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "base/varblockbase.h"
+#include "varblockring.h"
+#include <vector>
+#include <string.h>
+#include <assert.h>
+namespace AnyFX
+{
+class VarblockInstance
+{
+public:
+	/// constructor, starts out with the default values of the variables
+	VarblockInstance(const VarblockBase* varblock);
+	/// destructor
+	~VarblockInstance();
+
+	/// get varblock this is an instance of
+	const VarblockBase* GetVarblock() const;
+	/// get index of variable by name, returns -1 if the block has no such variable
+	int GetVariableIndex(const std::string& name) const;
+
+	/// set value of variable
+	template <class TYPE> void Set(unsigned index, const TYPE& value);
+	/// set boolean, which is 4 bytes in the shader
+	void SetBool(unsigned index, bool value);
+	/// set elements of array variable, each element is elementSize bytes in data
+	void SetArray(unsigned index, const void* data, unsigned elementSize, unsigned count);
+	/// set raw bytes of variable
+	void SetBytes(unsigned index, const void* data, unsigned size);
+
+	/// get shadow buffer
+	const char* GetData() const;
+	/// get size of shadow buffer
+	unsigned GetSize() const;
+
+	/// returns true if anything changed since the last flush or commit
+	bool IsDirty() const;
+	/// get range that changed since the last flush or commit, end is exclusive
+	void GetDirtyRange(unsigned& begin, unsigned& end) const;
+	/// copy the changed range to a mapped buffer holding this block, and clear the dirty range
+	void Flush(void* mapped);
+	/// copy the block to a new range of the ring unless it is unchanged this frame, returns the dynamic offset or InvalidOffset if the ring is full
+	unsigned Commit(VarblockRing& ring, void* mapped);
+
+private:
+
+	struct Slot
+	{
+		unsigned offset;
+		unsigned size;
+		unsigned stride;		// array element stride, 0 if not an array
+	};
+
+	/// mark range as changed
+	void MarkDirty(unsigned begin, unsigned end);
+
+	const VarblockBase* varblock;
+	std::vector<char> buffer;
+	std::vector<Slot> slots;
+	unsigned dirtyBegin;
+	unsigned dirtyEnd;
+
+	const VarblockRing* committedRing;
+	unsigned long long committedFrame;
+	unsigned committedOffset;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const VarblockBase*
+VarblockInstance::GetVarblock() const
+{
+	return this->varblock;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+VarblockInstance::Set(unsigned index, const TYPE& value)
+{
+	this->SetBytes(index, &value, sizeof(TYPE));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+VarblockInstance::SetBool(unsigned index, bool value)
+{
+	unsigned word = value ? 1 : 0;
+	this->SetBytes(index, &word, sizeof(word));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+VarblockInstance::SetBytes(unsigned index, const void* data, unsigned size)
+{
+	assert(index < this->slots.size());
+	const Slot& slot = this->slots[index];
+	assert(size <= slot.size);
+	memcpy(this->buffer.data() + slot.offset, data, size);
+	this->MarkDirty(slot.offset, slot.offset + size);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const char*
+VarblockInstance::GetData() const
+{
+	return this->buffer.data();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+VarblockInstance::GetSize() const
+{
+	return (unsigned)this->buffer.size();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+VarblockInstance::IsDirty() const
+{
+	return this->dirtyBegin < this->dirtyEnd;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+VarblockInstance::GetDirtyRange(unsigned& begin, unsigned& end) const
+{
+	begin = this->dirtyBegin;
+	end = this->dirtyEnd;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+VarblockInstance::MarkDirty(unsigned begin, unsigned end)
+{
+	if (begin < this->dirtyBegin) this->dirtyBegin = begin;
+	if (end > this->dirtyEnd) this->dirtyEnd = end;
+}
+
+} // namespace AnyFX
+//------------------------------------------------------------------------------
@@ -0,0 +1,70 @@
+//------------------------------------------------------------------------------
+//  varblockring.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "varblockring.h"
+#include <assert.h>
+
+namespace AnyFX
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+VarblockRing::VarblockRing(unsigned size, unsigned alignment, unsigned numFrames) :
+	size(size),
+	alignment(alignment),
+	head(0),
+	tail(0),
+	frame(0),
+	frameEnds(numFrames, 0)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	assert(size % alignment == 0);
+	assert(numFrames != 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+VarblockRing::~VarblockRing()
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+	A range never crosses the end of the buffer, if it doesn't fit the rest is skipped and it starts over at 0.
+*/
+unsigned
+VarblockRing::Allocate(unsigned size)
+{
+	if (size > this->size) return InvalidOffset;
+
+	unsigned long long position = this->head % this->size;
+	unsigned long long aligned = (position + this->alignment - 1) & ~(unsigned long long)(this->alignment - 1);
+	unsigned long long start;
+	if (aligned + size > this->size)	start = this->head + (this->size - position);
+	else								start = this->head + (aligned - position);
+
+	if (start + size - this->tail > this->size) return InvalidOffset;
+	this->head = start + size;
+	return (unsigned)(start % this->size);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+VarblockRing::NextFrame()
+{
+	unsigned index = (unsigned)(this->frame % this->frameEnds.size());
+	this->frameEnds[index] = this->head;
+	this->frame++;
+
+	// the slot we move into was last written by the oldest frame in flight, which is done now
+	index = (unsigned)(this->frame % this->frameEnds.size());
+	this->tail = this->frameEnds[index];
+}
+
+} // namespace AnyFX
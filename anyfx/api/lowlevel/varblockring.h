@@ -0,0 +1,84 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class AnyFX::VarblockRing
+
+	Linear allocator over a buffer which is used as a ring, handing out the
+	dynamic offsets varblock instances are bound at.
+
+	Allocations are made one after another and wrap around at the end of the
+	buffer, they are released a whole frame at a time. The buffer is shared
+	by the frames the GPU may still be reading, so NextFrame must only be
+	called once the frame submitted that many frames ago has finished.
+
+	Not thread safe, use one ring per recording thread.
+
+	(C) 2019 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <vector>
+namespace AnyFX
+{
+class VarblockRing
+{
+public:
+	/// constructor, alignment must be a power of two which size is a multiple of
+	VarblockRing(unsigned size, unsigned alignment, unsigned numFrames);
+	/// destructor
+	~VarblockRing();
+
+	/// returned by Allocate if the ring is full
+	static const unsigned InvalidOffset = 0xFFFFFFFF;
+
+	/// allocate aligned range, returns its offset in the buffer or InvalidOffset if there is no room until older frames are done
+	unsigned Allocate(unsigned size);
+	/// start a new frame, which releases everything allocated during the frame that many frames back
+	void NextFrame();
+
+	/// get the number of frames started so far, allocations made in the same frame stay valid
+	unsigned long long GetFrame() const;
+	/// get the size of the buffer
+	unsigned GetSize() const;
+	/// get the offset alignment
+	unsigned GetAlignment() const;
+
+private:
+	unsigned size;
+	unsigned alignment;
+
+	// positions count bytes since creation, so the ring is full when head and tail are a whole buffer apart
+	unsigned long long head;
+	unsigned long long tail;
+	unsigned long long frame;
+	std::vector<unsigned long long> frameEnds;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned long long
+VarblockRing::GetFrame() const
+{
+	return this->frame;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+VarblockRing::GetSize() const
+{
+	return this->size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+VarblockRing::GetAlignment() const
+{
+	return this->alignment;
+}
+
+} // namespace AnyFX
+//------------------------------------------------------------------------------
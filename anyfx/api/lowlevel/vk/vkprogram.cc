@@ -3,16 +3,50 @@
 // (C) 2016 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "vkprogram.h"
+#include <string.h>
+#include <algorithm>
 
 namespace AnyFX
 {
 
+struct VertexFormat
+{
+	VkFormat format;
+	uint32_t size;
+};
+
+static const VertexFormat vkVertexFormatTable[] =
+{
+	{ VK_FORMAT_R32_SFLOAT, 4 },						// Float
+	{ VK_FORMAT_R32G32_SFLOAT, 8 },						// Float2
+	{ VK_FORMAT_R32G32B32_SFLOAT, 12 },					// Float3
+	{ VK_FORMAT_R32G32B32A32_SFLOAT, 16 },				// Float4
+	{ VK_FORMAT_R64_SFLOAT, 8 },						// Double
+	{ VK_FORMAT_R64G64_SFLOAT, 16 },					// Double2
+	{ VK_FORMAT_R64G64B64_SFLOAT, 24 },					// Double3
+	{ VK_FORMAT_R64G64B64A64_SFLOAT, 32 },				// Double4
+	{ VK_FORMAT_R32_SINT, 4 },							// Integer
+	{ VK_FORMAT_R32G32_SINT, 8 },						// Integer2
+	{ VK_FORMAT_R32G32B32_SINT, 12 },					// Integer3
+	{ VK_FORMAT_R32G32B32A32_SINT, 16 },				// Integer4
+	{ VK_FORMAT_R32_UINT, 4 },							// UInteger
+	{ VK_FORMAT_R32G32_UINT, 8 },						// UInteger2
+	{ VK_FORMAT_R32G32B32_UINT, 12 },					// UInteger3
+	{ VK_FORMAT_R32G32B32A32_UINT, 16 },				// UInteger4
+	{ VK_FORMAT_R16_SINT, 4 },							// Short, padded to 4 bytes like the compiler does
+	{ VK_FORMAT_R16G16_SINT, 4 },						// Short2
+	{ VK_FORMAT_R16G16B16_SINT, 8 },					// Short3
+	{ VK_FORMAT_R16G16B16A16_SINT, 8 },					// Short4
+};
+
 //------------------------------------------------------------------------------
 /**
 */
 VkProgram::VkProgram()
 {
-	// empty
+	memset(&this->specializationInfo, 0, sizeof(this->specializationInfo));
+	memset(&this->pushConstantRange, 0, sizeof(this->pushConstantRange));
+	this->vertexStride = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -23,4 +57,133 @@ VkProgram::~VkProgram()
 	// empty
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+VkProgram::OnLoaded()
+{
+	this->SetupSpecializationInfo();
+	this->SetupPushConstantRange();
+	this->SetupVertexAttributes();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+VkProgram::Swap(ProgramBase* other)
+{
+	ProgramBase::Swap(other);
+	this->SetupSpecializationInfo();
+	this->SetupPushConstantRange();
+	this->SetupVertexAttributes();
+	static_cast<VkProgram*>(other)->SetupSpecializationInfo();
+	static_cast<VkProgram*>(other)->SetupPushConstantRange();
+	static_cast<VkProgram*>(other)->SetupVertexAttributes();
+}
+
+//------------------------------------------------------------------------------
+/**
+	All stages share the same map, constants a stage doesn't declare are ignored by the driver.
+*/
+void
+VkProgram::SetupSpecializationInfo()
+{
+	this->specializationEntries.resize(this->specializationIds.size());
+	unsigned i;
+	for (i = 0; i < this->specializationIds.size(); i++)
+	{
+		VkSpecializationMapEntry& entry = this->specializationEntries[i];
+		entry.constantID = this->specializationIds[i];
+		entry.offset = i * sizeof(unsigned);
+		entry.size = sizeof(unsigned);
+	}
+
+	this->specializationInfo.mapEntryCount = (uint32_t)this->specializationEntries.size();
+	this->specializationInfo.pMapEntries = this->specializationEntries.empty() ? NULL : this->specializationEntries.data();
+	this->specializationInfo.dataSize = this->specializationValues.size() * sizeof(unsigned);
+	this->specializationInfo.pData = this->specializationValues.empty() ? NULL : this->specializationValues.data();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Which stage reads which member isn't recorded, so every stage of the program gets the range.
+*/
+void
+VkProgram::SetupPushConstantRange()
+{
+	this->pushConstantRange.offset = this->pushConstantOffset;
+	this->pushConstantRange.size = this->pushConstantSize;
+	this->pushConstantRange.stageFlags = 0;
+	if (this->pushConstantSize == 0) return;
+
+	if (this->shaderBlock.vs != NULL) this->pushConstantRange.stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+	if (this->shaderBlock.hs != NULL) this->pushConstantRange.stageFlags |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+	if (this->shaderBlock.ds != NULL) this->pushConstantRange.stageFlags |= VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	if (this->shaderBlock.gs != NULL) this->pushConstantRange.stageFlags |= VK_SHADER_STAGE_GEOMETRY_BIT;
+	if (this->shaderBlock.ps != NULL) this->pushConstantRange.stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+	if (this->shaderBlock.cs != NULL) this->pushConstantRange.stageFlags |= VK_SHADER_STAGE_COMPUTE_BIT;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Array inputs take one location per element. Matrices and the other types vertex buffers
+	can't provide have no format, the engine has to describe those itself.
+*/
+void
+VkProgram::SetupVertexAttributes()
+{
+	this->vertexAttributes.clear();
+	this->vertexStride = this->vsInputStride;
+
+	unsigned i;
+	for (i = 0; i < this->vsInputTypes.size(); i++)
+	{
+		VariableType type = this->vsInputTypes[i];
+		if (type < Float || type > Short4) continue;
+		const VertexFormat& format = vkVertexFormatTable[type];
+
+		unsigned j;
+		for (j = 0; j < this->vsInputArraySizes[i]; j++)
+		{
+			VkVertexInputAttributeDescription attribute;
+			attribute.location = this->vsInputSlots[i] + j;
+			attribute.binding = 0;
+			attribute.format = format.format;
+			attribute.offset = this->vsInputOffsets[i] + j * format.size;
+			this->vertexAttributes.push_back(attribute);
+		}
+	}
+
+	std::sort(this->vertexAttributes.begin(), this->vertexAttributes.end(), [](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b)
+	{
+		return a.location < b.location;
+	});
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+VkProgram::IsVertexLayoutCompatible(const VkVertexInputAttributeDescription* attributes, uint32_t numAttributes) const
+{
+	// index the given formats by location, so each input is a single lookup
+	static const uint32_t MaxLocations = 64;
+	VkFormat formats[MaxLocations];
+	uint32_t i;
+	for (i = 0; i < MaxLocations; i++) formats[i] = VK_FORMAT_UNDEFINED;
+	for (i = 0; i < numAttributes; i++)
+	{
+		if (attributes[i].location < MaxLocations) formats[attributes[i].location] = attributes[i].format;
+	}
+
+	for (i = 0; i < this->vertexAttributes.size(); i++)
+	{
+		const VkVertexInputAttributeDescription& attribute = this->vertexAttributes[i];
+		if (attribute.location >= MaxLocations || formats[attribute.location] != attribute.format) return false;
+	}
+	return true;
+}
+
 } // namespace AnyFX
\ No newline at end of file
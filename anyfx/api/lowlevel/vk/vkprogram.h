@@ -7,6 +7,7 @@
 */
 //------------------------------------------------------------------------------
 #include "base/programbase.h"
+#include <vulkan/vulkan.h>
 namespace AnyFX
 {
 struct VkProgram : public ProgramBase
@@ -16,9 +17,33 @@ public:
 	VkProgram();
 	/// destructor
 	virtual ~VkProgram();
+
+	// specialization info for every stage of the pipeline, empty if the program sets no specialization constants
+	std::vector<VkSpecializationMapEntry> specializationEntries;
+	VkSpecializationInfo specializationInfo;
+
+	// push constant range for the pipeline layout, size is 0 if the program uses no push constants
+	VkPushConstantRange pushConstantRange;
+
+	// vertex attributes sorted by location, laid out as a single tightly packed vertex in binding 0, inputs without a vertex format are left out
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+	uint32_t vertexStride;
+
+	/// returns true if the attributes feed every vertex shader input with its format, offsets and bindings are up to the caller
+	bool IsVertexLayoutCompatible(const VkVertexInputAttributeDescription* attributes, uint32_t numAttributes) const;
 	
 private:
 	/// handle loading
 	void OnLoadingDone();
+	/// callback for when program is done loading
+	virtual void OnLoaded();
+	/// swap contents with a reloaded program, the specialization info points into the swapped values so it is rebuilt
+	virtual void Swap(ProgramBase* other);
+	/// build specialization entries and info from the loaded values
+	void SetupSpecializationInfo();
+	/// build push constant range from the loaded range and the stages in use
+	void SetupPushConstantRange();
+	/// build vertex attributes from the vertex shader inputs
+	void SetupVertexAttributes();
 };
-} // namespace AnyFX
\ No newline at end of file
+} // namespace AnyFX
@@ -3,6 +3,9 @@
 // (C) 2016 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "vksampler.h"
+#include <map>
+#include <mutex>
+#include <tuple>
 
 namespace AnyFX
 {
@@ -75,8 +78,28 @@ static const VkFilter vkMagTable[] =
 
 //------------------------------------------------------------------------------
 /**
+	Orders settings so equal samplers end up in the same object
 */
-VkSampler::VkSampler()
+struct SamplerSettingsLess
+{
+	bool operator()(const SamplerBase::SamplerSettings& a, const SamplerBase::SamplerSettings& b) const
+	{
+		return std::tie(a.filterMode, a.addressU, a.addressV, a.addressW, a.comparisonFunc, a.isComparison, a.minLod, a.maxLod, a.lodBias, a.maxAnisotropic,
+			a.borderColor[0], a.borderColor[1], a.borderColor[2], a.borderColor[3]) <
+			std::tie(b.filterMode, b.addressU, b.addressV, b.addressW, b.comparisonFunc, b.isComparison, b.minLod, b.maxLod, b.lodBias, b.maxAnisotropic,
+			b.borderColor[0], b.borderColor[1], b.borderColor[2], b.borderColor[3]);
+	}
+};
+
+typedef std::map<SamplerBase::SamplerSettings, ::VkSampler, SamplerSettingsLess> ImmutableSamplerTable;
+static std::map<VkDevice, ImmutableSamplerTable> immutableSamplers;
+static std::mutex immutableSamplerLock;
+
+//------------------------------------------------------------------------------
+/**
+*/
+VkSampler::VkSampler() :
+	immutableSampler(VK_NULL_HANDLE)
 {
 	// empty
 }
@@ -124,4 +147,46 @@ VkSampler::OnLoaded()
 	this->bindingLayout.pImmutableSamplers = VK_NULL_HANDLE;
 }
 
+//------------------------------------------------------------------------------
+/**
+	Returns false if the sampler isn't static or the object couldn't be created, the binding
+	layout then stays a regular sampler descriptor which has to be written to the set.
+*/
+bool
+VkSampler::SetupImmutableSampler(VkDevice device, PFN_vkCreateSampler createFunc)
+{
+	if (!this->isStatic) return false;
+	if (this->immutableSampler == VK_NULL_HANDLE)
+	{
+		std::lock_guard<std::mutex> lock(immutableSamplerLock);
+		ImmutableSamplerTable& table = immutableSamplers[device];
+		auto it = table.find(this->samplerSettings);
+		if (it == table.end())
+		{
+			::VkSampler sampler;
+			if (createFunc(device, &this->samplerInfo, NULL, &sampler) != VK_SUCCESS) return false;
+			it = table.emplace(this->samplerSettings, sampler).first;
+		}
+		this->immutableSampler = it->second;
+	}
+	this->bindingLayout.pImmutableSamplers = &this->immutableSampler;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+VkSampler::DiscardImmutableSamplers(VkDevice device, PFN_vkDestroySampler destroyFunc)
+{
+	std::lock_guard<std::mutex> lock(immutableSamplerLock);
+	auto table = immutableSamplers.find(device);
+	if (table == immutableSamplers.end()) return;
+	for (auto& it : table->second)
+	{
+		destroyFunc(device, it.second, NULL);
+	}
+	immutableSamplers.erase(table);
+}
+
 } // namespace AnyFX
\ No newline at end of file
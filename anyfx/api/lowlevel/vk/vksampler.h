@@ -2,6 +2,11 @@
 //------------------------------------------------------------------------------
 /**
 	Describes a basic sampler object.
+
+	Static samplers can be baked into the descriptor set layout, which
+	spares the engine writing them with every set it allocates. The runtime
+	doesn't own a device, so the caller provides one along with the entry
+	points to create and destroy the sampler objects.
 	
 	(C) 2016 Individual contributors, see AUTHORS file
 */
@@ -18,8 +23,14 @@ public:
 	/// destructor
 	virtual ~VkSampler();
 
+	/// use a sampler object with these settings as immutable sampler in the binding layout, objects are shared between all samplers with equal settings on the device
+	bool SetupImmutableSampler(VkDevice device, PFN_vkCreateSampler createFunc);
+	/// destroy all sampler objects created for device, samplers using them must not be used afterwards
+	static void DiscardImmutableSamplers(VkDevice device, PFN_vkDestroySampler destroyFunc);
+
 	VkSamplerCreateInfo samplerInfo;
 	VkDescriptorSetLayoutBinding bindingLayout;
+	::VkSampler immutableSampler;
 private:
 
 	/// callback for when program is done loading
@@ -39,9 +39,10 @@ VkVarblock::OnLoaded()
 	snprintf(buf, sizeof(buf), "[%d-%d]", this->set, this->binding);
 	this->signature += buf;
 
+	// push constants are not bound through a descriptor, so the binding is left empty
 	this->bindingLayout.binding = this->binding;
 	this->bindingLayout.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	this->bindingLayout.descriptorCount = 1;
+	this->bindingLayout.descriptorCount = HasFlags(this->qualifiers, Qualifiers::Push) ? 0 : 1;
 	this->bindingLayout.stageFlags = VK_SHADER_STAGE_ALL;
 	this->bindingLayout.pImmutableSamplers = VK_NULL_HANDLE;
 }
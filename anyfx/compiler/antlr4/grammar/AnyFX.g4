@@ -56,7 +56,7 @@ options
 		UpdateLine(stream, -1);
 
 		// assume the previous token is the latest file
-		auto tu2 = this->lines[this->currentLine];
+		const auto& tu2 = this->lines[this->currentLine];
 		comp->SetLine(lineOffset);
 		comp->SetPosition(token->getCharPositionInLine());
 		comp->SetFile(std::get<4>(tu2));
@@ -67,28 +67,16 @@ options
 	{
 		::AnyFXToken* token = (::AnyFXToken*)stream->LT(index);
 
-		// find the next parsed row which comes after the token
-		int loop = this->currentLine;
+		// the table is in source order, so the directive for the token is found by binary search
 		int tokenLine = token->getLine();
-		while (loop < this->lines.size() - 1)
-		{
-			auto temp = this->lines[loop];
-			if (std::get<1>(temp) > tokenLine)
-			{
-				loop--;
-				break;
-			}
-			loop++;
-		}
-
-		this->currentLine = loop;
-		auto tu2 = this->lines[this->currentLine];
+		this->currentLine = AnyFXFindLine(this->lines, tokenLine);
+		const auto& tu2 = this->lines[this->currentLine];
 		this->lineOffset = std::get<0>(tu2) + tokenLine;
 	}
 
 	int currentLine = 0;
 	int lineOffset = 0;
-	std::vector<std::tuple<int, size_t, size_t, size_t, std::string>> lines;
+	std::vector<AnyFXLine> lines;
 }
 
 // parser includes
@@ -105,6 +93,7 @@ options
 extern std::vector<std::string> uncaughtPreprocessorDirectives;
 
 #include "AnyFXToken.h"
+#include "anyfxlines.h"
 #include "../../code/qualifierexpression.h"
 #include "../../code/compileable.h"
 #include "../../code/effect.h"
@@ -174,7 +163,7 @@ entry		returns [ Effect returnEffect ]
 	{ 
 		$effect.eff.SetPreprocessorPassthrough(uncaughtPreprocessorDirectives);
 		uncaughtPreprocessorDirectives.clear();
-		$returnEffect = $effect.eff; 
+		$returnEffect = std::move($effect.eff); 
 	} EOF
 	;
 	
@@ -182,16 +171,16 @@ entry		returns [ Effect returnEffect ]
 effect	returns [ Effect eff ]
 	:  
 		(
-			constant { $eff.AddConstant($constant.cons);}
-			| variable { $eff.AddVariable($variable.var); } 
-			| renderState { $eff.AddRenderState($renderState.state); }
-			| function { $eff.AddFunction($function.func); }
-			| program { $eff.AddProgram($program.prog); }
-			| structure { $eff.AddStructure($structure.struc); }
-			| varblock { $eff.AddVarBlock($varblock.block); }
-			| varbuffer { $eff.AddVarBuffer($varbuffer.buffer); }
-			| subroutine { $eff.AddSubroutine($subroutine.subrout); }
-			| sampler { $eff.AddSampler($sampler.samp); }
+			constant { $eff.AddConstant(std::move($constant.cons));}
+			| variable { $eff.AddVariable(std::move($variable.var)); } 
+			| renderState { $eff.AddRenderState(std::move($renderState.state)); }
+			| function { $eff.AddFunction(std::move($function.func)); }
+			| program { $eff.AddProgram(std::move($program.prog)); }
+			| structure { $eff.AddStructure(std::move($structure.struc)); }
+			| varblock { $eff.AddVarBlock(std::move($varblock.block)); }
+			| varbuffer { $eff.AddVarBuffer(std::move($varbuffer.buffer)); }
+			| subroutine { $eff.AddSubroutine(std::move($subroutine.subrout)); }
+			| sampler { $eff.AddSampler(std::move($sampler.samp)); }
 		)*?
 	;
 
@@ -10,10 +10,13 @@
 #include "typechecker.h"
 #include "generator.h"
 #include "header.h"
+#include "compilearena.h"
 #include <fstream>
 #include <algorithm>
 #include <locale>
 #include <iostream>
+#include <chrono>
+#include <cstdarg>
 
 #include "antlr4-runtime.h"
 #include "antlr4-common.h"
@@ -21,6 +24,8 @@
 #include "parser4/AnyFXParser.h"
 #include "parser4/AnyFXBaseListener.h"
 #include "parser4/anyfxerrorhandlers.h"
+#include "parser4/anyfxscanner.h"
+#include "parser4/anyfxbytestream.h"
 
 using namespace antlr4;
 
@@ -79,9 +84,88 @@ AnyFXWinProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
 //------------------------------------------------------------------------------
 /**
+	Measures the time between laps, used to time compile phases
+*/
+struct PhaseTimer
+{
+	std::chrono::steady_clock::time_point last;
+
+	// constructor
+	PhaseTimer() :
+		last(std::chrono::steady_clock::now())
+	{
+		// empty
+	}
+
+	// returns seconds since last lap and starts a new one
+	double Lap()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - this->last).count();
+		this->last = now;
+		return seconds;
+	}
+};
+
+// where mcpp output goes while AnyFXPreprocess runs, mcpp is not reentrant so one of each will do
+static std::string* preprocessOutput = NULL;
+static std::string* preprocessMessages = NULL;
+
+//------------------------------------------------------------------------------
+/**
+	The preprocessed source is appended to the caller's string instead of mcpp's own memory
+	buffer, which grows by a fixed amount at a time and would have to be copied out again.
+	Diagnostics are collected separately.
+*/
+static int
+AnyFXPreprocessPutc(int c, OUTDEST od)
+{
+	std::string* dest = od == OUT ? preprocessOutput : preprocessMessages;
+	dest->push_back((char)c);
+	return c;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static int
+AnyFXPreprocessPuts(const char* s, OUTDEST od)
+{
+	std::string* dest = od == OUT ? preprocessOutput : preprocessMessages;
+	dest->append(s);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static int
+AnyFXPreprocessPrintf(OUTDEST od, const char* format, ...)
+{
+	std::string* dest = od == OUT ? preprocessOutput : preprocessMessages;
+	va_list args;
+	va_start(args, format);
+	va_list copy;
+	va_copy(copy, args);
+	int length = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+	if (length > 0)
+	{
+		size_t start = dest->size();
+		dest->resize(start + length + 1);
+		vsnprintf(&(*dest)[start], length + 1, format, args);
+		dest->resize(start + length);
+	}
+	va_end(args);
+	return length;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Output receives the preprocessed source, errors receives whatever mcpp reports.
 */
 bool
-AnyFXPreprocess(const std::string& file, const std::vector<std::string>& defines, const std::string& vendor, std::string& output)
+AnyFXPreprocess(const std::string& file, const std::vector<std::string>& defines, const std::string& vendor, std::string& output, std::string& errors)
 {
     std::string fileName = file.substr(file.rfind("/")+1, file.length()-1);
 	std::string vend = "-DVENDOR=" + vendor;
@@ -105,21 +189,18 @@ AnyFXPreprocess(const std::string& file, const std::vector<std::string>& defines
     }
     args[numTotalArgs-1] = file.c_str();
 
-	// run preprocessing
-    mcpp_use_mem_buffers(1);
+	// run preprocessing, the output functions are set back so dependency generation gets the memory buffers again
+	preprocessOutput = &output;
+	preprocessMessages = &errors;
+	mcpp_use_mem_buffers(1);	// clear mcpp
+	mcpp_set_out_func(AnyFXPreprocessPutc, AnyFXPreprocessPuts, AnyFXPreprocessPrintf);
     int result = mcpp_lib_main(numTotalArgs, (char**)args);
-    if (result != 0)
-    {
-        delete[] args;
-        return false;
-    }
-    else
-    {
-        char* preprocessed = mcpp_get_mem_buffer((OUTDEST)0);
-        output.append(preprocessed);
-		delete[] args;
-        return true;
-    }
+	mcpp_reset_def_out_func();
+	preprocessOutput = NULL;
+	preprocessMessages = NULL;
+	delete[] args;
+
+	return result == 0;
 }
 
 //------------------------------------------------------------------------------
@@ -178,6 +259,65 @@ AnyFXGenerateDependencies(const std::string& file, const std::vector<std::string
 	return res;
 }
 
+//------------------------------------------------------------------------------
+/**
+	Collects lexer errors so the scanner can be compared against the generated lexer.
+*/
+class LexCheckListener : public BaseErrorListener
+{
+public:
+	virtual void syntaxError(Recognizer* recognizer, Token* offendingSymbol, size_t line, size_t charPositionInLine, const std::string& msg, std::exception_ptr e) override
+	{
+		this->errors.push_back(Format("%d:%d %s", (int)line, (int)charPositionInLine, msg.c_str()));
+	}
+
+	std::vector<std::string> errors;
+};
+
+//------------------------------------------------------------------------------
+/**
+	Runs the generated lexer and the scanner over the same source, returns false and
+	the line and a description of the first difference in the tokens or errors they produce.
+	The lexer indexes its tokens by code point and the scanner by byte, so their text is compared instead.
+*/
+static bool
+AnyFXCheckScanner(const std::string& source, size_t& line, std::string& difference)
+{
+	ANTLRInputStream input;
+	input.load(source);
+	AnyFXLexer lexer(&input);
+	lexer.setTokenFactory(AnyFXTokenFactory::DEFAULT);
+	lexer.removeErrorListeners();
+	LexCheckListener lexerErrors;
+	lexer.addErrorListener(&lexerErrors);
+
+	AnyFXByteStream bytes(source.data(), source.size());
+	AnyFXScanner scanner(source.data(), source.size(), &bytes);
+	LexCheckListener scannerErrors;
+	scanner.addErrorListener(&scannerErrors);
+
+	while (true)
+	{
+		std::unique_ptr<Token> expected = lexer.nextToken();
+		std::unique_ptr<Token> actual = scanner.nextToken();
+		if (expected->getType() != actual->getType() || expected->getChannel() != actual->getChannel() || expected->getText() != actual->getText()
+			|| expected->getLine() != actual->getLine() || expected->getCharPositionInLine() != actual->getCharPositionInLine())
+		{
+			line = expected->getLine();
+			difference = Format("scanner produced %s, lexer produced %s", actual->toString().c_str(), expected->toString().c_str());
+			return false;
+		}
+		if (lexerErrors.errors != scannerErrors.errors)
+		{
+			line = expected->getLine();
+			difference = "scanner and lexer report different errors before " + expected->toString();
+			return false;
+		}
+		if (expected->getType() == Token::EOF) break;
+	}
+	return true;
+}
+
 //------------------------------------------------------------------------------
 /**
     Compiles AnyFX effect.
@@ -188,22 +328,32 @@ AnyFXGenerateDependencies(const std::string& file, const std::vector<std::string
 	@param vendor		GPU vendor name
     @param defines		List of preprocessor definitions
     @param errorBuffer	Buffer containing errors, created in function but must be deleted manually
+	@param timings		Optional, receives time spent in each phase
 */
 bool
-AnyFXCompile(const std::string& file, const std::string& output, const std::string& header_output, const std::string& target, const std::string& vendor, const std::vector<std::string>& defines, const std::vector<std::string>& flags, AnyFXErrorBlob** errorBuffer)
+AnyFXCompile(const std::string& file, const std::string& output, const std::string& header_output, const std::string& target, const std::string& vendor, const std::vector<std::string>& defines, const std::vector<std::string>& flags, AnyFXErrorBlob** errorBuffer, AnyFXCompileTimings* timings)
 {
+	// the parser allocates the AST from the arena, declare it first so it outlives the parser and the effect
+	CompileArena arena;
+	CompileArena::SetCurrent(&arena);
+
     std::string preprocessed;
+	std::string preprocessErrors;
     (*errorBuffer) = NULL;
+	AnyFXCompileTimings localTimings;
+	if (timings == NULL) timings = &localTimings;
+	*timings = AnyFXCompileTimings();
+	PhaseTimer timer;
 
     // if preprocessor is successful, continue parsing the actual code
-	if (AnyFXPreprocess(file, defines, vendor, preprocessed))
+	bool preprocessSuccess = AnyFXPreprocess(file, defines, vendor, preprocessed, preprocessErrors);
+	timings->preprocess = timer.Lap();
+	if (preprocessSuccess)
     {
-		ANTLRInputStream input;
-		input.load(preprocessed);
-
-		AnyFXLexer lexer(&input);
-		lexer.setTokenFactory(AnyFXTokenFactory::DEFAULT);
-		CommonTokenStream tokens(&lexer);
+		// tokens read their text straight out of the preprocessed source, which is the only copy of it
+		AnyFXByteStream input(preprocessed.data(), preprocessed.size(), file);
+		AnyFXScanner directiveScanner(preprocessed.data(), preprocessed.size(), &input);
+		CommonTokenStream tokens(&directiveScanner);
 		AnyFXParser parser(&tokens);
 
 		// get the name of the shader
@@ -223,14 +373,14 @@ AnyFXCompile(const std::string& file, const std::string& output, const std::stri
 		// setup preprocessor
 		parser.preprocess();
 
-		// remove all preprocessor crap left by mcpp
+		// remove all preprocessor crap left by mcpp, blanked in place so line numbers and offsets stay the same
 		size_t i;
 		for (i = 0; i < parser.lines.size(); i++)
 		{
 			size_t start = std::get<2>(parser.lines[i]);
 			size_t stop = preprocessed.find('\n', start);
-			std::string fill(stop - start, ' ');
-			preprocessed.replace(start, stop - start, fill);
+			if (stop == std::string::npos) stop = preprocessed.size();
+			std::fill(preprocessed.begin() + start, preprocessed.begin() + stop, ' ');
 		}
 
 		AnyFXLexerHandler lexerErrorHandler;
@@ -238,18 +388,27 @@ AnyFXCompile(const std::string& file, const std::string& output, const std::stri
 		AnyFXParserHandler parserErrorHandler;
 		parserErrorHandler.lines = parser.lines;
 
-		// reload the preprocessed data
-		input.reset();
-		input.load(preprocessed);
-		lexer.setInputStream(&input);
-		lexer.setTokenFactory(AnyFXTokenFactory::DEFAULT);
-		lexer.addErrorListener(&lexerErrorHandler);
-		tokens.setTokenSource(&lexer);
+		// scan the blanked source again, the stream sees the change since it doesn't copy
+		AnyFXScanner scanner(preprocessed.data(), preprocessed.size(), &input);
+		scanner.addErrorListener(&lexerErrorHandler);
+		tokens.setTokenSource(&scanner);
 		parser.setTokenStream(&tokens);
 		parser.addErrorListener(&parserErrorHandler);
 
+		// compare the scanner to the generated lexer it replaces
+		if (std::find(flags.begin(), flags.end(), "/LEXCHECK") != flags.end())
+		{
+			size_t line;
+			std::string difference;
+			if (!AnyFXCheckScanner(preprocessed, line, difference))
+			{
+				static_cast<ANTLRErrorListener&>(lexerErrorHandler).syntaxError(nullptr, nullptr, line, 0, difference, nullptr);
+			}
+		}
+
         // create new effect
-        Effect effect = parser.entry()->returnEffect;
+        Effect effect = std::move(parser.entry()->returnEffect);
+		timings->parse = timer.Lap();
 
         // stop the process if lexing or parsing fails
         if (!lexerErrorHandler.hasError && !parserErrorHandler.hasError)
@@ -279,6 +438,7 @@ AnyFXCompile(const std::string& file, const std::string& output, const std::stri
             // type check effect
             typeChecker.SetHeader(header);
             effect.TypeCheck(typeChecker);
+			timings->typeCheck = timer.Lap();
 
             // compile effect
             int typeCheckerStatus = typeChecker.GetStatus();
@@ -290,6 +450,7 @@ AnyFXCompile(const std::string& file, const std::string& output, const std::stri
                 // generate code for effect
                 generator.SetHeader(header);
                 effect.Generate(generator);
+				timings->generate = timer.Lap();
 
                 // set warnings as 'error' buffer
                 if (typeCheckerStatus == TypeChecker::Warnings)
@@ -334,6 +495,7 @@ AnyFXCompile(const std::string& file, const std::string& output, const std::stri
 								headerWriter.Close();
 							}
 						}
+						timings->write = timer.Lap();
 
 						mcpp_use_mem_buffers(1);	// clear mcpp
                         return true;
@@ -409,16 +571,14 @@ AnyFXCompile(const std::string& file, const std::string& output, const std::stri
     }
     else
     {
-        char* err = mcpp_get_mem_buffer(ERR);
-        if (err)
+        if (!preprocessErrors.empty())
         {
-            size_t size = strlen(err);
+            size_t size = preprocessErrors.size();
             *errorBuffer = new AnyFXErrorBlob;
             (*errorBuffer)->buffer = new char[size];
             (*errorBuffer)->size = size;
-            memcpy((void*)(*errorBuffer)->buffer, (void*)err, size);
+            memcpy((void*)(*errorBuffer)->buffer, (void*)preprocessErrors.data(), size);
             (*errorBuffer)->buffer[size-1] = '\0';
-			mcpp_use_mem_buffers(1);	// clear mcpp
         }
 
         return false;
@@ -29,7 +29,28 @@ struct AnyFXErrorBlob
 	}
 };
 
+// wall clock time spent in each phase of a compile, in seconds
+struct AnyFXCompileTimings
+{
+	double preprocess;		// mcpp
+	double parse;			// lexing and parsing, including the pass which finds line directives
+	double typeCheck;		// effect setup and type checking
+	double generate;		// code generation, includes glslang
+	double write;			// writing the binary and the header
+
+	// constructor
+	AnyFXCompileTimings() :
+		preprocess(0),
+		parse(0),
+		typeCheck(0),
+		generate(0),
+		write(0)
+	{
+		// empty
+	}
+};
+
 extern std::vector<std::string> AnyFXGenerateDependencies(const std::string& file, const std::vector<std::string>& defines);
-extern bool AnyFXCompile(const std::string& file, const std::string& output, const std::string& header_output, const std::string& target, const std::string& vendor, const std::vector<std::string>& defines, const std::vector<std::string>& flags, AnyFXErrorBlob** errorBuffer);
+extern bool AnyFXCompile(const std::string& file, const std::string& output, const std::string& header_output, const std::string& target, const std::string& vendor, const std::vector<std::string>& defines, const std::vector<std::string>& flags, AnyFXErrorBlob** errorBuffer, AnyFXCompileTimings* timings = NULL);
 extern void AnyFXBeginCompile();
 extern void AnyFXEndCompile();
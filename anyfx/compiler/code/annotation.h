@@ -22,6 +22,14 @@ public:
 	Annotation();
 	/// destructor
 	virtual ~Annotation();
+	/// copy constructor
+	Annotation(const Annotation&) = default;
+	/// move constructor
+	Annotation(Annotation&&) = default;
+	/// copy assignment
+	Annotation& operator=(const Annotation&) = default;
+	/// move assignment
+	Annotation& operator=(Annotation&&) = default;
 
 	/// add type
 	void AddType(const DataType& type);
@@ -25,6 +25,14 @@ public:
 	Compileable();
 	/// destructor
 	virtual ~Compileable();
+	/// copy constructor
+	Compileable(const Compileable&) = default;
+	/// move constructor, parsed objects are moved into the effect rather than copied
+	Compileable(Compileable&&) = default;
+	/// copy assignment
+	Compileable& operator=(const Compileable&) = default;
+	/// move assignment
+	Compileable& operator=(Compileable&&) = default;
 
 	/// destroy symbol
 	virtual void Destroy();
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+//  compilearena.cc
+//  (C) 2016 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "compilearena.h"
+#include <stdlib.h>
+#include <new>
+
+namespace AnyFX
+{
+
+static thread_local CompileArena* CurrentArena = NULL;
+
+// AllocateCurrent puts the arena an allocation came from in front of it, NULL if it came from the heap,
+// so FreeCurrent doesn't have to search the arena's blocks
+static const size_t HeaderSize = alignof(max_align_t);
+static_assert(sizeof(CompileArena*) <= HeaderSize, "arena pointer must fit in front of an allocation");
+
+//------------------------------------------------------------------------------
+/**
+*/
+CompileArena::CompileArena() :
+	used(0),
+	allocated(0)
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+CompileArena::~CompileArena()
+{
+	if (CurrentArena == this) CurrentArena = NULL;
+
+	unsigned i;
+	for (i = 0; i < this->blocks.size(); i++)
+	{
+		free(this->blocks[i].data);
+	}
+	this->blocks.clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Allocations are aligned for any type, requests larger than a block get a block of their own
+*/
+void*
+CompileArena::Allocate(size_t size)
+{
+	const size_t align = alignof(max_align_t);
+	size = (size + align - 1) & ~(align - 1);
+
+	if (this->blocks.empty() || this->used + size > this->blocks.back().size)
+	{
+		Block block;
+		block.size = size > BlockSize ? size : BlockSize;
+		block.data = (char*)malloc(block.size);
+		if (block.data == NULL) throw std::bad_alloc();
+
+		// keep the current block last if the new one is only for this allocation, so its remainder can still be used
+		if (size > BlockSize && !this->blocks.empty())
+		{
+			this->blocks.insert(this->blocks.end() - 1, block);
+			this->allocated += size;
+			return block.data;
+		}
+		this->blocks.push_back(block);
+		this->used = 0;
+	}
+
+	void* ptr = this->blocks.back().data + this->used;
+	this->used += size;
+	this->allocated += size;
+	return ptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const std::string&
+CompileArena::Intern(const std::string& str)
+{
+	// nodes in an unordered_set never move, so the reference stays valid for the lifetime of the arena
+	return *this->strings.insert(str).first;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+CompileArena*
+CompileArena::SetCurrent(CompileArena* arena)
+{
+	CompileArena* prev = CurrentArena;
+	CurrentArena = arena;
+	return prev;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+CompileArena*
+CompileArena::GetCurrent()
+{
+	return CurrentArena;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void*
+CompileArena::AllocateCurrent(size_t size)
+{
+	char* ptr = CurrentArena ? (char*)CurrentArena->Allocate(size + HeaderSize) : (char*)::operator new(size + HeaderSize);
+	*(CompileArena**)ptr = CurrentArena;
+	return ptr + HeaderSize;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Memory from an arena is released with the arena itself, so objects must not outlive the compile which allocated them.
+*/
+void
+CompileArena::FreeCurrent(void* ptr)
+{
+	if (ptr == NULL) return;
+	char* header = (char*)ptr - HeaderSize;
+	if (*(CompileArena**)header != NULL) return;
+	::operator delete(header);
+}
+
+} // namespace AnyFX
@@ -0,0 +1,81 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class AnyFX::CompileArena
+    
+    Owns memory which lives as long as a single compile.
+
+	Expression trees are allocated linearly from large blocks, and freed all at
+	once when the arena is destroyed, so building and tearing down the AST does
+	not go through the heap once per node. Identifiers are interned, giving every
+	distinct name a single string whose address can be compared instead of its
+	characters.
+
+	The arena is made current for the thread which runs the compile, objects
+	allocated while no arena is current fall back on the heap.
+    
+    (C) 2016 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <stddef.h>
+namespace AnyFX
+{
+class CompileArena
+{
+public:
+	/// constructor
+	CompileArena();
+	/// destructor, frees all memory allocated from the arena
+	~CompileArena();
+
+	/// allocate memory, which is only freed with the arena
+	void* Allocate(size_t size);
+	/// get interned string, equal strings always return the same object
+	const std::string& Intern(const std::string& str);
+
+	/// get number of bytes allocated
+	size_t GetAllocatedSize() const;
+
+	/// make arena current on this thread, NULL clears it, returns the previous one
+	static CompileArena* SetCurrent(CompileArena* arena);
+	/// get arena current on this thread, may be NULL
+	static CompileArena* GetCurrent();
+
+	/// allocate from the current arena, or from the heap if there is none
+	static void* AllocateCurrent(size_t size);
+	/// free memory from AllocateCurrent, does nothing if it belongs to an arena
+	static void FreeCurrent(void* ptr);
+
+private:
+	/// no copies, the arena owns its blocks
+	CompileArena(const CompileArena&) = delete;
+	/// no copies, the arena owns its blocks
+	CompileArena& operator=(const CompileArena&) = delete;
+
+	static const size_t BlockSize = 64 * 1024;
+
+	struct Block
+	{
+		char* data;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	size_t used;
+	size_t allocated;
+	std::unordered_set<std::string> strings;
+}; 
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline size_t
+CompileArena::GetAllocatedSize() const
+{
+	return this->allocated;
+}
+
+} // namespace AnyFX
+//------------------------------------------------------------------------------
@@ -15,7 +15,9 @@ Constant::Constant() :
 	isArray(false),
 	sizeExpression(NULL),
 	arrayType(ExplicitArray),
-	arraySize(1)
+	arraySize(1),
+	isSpecialization(false),
+	specializationId(0)
 {
 	this->symbolType = Symbol::ConstantType;
 }
@@ -55,11 +57,30 @@ Constant::AddValue(const ValueList& value)
 //------------------------------------------------------------------------------
 /**
 */
+bool
+Constant::IsSpecializable() const
+{
+	if (this->isArray || this->valueTable.size() != 1) return false;
+	const DataType::Type type = this->type.GetType();
+	return type == DataType::Bool || type == DataType::Integer || type == DataType::UInteger;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Specialization constants must be initialized by a literal, so the evaluated value is written without a type constructor.
+*/
 std::string
 Constant::Format(const Header& header) const
 {
 	std::string result;
-	if (header.GetType() == Header::GLSL || header.GetType() == Header::SPIRV)
+	if (this->isSpecialization && header.GetType() == Header::SPIRV)
+	{
+		std::string value = this->valueTable[0].second.GetString();
+		if (this->type.GetType() == DataType::Bool)			value = value == "0" ? "false" : "true";
+		else if (this->type.GetType() == DataType::UInteger)	value.append("u");
+		result = AnyFX::Format("layout(constant_id = %d) const %s %s = %s;\n", this->specializationId, DataType::ToProfileType(this->type, header.GetType()).c_str(), this->name.c_str(), value.c_str());
+	}
+	else if (header.GetType() == Header::GLSL || header.GetType() == Header::SPIRV)
 	{
 		result.append("const ");
 		result.append(DataType::ToProfileType(this->type, header.GetType()));
@@ -31,6 +31,14 @@ public:
 	Constant();
 	/// destructor
 	virtual ~Constant();
+	/// copy constructor
+	Constant(const Constant&) = default;
+	/// move constructor
+	Constant(Constant&&) = default;
+	/// copy assignment
+	Constant& operator=(const Constant&) = default;
+	/// move assignment
+	Constant& operator=(Constant&&) = default;
 
 	/// sets array size expression
 	void SetSizeExpression(Expression* expr);
@@ -59,6 +67,15 @@ public:
 	/// gets value at index
 	const ValueList& GetValue(unsigned i) const;
 
+	/// returns true if constant is a scalar bool, int or uint, which may be lowered to a specialization constant
+	bool IsSpecializable() const;
+	/// make constant a specialization constant with the given id, only used when targeting SPIR-V
+	void SetSpecializationId(unsigned id);
+	/// get specialization constant id
+	unsigned GetSpecializationId() const;
+	/// returns true if constant is a specialization constant
+	bool IsSpecialization() const;
+
 	/// type checks constant
 	void TypeCheck(TypeChecker& typechecker);
 	/// formats constant
@@ -72,6 +89,8 @@ private:
 	Expression* sizeExpression;
 	unsigned arraySize;
 	bool isArray;
+	bool isSpecialization;
+	unsigned specializationId;
 	
 }; 
 
@@ -140,6 +159,34 @@ Constant::GetValue(unsigned i) const
 	return this->valueTable[i].second;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+Constant::SetSpecializationId(unsigned id)
+{
+	this->isSpecialization = true;
+	this->specializationId = id;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+Constant::GetSpecializationId() const
+{
+	return this->specializationId;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+Constant::IsSpecialization() const
+{
+	return this->isSpecialization;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -939,16 +939,11 @@ DataType::ToByteSize(const DataType& type)
     case DataType::UserType:
         {
             TypeChecker* typeChecker = TypeChecker::Instance();
-            if (typeChecker->HasSymbol(type.GetName()))
+            Structure* struc = typeChecker->FindStructure(type.GetName());
+            if (struc != NULL)
             {
-                Symbol* sym = typeChecker->GetSymbol(type.GetName());
-                if (sym->GetType() == Symbol::StructureType)
-                {
-                    Structure* struc = (Structure*)sym;
-                    return struc->CalculateSize();
-                }
-                
-            }    
+                return struc->CalculateSize();
+            }
         }
     default:		// this is for all special types, such as texture handles etc.
         return sizeof(int);
@@ -116,6 +116,14 @@ public:
 	DataType();
 	/// destructor
 	virtual ~DataType();
+	/// copy constructor
+	DataType(const DataType&) = default;
+	/// move constructor
+	DataType(DataType&&) = default;
+	/// copy assignment
+	DataType& operator=(const DataType&) = default;
+	/// move assignment
+	DataType& operator=(DataType&&) = default;
 
 	/// equality operator
 	bool operator==(const DataType& type) const;
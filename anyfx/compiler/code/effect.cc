@@ -6,9 +6,14 @@
 #include <assert.h>
 #include "constant.h"
 #include <algorithm>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <stdlib.h>
+#include <array>
 
 #define VERSION_MAJOR 2
-#define VERSION_MINOR 1
+#define VERSION_MINOR 11
 
 #define ROUND_TO_POW(n, p) ((n + p - 1) & ~(p - 1))
 
@@ -18,7 +23,8 @@ namespace AnyFX
 //------------------------------------------------------------------------------
 /**
 */
-Effect::Effect()
+Effect::Effect() :
+	partial(false)
 {
 	// empty
 }
@@ -27,6 +33,56 @@ Effect::Effect()
 /**
 */
 Effect::~Effect()
+{
+	this->Clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Takes over the parsed objects, the moved from effect is left empty
+*/
+Effect::Effect(Effect&& rhs) = default;
+
+//------------------------------------------------------------------------------
+/**
+*/
+Effect&
+Effect::operator=(Effect&& rhs)
+{
+	if (this != &rhs)
+	{
+		this->Clear();
+		Compileable::operator=(std::move(rhs));
+		this->header = std::move(rhs.header);
+		this->name = std::move(rhs.name);
+		this->programs = std::move(rhs.programs);
+		this->permutationGroups = std::move(rhs.permutationGroups);
+		this->variables = std::move(rhs.variables);
+		this->constants = std::move(rhs.constants);
+		this->renderStates = std::move(rhs.renderStates);
+		this->functions = std::move(rhs.functions);
+		this->structures = std::move(rhs.structures);
+		this->varBlocks = std::move(rhs.varBlocks);
+		this->varBuffers = std::move(rhs.varBuffers);
+		this->subroutines = std::move(rhs.subroutines);
+		this->samplers = std::move(rhs.samplers);
+		this->passthroughPPs = std::move(rhs.passthroughPPs);
+		this->shaders = std::move(rhs.shaders);
+		this->declarations = std::move(rhs.declarations);
+		this->indexToFileMap = std::move(rhs.indexToFileMap);
+		this->placeholderRenderState = std::move(rhs.placeholderRenderState);
+		this->placeholderVarBlock = std::move(rhs.placeholderVarBlock);
+		this->debugOutput = std::move(rhs.debugOutput);
+		this->partial = rhs.partial;
+	}
+	return *this;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Effect::Clear()
 {
 	unsigned i;
 	for (i = 0; i < programs.size(); i++)
@@ -87,6 +143,7 @@ Effect::~Effect()
 	}
 	this->shaders.clear();
 	this->programs.clear();
+	this->permutationGroups.clear();
 	this->variables.clear();
 	this->constants.clear();
 	this->renderStates.clear();
@@ -102,90 +159,90 @@ Effect::~Effect()
 /**
 */
 void
-Effect::AddProgram(const Program& program)
+Effect::AddProgram(Program&& program)
 {
-	this->programs.push_back(program);
+	this->programs.push_back(std::move(program));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddVariable(const Variable& var)
+Effect::AddVariable(Variable&& var)
 {
-	this->variables.push_back(var);
+	this->variables.push_back(std::move(var));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddConstant(const Constant& constant)
+Effect::AddConstant(Constant&& constant)
 {
-	this->constants.push_back(constant);
+	this->constants.push_back(std::move(constant));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddRenderState(const RenderState& state)
+Effect::AddRenderState(RenderState&& state)
 {
-	this->renderStates.push_back(state);
+	this->renderStates.push_back(std::move(state));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddFunction(const Function& function)
+Effect::AddFunction(Function&& function)
 {
-	this->functions.push_back(function);
+	this->functions.push_back(std::move(function));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddStructure(const Structure& structure)
+Effect::AddStructure(Structure&& structure)
 {
-	this->structures.push_back(structure);
+	this->structures.push_back(std::move(structure));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddVarBlock(const VarBlock& varBlock)
+Effect::AddVarBlock(VarBlock&& varBlock)
 {
-	this->varBlocks.push_back(varBlock);
+	this->varBlocks.push_back(std::move(varBlock));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddVarBuffer(const VarBuffer& varBuffer)
+Effect::AddVarBuffer(VarBuffer&& varBuffer)
 {
-    this->varBuffers.push_back(varBuffer);
+    this->varBuffers.push_back(std::move(varBuffer));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddSubroutine(const Subroutine& subroutine)
+Effect::AddSubroutine(Subroutine&& subroutine)
 {
-    this->subroutines.push_back(subroutine);
+    this->subroutines.push_back(std::move(subroutine));
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 void
-Effect::AddSampler(const Sampler& sampler)
+Effect::AddSampler(Sampler&& sampler)
 {
-	this->samplers.push_back(sampler);
+	this->samplers.push_back(std::move(sampler));
 }
 
 //------------------------------------------------------------------------------
@@ -208,30 +265,70 @@ Effect::Setup()
 	// reset static states
 	Shader::ResetBindings();
 
-	// build shaders, this will make sure we have all the shader programs we need, although they are not complete yet
+	// permutations are whole programs from here on, so everything below treats them like any other program
+	this->ExpandPermutations();
+
+	// when only some programs are asked for, the rest are dropped before any shader is built for them
+	if (!this->header.GetValue("/PROGRAMS").empty())
+	{
+		this->SelectPrograms(this->header.GetValue("/PROGRAMS"));
+	}
+
+	// scalar constants switched by program compile flags become specialization constants, so programs only differing in those share one module
 	unsigned i;
-	for (i = 0; i < this->programs.size(); i++)
+	if (this->header.GetType() == Header::SPIRV)
 	{
-		this->programs[i].BuildShaders(this->header, this->functions, this->shaders);
+		std::set<std::string> switches;
+		for (i = 0; i < this->programs.size(); i++)
+		{
+			this->programs[i].GetCompileFlagNames(switches);
+		}
+
+		std::map<std::string, const Constant*> specialized;
+		for (i = 0; i < this->constants.size(); i++)
+		{
+			Constant& constant = this->constants[i];
+			if (constant.IsSpecializable() && switches.find(constant.GetName()) != switches.end())
+			{
+				constant.SetSpecializationId(specialized.size());
+				specialized[constant.GetName()] = &constant;
+			}
+		}
+
+		if (!specialized.empty())
+		{
+			for (i = 0; i < this->programs.size(); i++)
+			{
+				this->programs[i].ExtractSpecializations(specialized);
+			}
+		}
 	}
 
-	// now, remove all functions which are not bound as shaders
+	// index shader functions by name, the first one declared wins like it would when searching
+	std::unordered_map<std::string, const Function*> shaderFunctions;
 	for (i = 0; i < this->functions.size(); i++)
 	{
-		// get function
 		const Function& func = this->functions[i];
+		if (func.IsShader()) shaderFunctions.emplace(func.GetName(), &func);
+	}
 
-		if (func.IsShader())
-		{
-			this->functions.erase(this->functions.begin() + i);
-			i--;
-		}
+	// build shaders, this will make sure we have all the shader programs we need, although they are not complete yet
+	for (i = 0; i < this->programs.size(); i++)
+	{
+		this->programs[i].BuildShaders(this->header, shaderFunctions, this->shaders);
 	}
 
+	// now, remove all functions which are bound as shaders, the shaders have their own copies
+	this->functions.erase(std::remove_if(this->functions.begin(), this->functions.end(), [](const Function& func) { return func.IsShader(); }), this->functions.end());
+
 	// create a placeholder render state, which will be used for programs where no render state is explicitly assigned
 	this->placeholderRenderState.SetName("PlaceholderState");
     this->placeholderRenderState.SetReserved(true);
-    this->renderStates.insert(this->renderStates.begin(), this->placeholderRenderState);
+	std::vector<RenderState> states;
+	states.reserve(this->renderStates.size() + 1);
+	states.push_back(this->placeholderRenderState);
+	std::move(this->renderStates.begin(), this->renderStates.end(), std::back_inserter(states));
+	this->renderStates = std::move(states);
 
 	if (header.GetFlags() & Header::PutGlobalVariablesInBlock)
 	{
@@ -239,6 +336,8 @@ Effect::Setup()
 		this->placeholderVarBlock.SetReserved(true);
 		this->placeholderVarBlock.AddQualifier("shared");
 
+		// move global uniforms to the global block, and compact the remaining variables in place
+		unsigned kept = 0;
 		for (i = 0; i < this->variables.size(); i++)
 		{
 			AnyFX::Variable& var = this->variables[i];
@@ -246,14 +345,22 @@ Effect::Setup()
 			if (var.GetDataType().GetType() < DataType::Sampler1D && var.IsUniform())
 			{
 				this->placeholderVarBlock.AddVariable(var);
-				this->variables.erase(this->variables.begin() + i);
-				i--;
+			}
+			else
+			{
+				if (kept != i) this->variables[kept] = std::move(var);
+				kept++;
 			}
 		}
+		this->variables.resize(kept);
 
 		// sort variables, since we can't handle the alignment manually here
 		this->placeholderVarBlock.SortVariables();
-		this->varBlocks.insert(this->varBlocks.begin(), this->placeholderVarBlock);
+		std::vector<VarBlock> blocks;
+		blocks.reserve(this->varBlocks.size() + 1);
+		blocks.push_back(this->placeholderVarBlock);
+		std::move(this->varBlocks.begin(), this->varBlocks.end(), std::back_inserter(blocks));
+		this->varBlocks = std::move(blocks);
 	}
 	else
 	{
@@ -267,7 +374,7 @@ Effect::Setup()
 	// if header has default group number, use it
 	const std::string& defaultSet = this->header.GetValue("/DEFAULTSET");
 	unsigned defaultSetIdx = 0;
-	if (defaultSet != "/DEFAULTSET")
+	if (!defaultSet.empty())
 	{
 		defaultSetIdx = std::stoi(defaultSet);
 	}
@@ -303,6 +410,194 @@ Effect::Setup()
 	}
 }
 
+//------------------------------------------------------------------------------
+/**
+	Permutations of a program are kept next to each other, in the order their masks count up.
+*/
+void
+Effect::ExpandPermutations()
+{
+	std::vector<Program> expanded;
+	expanded.reserve(this->programs.size());
+	unsigned i;
+	for (i = 0; i < this->programs.size(); i++)
+	{
+		Program& program = this->programs[i];
+		program.ExtractPermutationAxes();
+		if (!program.HasPermutations())
+		{
+			expanded.push_back(std::move(program));
+			continue;
+		}
+
+		const std::vector<Program::PermutationAxis>& axes = program.GetPermutationAxes();
+		PermutationGroup group;
+		group.name = program.GetName();
+		group.axes = axes;
+		group.programs.assign(1u << (axes.back().shift + axes.back().bits), InvalidPermutation);
+
+		// count through every combination of values, the first axis changes fastest
+		std::vector<unsigned> values(axes.size(), 0);
+		unsigned axis = 0;
+		while (axis < axes.size())
+		{
+			unsigned mask;
+			Program permutation = program.MakePermutation(values, mask);
+			group.programs[mask] = expanded.size();
+			expanded.push_back(std::move(permutation));
+
+			for (axis = 0; axis < axes.size(); axis++)
+			{
+				if (++values[axis] < axes[axis].flags.size()) break;
+				values[axis] = 0;
+			}
+		}
+		this->permutationGroups.push_back(std::move(group));
+	}
+	this->programs = std::move(expanded);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Every binding is visible to all stages, so a set's layout only depends on what is bound where. Blocks moved to
+	push constants take no binding. Samplers baked into the layout as immutable add their settings.
+*/
+std::map<unsigned, unsigned long long>
+Effect::HashSetLayouts() const
+{
+	// set, binding, kind, type and count of every descriptor, and the settings of static samplers
+	std::vector<std::pair<std::array<unsigned, 5>, unsigned long long>> bindings;
+	unsigned i;
+	for (i = 0; i < this->varBlocks.size(); i++)
+	{
+		const VarBlock& block = this->varBlocks[i];
+		if (HasFlags(block.qualifierFlags, Qualifiers::Push) || HasFlags(block.qualifierFlags, Qualifiers::Promoted)) continue;
+		bindings.push_back({ { block.group, block.binding, 0, 0, 1 }, 0 });
+	}
+	for (i = 0; i < this->varBuffers.size(); i++)
+	{
+		const VarBuffer& buffer = this->varBuffers[i];
+		bindings.push_back({ { buffer.group, buffer.binding, 1, 0, 1 }, 0 });
+	}
+	for (i = 0; i < this->variables.size(); i++)
+	{
+		const Variable& var = this->variables[i];
+		if (var.GetDataType().GetType() < DataType::Sampler1D || var.IsSubroutine()) continue;
+		bindings.push_back({ { var.group, var.binding, 2, (unsigned)var.GetDataType().GetType(), var.isArray ? (unsigned)var.arraySize : 1 }, 0 });
+	}
+	for (i = 0; i < this->samplers.size(); i++)
+	{
+		const Sampler& sampler = this->samplers[i];
+		unsigned long long settings = 0;
+		if (sampler.isStatic)
+		{
+			settings = HashString64((const char*)sampler.floatFlags, sizeof(sampler.floatFlags));
+			settings = HashString64((const char*)sampler.boolFlags, sizeof(sampler.boolFlags), settings);
+			settings = HashString64((const char*)sampler.intFlags, sizeof(sampler.intFlags), settings);
+			settings = HashString64((const char*)sampler.float4Flags, sizeof(sampler.float4Flags), settings);
+		}
+		bindings.push_back({ { sampler.group, sampler.binding, 3, sampler.isStatic ? 1u : 0u, 1 }, settings });
+	}
+	std::sort(bindings.begin(), bindings.end());
+
+	std::map<unsigned, unsigned long long> layouts;
+	for (i = 0; i < bindings.size(); i++)
+	{
+		const unsigned set = bindings[i].first[0];
+		std::map<unsigned, unsigned long long>::iterator it = layouts.find(set);
+		if (it == layouts.end()) it = layouts.emplace(set, HashString64(NULL, 0)).first;
+		it->second = HashString64((const char*)&bindings[i].first[1], 4 * sizeof(unsigned), it->second);
+		it->second = HashString64((const char*)&bindings[i].second, sizeof(bindings[i].second), it->second);
+	}
+	return layouts;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Matches a name against a pattern where '*' matches any run of characters and '?' any single one.
+*/
+static bool
+MatchGlob(const char* pattern, const char* name)
+{
+	const char* star = NULL;
+	const char* resume = NULL;
+	while (*name)
+	{
+		if (*pattern == '*')
+		{
+			star = pattern++;
+			resume = name;
+		}
+		else if (*pattern == '?' || *pattern == *name)
+		{
+			pattern++;
+			name++;
+		}
+		else if (star)
+		{
+			pattern = star + 1;
+			name = ++resume;
+		}
+		else return false;
+	}
+	while (*pattern == '*') pattern++;
+	return *pattern == '\0';
+}
+
+//------------------------------------------------------------------------------
+/**
+	Patterns are separated by ',' or ';'. A permutation matches either by its full name or by the name of
+	the program it was generated from, so naming a program selects all of its permutations.
+	Permutation groups are renumbered to the remaining programs, and dropped if none of theirs are left.
+*/
+void
+Effect::SelectPrograms(const std::string& selection)
+{
+	std::vector<std::string> patterns;
+	size_t start = 0;
+	while (start <= selection.size())
+	{
+		size_t end = selection.find_first_of(",;", start);
+		if (end == std::string::npos) end = selection.size();
+		if (end > start) patterns.push_back(selection.substr(start, end - start));
+		start = end + 1;
+	}
+
+	std::vector<unsigned> remap(this->programs.size(), InvalidPermutation);
+	std::vector<Program> selected;
+	unsigned i, j;
+	for (i = 0; i < this->programs.size(); i++)
+	{
+		const std::string& name = this->programs[i].GetName();
+		const std::string base = name.substr(0, name.find('|'));
+		for (j = 0; j < patterns.size(); j++)
+		{
+			if (MatchGlob(patterns[j].c_str(), name.c_str()) || MatchGlob(patterns[j].c_str(), base.c_str())) break;
+		}
+		if (j == patterns.size()) continue;
+		remap[i] = selected.size();
+		selected.push_back(std::move(this->programs[i]));
+	}
+	this->programs = std::move(selected);
+
+	unsigned kept = 0;
+	for (i = 0; i < this->permutationGroups.size(); i++)
+	{
+		PermutationGroup& group = this->permutationGroups[i];
+		bool used = false;
+		for (j = 0; j < group.programs.size(); j++)
+		{
+			if (group.programs[j] != InvalidPermutation) group.programs[j] = remap[group.programs[j]];
+			used |= group.programs[j] != InvalidPermutation;
+		}
+		if (!used) continue;
+		if (kept != i) this->permutationGroups[kept] = std::move(group);
+		kept++;
+	}
+	this->permutationGroups.resize(kept);
+	this->partial = true;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -311,6 +606,11 @@ Effect::TypeCheck(TypeChecker& typechecker)
 {
 	this->header.TypeCheck(typechecker);
 
+	if (this->partial && this->programs.empty())
+	{
+		typechecker.Error(Format("No program matches the selection '%s'\n", this->header.GetValue("/PROGRAMS").c_str()));
+	}
+
 	// typecheck all shaders
 	std::map<std::string, Shader*>::iterator it;
 	for (it = this->shaders.begin(); it != this->shaders.end(); it++)
@@ -376,20 +676,86 @@ Effect::TypeCheck(TypeChecker& typechecker)
         this->varBuffers[i].TypeCheck(typechecker);
     }
 
+	// block sizes are known now
+	if (this->header.GetType() == Header::SPIRV && !this->header.GetValue("/PUSHBUDGET").empty())
+	{
+		this->PromotePushConstants(typechecker);
+	}
+
 	for (i = 0; i < this->programs.size(); i++)
 	{
 		this->programs[i].TypeCheck(typechecker);
 	}
 
 	// remove variables used as subroutines
-	for (i = 0; i < this->variables.size(); i++)
+	if (this->header.GetFlags() & Header::NoSubroutines)
+	{
+		this->variables.erase(std::remove_if(this->variables.begin(), this->variables.end(), [](const Variable& var) { return var.IsSubroutine(); }), this->variables.end());
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	A stage can only have one push constant block, so nothing is promoted if the effect declares one itself.
+	Blocks are taken smallest first, since that fits the most blocks, and with it the most descriptor bindings, into the budget.
+*/
+void
+Effect::PromotePushConstants(TypeChecker& typechecker)
+{
+	unsigned budget = atoi(this->header.GetValue("/PUSHBUDGET").c_str());
+	std::vector<VarBlock*> candidates;
+	unsigned i;
+	for (i = 0; i < this->varBlocks.size(); i++)
 	{
-		if (this->header.GetFlags() & Header::NoSubroutines && this->variables[i].IsSubroutine())
+		VarBlock& block = this->varBlocks[i];
+		if (HasFlags(block.qualifierFlags, Qualifiers::Push)) return;
+		if (block.IsPromotable()) candidates.push_back(&block);
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [](const VarBlock* a, const VarBlock* b) { return a->GetAlignedSize() < b->GetAlignedSize(); });
+
+	// blocks start on 16 byte boundaries, which satisfies the alignment of any member
+	unsigned offset = 0;
+	for (i = 0; i < candidates.size(); i++)
+	{
+		if (candidates[i]->PromoteToPushConstants(offset, budget, typechecker))
 		{
-			this->variables.erase(this->variables.begin() + i);
-			i--;
+			offset = ROUND_TO_POW(offset + candidates[i]->GetAlignedSize(), 16);
 		}
 	}
+
+	// promoted blocks took a binding in type checking, hand them back from the highest down so the set layouts have no holes
+	std::stable_sort(candidates.begin(), candidates.end(), [](const VarBlock* a, const VarBlock* b) { return a->binding > b->binding; });
+	for (i = 0; i < candidates.size(); i++)
+	{
+		if (candidates[i]->IsPromoted()) this->ReleaseBinding(candidates[i]->group, candidates[i]->binding);
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Every binding after the released one in the same group moves down by one, promoted blocks included, they don't use theirs anymore.
+*/
+void
+Effect::ReleaseBinding(unsigned group, unsigned binding)
+{
+	unsigned i;
+	for (i = 0; i < this->varBlocks.size(); i++)
+	{
+		if (this->varBlocks[i].group == group && this->varBlocks[i].binding > binding) this->varBlocks[i].binding--;
+	}
+	for (i = 0; i < this->varBuffers.size(); i++)
+	{
+		if (this->varBuffers[i].group == group && this->varBuffers[i].binding > binding) this->varBuffers[i].binding--;
+	}
+	for (i = 0; i < this->variables.size(); i++)
+	{
+		if (this->variables[i].group == group && this->variables[i].binding > binding) this->variables[i].binding--;
+	}
+	for (i = 0; i < this->samplers.size(); i++)
+	{
+		if (this->samplers[i].group == group && this->samplers[i].binding > binding) this->samplers[i].binding--;
+	}
+	Shader::bindingIndices[group]--;
 }
 
 //------------------------------------------------------------------------------
@@ -398,16 +764,27 @@ Effect::TypeCheck(TypeChecker& typechecker)
 void
 Effect::Generate(Generator& generator)
 {
-	// typecheck all shaders
+	// declarations are the same for every shader stage, so only format them once
+	this->FormatDeclarations();
+
+	// generate code for all shaders, this is cheap compared to parsing them
 	std::map<std::string, Shader*>::iterator it;
+	for (it = this->shaders.begin(); it != this->shaders.end(); it++)
+	{
+		it->second->Generate(generator, this->declarations, this->indexToFileMap, this->passthroughPPs);
+	}
+
+	// with a cache, parsing is left to the programs which miss it
+	if (this->header.GetType() == Header::SPIRV && this->header.GetValue("/SPVCACHE").empty())
+	{
+		this->ParseShaders(generator);
+	}
+
 	unsigned i = 0;
 	for (it = this->shaders.begin(); it != this->shaders.end(); it++)
 	{
 		Shader* shader = it->second;
 
-		// generate code for shaders
-		shader->Generate(generator, this->variables, this->structures, this->constants, this->varBlocks, this->varBuffers, this->samplers, this->subroutines, this->functions, this->passthroughPPs);
-
 		// output generated code if we flag it
 		if (this->header.GetFlags() & Header::OutputGeneratedShaders)
 		{
@@ -423,24 +800,169 @@ Effect::Generate(Generator& generator)
 	for (i = 0; i < this->programs.size(); i++)
 	{
 		Program& prog = this->programs[i];
-		prog.Generate(generator);
+
+		// programs which only differ in specialization constants or render state link the same shaders, so reuse the first link
+		unsigned j;
+		for (j = 0; j < i; j++)
+		{
+			if (this->programs[j].SharesShaders(prog)) break;
+		}
+		if (j < i)	prog.CopyLink(this->programs[j]);
+		else		prog.Generate(generator);
+
+		// programs only get the part of the push constant range their shaders use
+		for (j = 0; j < this->varBlocks.size(); j++)
+		{
+			const VarBlock& block = this->varBlocks[j];
+			if (!block.IsPromoted()) continue;
+
+			std::map<std::string, unsigned>::const_iterator offset;
+			for (offset = block.offsetsByName.begin(); offset != block.offsetsByName.end(); offset++)
+			{
+				if (prog.uniformBufferOffsets.find(offset->first) != prog.uniformBufferOffsets.end()) break;
+			}
+			if (offset != block.offsetsByName.end()) prog.AddPushConstantRange(block.GetPushConstantOffset(), block.GetAlignedSize());
+		}
 
 		if (this->header.GetFlags() & Header::OutputGeneratedShaders)
 		{
-			unsigned j;
+			// permutation names hold the flags separated by '|', which can't be part of a file name
+			std::string fileName = prog.GetName();
+			std::replace(fileName.begin(), fileName.end(), '|', '_');
 			for (j = 0; j < ProgramRow::NumProgramRows - 1; j++)
 			{
 				BinWriter out;
-				out.SetPath(AnyFX::Format("%s_%s_%d%s", this->debugOutput.c_str(), prog.GetName().c_str(), j, "_debug.bin"));
+				out.SetPath(AnyFX::Format("%s_%s_%d%s", this->debugOutput.c_str(), fileName.c_str(), j, "_debug.bin"));
 				out.Open();
-				const std::vector<unsigned> bin = prog.GetBinary(j); 
-				prog.WriteBinary(bin, out);
+				const std::vector<unsigned>& bin = prog.GetBinary(j);
+
+				// debug output is always uncompressed
+				out.WriteUInt(bin.size() * sizeof(unsigned));
+				if (!bin.empty()) out.WriteBytes((const char*)bin.data(), bin.size() * sizeof(unsigned));
 				out.Close();
 			}
 		}
 	}
 }
 
+//------------------------------------------------------------------------------
+/**
+	Shaders don't depend on each other, so they are handed out to the threads one at a time.
+	The thread count is taken from '/THREADS n', and defaults to the number of hardware threads.
+*/
+void
+Effect::ParseShaders(Generator& generator)
+{
+	std::vector<Shader*> pending;
+	std::map<std::string, Shader*>::iterator it;
+	for (it = this->shaders.begin(); it != this->shaders.end(); it++)
+	{
+		pending.push_back(it->second);
+	}
+
+	unsigned numThreads = atoi(this->header.GetValue("/THREADS").c_str());
+	if (numThreads == 0) numThreads = std::thread::hardware_concurrency();
+	numThreads = std::min(numThreads, (unsigned)pending.size());
+
+	std::atomic<unsigned> next(0);
+	auto work = [&pending, &next, &generator]()
+	{
+		unsigned index;
+		while ((index = next++) < pending.size()) pending[index]->Parse(generator);
+	};
+
+	// the calling thread does its share, so a single thread never spawns one
+	std::vector<std::thread> threads;
+	unsigned i;
+	for (i = 1; i < numThreads; i++) threads.push_back(std::thread(work));
+	work();
+	for (i = 0; i < threads.size(); i++) threads[i].join();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Nothing in here may depend on the shader stage, stage specific defines go in the stage header built by Shader::Generate.
+*/
+void
+Effect::FormatDeclarations()
+{
+	this->declarations.clear();
+	this->indexToFileMap.clear();
+
+	unsigned i;
+	for (i = 0; i < this->structures.size(); i++)
+	{
+		this->declarations.append(this->structures[i].Format(this->header));
+	}
+
+	for (i = 0; i < this->samplers.size(); i++)
+	{
+		this->declarations.append(this->samplers[i].Format(this->header));
+	}
+
+	for (i = 0; i < this->variables.size(); i++)
+	{
+		const Variable& var = this->variables[i];
+
+		if (!var.IsSubroutine())
+		{
+			// variable is formatted by resolving the internal type to the target type
+			this->declarations.append(var.Format(this->header));
+		}
+	}
+
+	std::string pushConstants;
+	for (i = 0; i < this->varBlocks.size(); i++)
+	{
+		const VarBlock& block = this->varBlocks[i];
+		if (block.IsPromoted())	pushConstants.append(block.FormatPushConstantMembers(this->header));
+		else					this->declarations.append(block.Format(this->header));
+	}
+
+	// promoted blocks share one anonymous block, so shaders keep accessing their members by name
+	if (!pushConstants.empty())
+	{
+		this->declarations.append("layout(push_constant) uniform ANYFX_PROMOTED_PUSH_CONSTANTS\n{\n");
+		this->declarations.append(pushConstants);
+		this->declarations.append("};\n\n");
+	}
+
+	for (i = 0; i < this->varBuffers.size(); i++)
+	{
+		this->declarations.append(this->varBuffers[i].Format(this->header));
+	}
+
+	for (i = 0; i < this->constants.size(); i++)
+	{
+		this->declarations.append(this->constants[i].Format(this->header));
+	}
+
+	for (i = 0; i < this->functions.size(); i++)
+	{
+		const Function& func = this->functions[i];
+		this->declarations.append(func.GetCode());
+		this->indexToFileMap[func.GetFileIndex()] = std::pair<std::string, std::string>(func.GetName(), func.GetFile());
+	}
+
+	for (i = 0; i < this->subroutines.size(); i++)
+	{
+		const Subroutine& subroutine = this->subroutines[i];
+		this->declarations.append(subroutine.Format(this->header));
+		this->indexToFileMap[subroutine.GetFileIndex()] = std::pair<std::string, std::string>(subroutine.GetName(), subroutine.GetFile());
+	}
+
+	for (i = 0; i < this->variables.size(); i++)
+	{
+		const Variable& var = this->variables[i];
+
+		if (var.IsSubroutine())
+		{
+			// generate subroutine vars
+			this->declarations.append(var.Format(this->header));
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -458,8 +980,33 @@ Effect::Compile(BinWriter& writer)
 	this->header.Compile(writer);
 
 	unsigned i;
+
+	// write directory, the offsets are not known yet so we write placeholders and patch them once all chunks are written
+	// a partial effect is marked by a trailing chunk, so loaders know to merge it into the full effect rather than replace it
+	std::vector<int> chunks = { 'SHAD', 'RENS', 'SUBR', 'PROG', 'VARI', 'SAMP', 'VARB', 'VRBF', 'PERM', 'PIPE' };
+	if (this->partial) chunks.push_back('PART');
+	const unsigned numChunks = chunks.size();
+	std::vector<unsigned> chunkOffsets(numChunks);
+	std::vector<unsigned> programOffsets(this->programs.size());
+	writer.WriteInt('DIRE');
+	writer.WriteUInt(numChunks);
+	unsigned chunkTable = writer.Tell();
+	for (i = 0; i < numChunks; i++)
+	{
+		writer.WriteInt(chunks[i]);
+		writer.WriteUInt(0);
+	}
+	writer.WriteUInt(this->programs.size());
+	std::vector<unsigned> programTable(this->programs.size());
+	for (i = 0; i < this->programs.size(); i++)
+	{
+		writer.WriteString(this->programs[i].GetName());
+		programTable[i] = writer.Tell();
+		writer.WriteUInt(0);
+	}
 	
 	// write FourCC code for shaders
+	chunkOffsets[0] = writer.Tell();
 	writer.WriteInt('SHAD');
 
 	// write amount of shaders
@@ -476,6 +1023,7 @@ Effect::Compile(BinWriter& writer)
 	}
 
 	// write FourCC code for render states
+	chunkOffsets[1] = writer.Tell();
 	writer.WriteInt('RENS');
 
 	// write amount of render states
@@ -488,6 +1036,7 @@ Effect::Compile(BinWriter& writer)
 	}
 
     // write FourCC code for subroutines
+    chunkOffsets[2] = writer.Tell();
     writer.WriteInt('SUBR');
 
     // write amount of subroutines
@@ -500,6 +1049,7 @@ Effect::Compile(BinWriter& writer)
     }
 
 	// write FourCC code for programs
+	chunkOffsets[3] = writer.Tell();
 	writer.WriteInt('PROG');
 
 	// write amount of programs
@@ -508,10 +1058,12 @@ Effect::Compile(BinWriter& writer)
 	// compile programs for runtime
 	for (i = 0; i < this->programs.size(); i++)
 	{
+		programOffsets[i] = writer.Tell();
 		this->programs[i].Compile(writer);
 	}
 
 	// write FourCC code for variables
+	chunkOffsets[4] = writer.Tell();
 	writer.WriteInt('VARI');
 
 	// write amount of variables
@@ -524,6 +1076,7 @@ Effect::Compile(BinWriter& writer)
 	}
 
 	// write FourCC code for samplers
+	chunkOffsets[5] = writer.Tell();
 	writer.WriteInt('SAMP');
 
 	// write amount of samplers
@@ -535,6 +1088,7 @@ Effect::Compile(BinWriter& writer)
 	}
 
 	// write FourCC code for varblocks
+	chunkOffsets[6] = writer.Tell();
 	writer.WriteInt('VARB');
 
 	// write amount of varblocks
@@ -547,6 +1101,7 @@ Effect::Compile(BinWriter& writer)
 	}
 
     // write FourCC code for varbuffers
+    chunkOffsets[7] = writer.Tell();
     writer.WriteInt('VRBF');
 
     // write amount of varbuffers
@@ -557,6 +1112,89 @@ Effect::Compile(BinWriter& writer)
     {
         this->varBuffers[i].Compile(writer);
     }
+
+	// write FourCC code for permutation groups
+	chunkOffsets[8] = writer.Tell();
+	writer.WriteInt('PERM');
+
+	// write amount of permutation groups
+	writer.WriteInt(this->permutationGroups.size());
+
+	// write axes and the program table of each group
+	for (i = 0; i < this->permutationGroups.size(); i++)
+	{
+		const PermutationGroup& group = this->permutationGroups[i];
+		writer.WriteString(group.name);
+		writer.WriteUInt(group.axes.size());
+		unsigned j;
+		for (j = 0; j < group.axes.size(); j++)
+		{
+			const Program::PermutationAxis& axis = group.axes[j];
+			writer.WriteString(axis.name);
+			writer.WriteUInt(axis.shift);
+			writer.WriteUInt(axis.bits);
+			writer.WriteUInt(axis.flags.size());
+			unsigned k;
+			for (k = 0; k < axis.flags.size(); k++)
+			{
+				writer.WriteString(axis.flags[k]);
+			}
+		}
+		writer.WriteUInt(group.programs.size());
+		for (j = 0; j < group.programs.size(); j++)
+		{
+			writer.WriteUInt(group.programs[j]);
+		}
+	}
+
+	// write FourCC code for pipeline recipes
+	chunkOffsets[9] = writer.Tell();
+	writer.WriteInt('PIPE');
+
+	// write layout of each descriptor set, then what every program needs to create its pipeline
+	std::map<unsigned, unsigned long long> setLayouts = this->HashSetLayouts();
+	unsigned long long setLayoutHash = HashString64(NULL, 0);
+	writer.WriteUInt(setLayouts.size());
+	std::map<unsigned, unsigned long long>::const_iterator setIt;
+	for (setIt = setLayouts.begin(); setIt != setLayouts.end(); setIt++)
+	{
+		writer.WriteUInt(setIt->first);
+		writer.WriteUInt64(setIt->second);
+		unsigned long long entry[] = { setIt->first, setIt->second };
+		setLayoutHash = HashString64((const char*)entry, sizeof(entry), setLayoutHash);
+	}
+
+	std::map<std::string, unsigned long long> renderStateHashes;
+	for (i = 0; i < this->renderStates.size(); i++)
+	{
+		renderStateHashes[this->renderStates[i].GetName()] = this->renderStates[i].Hash();
+	}
+	writer.WriteUInt(this->programs.size());
+	for (i = 0; i < this->programs.size(); i++)
+	{
+		this->programs[i].CompileRecipe(writer, i, renderStateHashes, setLayoutHash);
+	}
+
+	// write the selection this effect was compiled with
+	if (this->partial)
+	{
+		chunkOffsets[10] = writer.Tell();
+		writer.WriteInt('PART');
+		writer.WriteString(this->header.GetValue("/PROGRAMS"));
+	}
+
+	// patch directory with the actual offsets
+	for (i = 0; i < numChunks; i++)
+	{
+		writer.Seek(chunkTable + i * 2 * sizeof(int) + sizeof(int));
+		writer.WriteUInt(chunkOffsets[i]);
+	}
+	for (i = 0; i < this->programs.size(); i++)
+	{
+		writer.Seek(programTable[i]);
+		writer.WriteUInt(programOffsets[i]);
+	}
+	writer.SeekToEnd();
 }
 
 //------------------------------------------------------------------------------
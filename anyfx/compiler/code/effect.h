@@ -34,6 +34,10 @@ public:
 	Effect();
 	/// destructor
 	virtual ~Effect();
+	/// move constructor, the effect owns its shaders and expressions so it can't be copied
+	Effect(Effect&& rhs);
+	/// move assignment
+	Effect& operator=(Effect&& rhs);
 
 	/// sets the header object
 	void SetHeader(const Header& header);
@@ -41,25 +45,25 @@ public:
 	const Header& GetHeader() const;
 
 	/// add program definition
-	void AddProgram(const Program& program);
+	void AddProgram(Program&& program);
 	/// add variable definition
-	void AddVariable(const Variable& var);
+	void AddVariable(Variable&& var);
 	/// add constant definition
-	void AddConstant(const Constant& constant);
+	void AddConstant(Constant&& constant);
 	/// add render state
-	void AddRenderState(const RenderState& state);
+	void AddRenderState(RenderState&& state);
 	/// add function
-	void AddFunction(const Function& function);
+	void AddFunction(Function&& function);
 	/// add structure
-	void AddStructure(const Structure& structure);
+	void AddStructure(Structure&& structure);
 	/// add varblock
-	void AddVarBlock(const VarBlock& varBlock);
+	void AddVarBlock(VarBlock&& varBlock);
     /// add varbuffer
-    void AddVarBuffer(const VarBuffer& varBuffer);
+    void AddVarBuffer(VarBuffer&& varBuffer);
     /// add subroutine
-    void AddSubroutine(const Subroutine& subroutine);
+    void AddSubroutine(Subroutine&& subroutine);
 	/// add sampler
-	void AddSampler(const Sampler& sampler);
+	void AddSampler(Sampler&& sampler);
 
 	/// set the vector of passthrough macros
 	void SetPreprocessorPassthrough(const std::vector<std::string>& pps);
@@ -86,9 +90,40 @@ public:
 	static unsigned GetAlignmentGLSL(const DataType& type, unsigned arraySize, unsigned& alignedSize, unsigned& stride, unsigned& elementStride, std::vector<unsigned>& suboffsets, const bool& std140, TypeChecker& typechecker);
 
 private:
+	/// no copies
+	Effect(const Effect&) = delete;
+	/// no copies
+	Effect& operator=(const Effect&) = delete;
+
+	struct PermutationGroup
+	{
+		std::string name;
+		std::vector<Program::PermutationAxis> axes;
+		std::vector<unsigned> programs;				// program index for every mask, InvalidPermutation if the mask doesn't denote a permutation
+	};
+	static const unsigned InvalidPermutation = 0xFFFFFFFF;
+
+	/// destroy all parsed objects and shaders
+	void Clear();
+	/// replace programs declaring permutation axes with one program per combination of axis values
+	void ExpandPermutations();
+	/// keep only the programs matching the patterns given by /PROGRAMS, which makes this a partial effect
+	void SelectPrograms(const std::string& selection);
+	/// hash the layout of every descriptor set, by set
+	std::map<unsigned, unsigned long long> HashSetLayouts() const;
+	/// move the smallest varblocks to push constants until the budget given by /PUSHBUDGET is used up
+	void PromotePushConstants(TypeChecker& typechecker);
+	/// give a binding in a group back, moving every later binding in the group down by one
+	void ReleaseBinding(unsigned group, unsigned binding);
+	/// parse shaders on as many threads as the header allows
+	void ParseShaders(Generator& generator);
+	/// formats all effect-wide declarations shared by every shader stage
+	void FormatDeclarations();
+
 	Header header;
 	std::string name;
 	std::vector<Program> programs;
+	std::vector<PermutationGroup> permutationGroups;
 	std::vector<Variable> variables;
 	std::vector<Constant> constants;
 	std::vector<RenderState> renderStates;
@@ -102,10 +137,14 @@ private:
 	std::vector<std::string> passthroughPPs;
 	std::map<std::string, Shader*> shaders;
 
+	std::string declarations;
+	std::map<int, std::pair<std::string, std::string> > indexToFileMap;
+
 	RenderState placeholderRenderState;
     VarBlock placeholderVarBlock;
 
 	std::string debugOutput;
+	bool partial;
 }; 
 
 //------------------------------------------------------------------------------
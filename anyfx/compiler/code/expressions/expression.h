@@ -11,6 +11,7 @@
 //------------------------------------------------------------------------------
 #include "datatype.h"
 #include "typechecker.h"
+#include "compilearena.h"
 
 namespace AnyFX
 {
@@ -22,6 +23,11 @@ public:
 	/// destructor
 	virtual ~Expression();
 
+	/// allocate expression from the current compile arena
+	static void* operator new(size_t size);
+	/// free expression, memory from an arena is released with the arena
+	static void operator delete(void* ptr);
+
 	/// evaulate type of expression
 	virtual DataType EvalType(TypeChecker& typechecker);
 
@@ -34,5 +40,24 @@ public:
 	/// evaluates expression as a boolean
 	virtual bool EvalBool(TypeChecker& typechecker);
 }; 
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void*
+Expression::operator new(size_t size)
+{
+	return CompileArena::AllocateCurrent(size);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+Expression::operator delete(void* ptr)
+{
+	CompileArena::FreeCurrent(ptr);
+}
+
 } // namespace AnyFX
 //------------------------------------------------------------------------------
\ No newline at end of file
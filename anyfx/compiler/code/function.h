@@ -23,6 +23,14 @@ public:
 	Function();
 	/// destructor
 	virtual ~Function();
+	/// copy constructor
+	Function(const Function&) = default;
+	/// move constructor
+	Function(Function&&) = default;
+	/// copy assignment
+	Function& operator=(const Function&) = default;
+	/// move assignment
+	Function& operator=(Function&&) = default;
 	
 	/// set vector of function parameters
 	void SetParameters(const std::vector<Parameter>& parameters);
@@ -44,6 +44,7 @@ Generator::Instance()
 void
 Generator::Error(const std::string& error)
 {
+	std::lock_guard<std::mutex> lock(this->messageLock);
 	if (this->errors.find(error) == this->errors.end())
 	{
 		this->errors.insert(error);
@@ -58,6 +59,7 @@ Generator::Error(const std::string& error)
 void
 Generator::Warning(const std::string& warning)
 {
+	std::lock_guard<std::mutex> lock(this->messageLock);
 	if (this->warnings.find(warning) == this->warnings.end())
 	{
 		this->warnings.insert(warning);
@@ -11,6 +11,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include <mutex>
 #include "util.h"
 #include "header.h"
 namespace AnyFX
@@ -32,9 +33,9 @@ public:
 	/// get singleton instance
 	static Generator* Instance();
 
-	/// posts generator error
+	/// posts generator error, may be called from any thread
 	void Error(const std::string& error);
-	/// posts generator warning
+	/// posts generator warning, may be called from any thread
 	void Warning(const std::string& warning);
 
 	/// returns type checker error count
@@ -60,6 +61,7 @@ private:
 	Header header;
 	static Generator* instance;
 
+	std::mutex messageLock;
 	std::string errorBuffer;
 	std::set<std::string> errors;
 	std::set<std::string> warnings;
@@ -5,7 +5,6 @@
 #include "header.h"
 #include "util.h"
 #include "typechecker.h"
-#include <sstream>
 #include <iostream>
 
 namespace AnyFX
@@ -226,21 +225,16 @@ Header::SetFlags(const std::vector<std::string>& defines)
 		if (str == "/NOSUB" || str == "/N")				this->flags |= NoSubroutines;
 		else if (str == "/GBLOCK" || str == "/G")		this->flags |= PutGlobalVariablesInBlock;
 		else if (str == "/OUTPUT" || str == "/O")		this->flags |= OutputGeneratedShaders;
+		else if (str == "/COMPRESS")					this->flags |= CompressBinaries;
 		else
 		{
+			// the value is everything after the first space, so paths may contain spaces
 			if (str[0] == '/')
 			{
-				std::stringstream ss(str);
-				std::string item;
-				std::vector<std::string> tokens;
-				while (std::getline(ss, item, ' '))
+				size_t space = str.find(' ');
+				if (space != std::string::npos && space + 1 < str.size())
 				{
-					tokens.push_back(item);
-				}
-
-				if (tokens.size() == 2)
-				{
-					this->values[tokens[0]] = tokens[1];
+					this->values[str.substr(0, space)] = str.substr(space + 1);
 				}
 			}			
 		}
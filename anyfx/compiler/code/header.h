@@ -40,6 +40,7 @@ public:
 		NoSubroutines = 1 << 1,					// tell compiler to convert used subroutines into new shader programs instead
 		PutGlobalVariablesInBlock = 1 << 2,		// tell compiler to put variables outside variable buffer blocks into a global block, named GlobalBlock
 		OutputGeneratedShaders = 1 << 3,		// tell compiler to output each shader program to file
+		CompressBinaries = 1 << 4,				// tell compiler to canonicalize and compress shader binaries
 
 		NumFlags
 	};
@@ -48,6 +49,14 @@ public:
 	Header();
 	/// destructor
 	virtual ~Header();
+	/// copy constructor
+	Header(const Header&) = default;
+	/// move constructor
+	Header(Header&&) = default;
+	/// copy assignment
+	Header& operator=(const Header&) = default;
+	/// move assignment
+	Header& operator=(Header&&) = default;
 
 	/// sets the effect profile
 	void SetProfile(const std::string& profile);
@@ -106,8 +115,9 @@ inline const std::string&
 Header::GetValue(const std::string& str) const
 {
 	std::map<std::string, std::string>::const_iterator it = this->values.find(str);
+	static const std::string empty;
 	if (it != this->values.end()) return it->second;
-	else						  return it->first;
+	else						  return empty;
 }
 
 //------------------------------------------------------------------------------
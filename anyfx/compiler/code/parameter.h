@@ -80,6 +80,14 @@ public:
 	Parameter();
 	/// destructor
 	virtual ~Parameter();
+	/// copy constructor
+	Parameter(const Parameter&) = default;
+	/// move constructor
+	Parameter(Parameter&&) = default;
+	/// copy assignment
+	Parameter& operator=(const Parameter&) = default;
+	/// move assignment
+	Parameter& operator=(Parameter&&) = default;
 
 	/// sets io mode
 	void SetIO(const IO& io);
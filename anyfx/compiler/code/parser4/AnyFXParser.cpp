@@ -631,7 +631,7 @@ AnyFXParser::EntryContext* AnyFXParser::entry() {
      
     		dynamic_cast<EntryContext *>(_localctx)->effectContext->eff.SetPreprocessorPassthrough(uncaughtPreprocessorDirectives);
     		uncaughtPreprocessorDirectives.clear();
-    		dynamic_cast<EntryContext *>(_localctx)->returnEffect =  dynamic_cast<EntryContext *>(_localctx)->effectContext->eff; 
+    		dynamic_cast<EntryContext *>(_localctx)->returnEffect =  std::move(dynamic_cast<EntryContext *>(_localctx)->effectContext->eff); 
     	
     setState(126);
     match(AnyFXParser::EOF);
@@ -770,70 +770,70 @@ AnyFXParser::EffectContext* AnyFXParser::effect() {
         case 1: {
           setState(128);
           dynamic_cast<EffectContext *>(_localctx)->constantContext = constant();
-           _localctx->eff.AddConstant(dynamic_cast<EffectContext *>(_localctx)->constantContext->cons);
+           _localctx->eff.AddConstant(std::move(dynamic_cast<EffectContext *>(_localctx)->constantContext->cons));
           break;
         }
 
         case 2: {
           setState(131);
           dynamic_cast<EffectContext *>(_localctx)->variableContext = variable();
-           _localctx->eff.AddVariable(dynamic_cast<EffectContext *>(_localctx)->variableContext->var); 
+           _localctx->eff.AddVariable(std::move(dynamic_cast<EffectContext *>(_localctx)->variableContext->var)); 
           break;
         }
 
         case 3: {
           setState(134);
           dynamic_cast<EffectContext *>(_localctx)->renderStateContext = renderState();
-           _localctx->eff.AddRenderState(dynamic_cast<EffectContext *>(_localctx)->renderStateContext->state); 
+           _localctx->eff.AddRenderState(std::move(dynamic_cast<EffectContext *>(_localctx)->renderStateContext->state)); 
           break;
         }
 
         case 4: {
           setState(137);
           dynamic_cast<EffectContext *>(_localctx)->functionContext = function();
-           _localctx->eff.AddFunction(dynamic_cast<EffectContext *>(_localctx)->functionContext->func); 
+           _localctx->eff.AddFunction(std::move(dynamic_cast<EffectContext *>(_localctx)->functionContext->func)); 
           break;
         }
 
         case 5: {
           setState(140);
           dynamic_cast<EffectContext *>(_localctx)->programContext = program();
-           _localctx->eff.AddProgram(dynamic_cast<EffectContext *>(_localctx)->programContext->prog); 
+           _localctx->eff.AddProgram(std::move(dynamic_cast<EffectContext *>(_localctx)->programContext->prog)); 
           break;
         }
 
         case 6: {
           setState(143);
           dynamic_cast<EffectContext *>(_localctx)->structureContext = structure();
-           _localctx->eff.AddStructure(dynamic_cast<EffectContext *>(_localctx)->structureContext->struc); 
+           _localctx->eff.AddStructure(std::move(dynamic_cast<EffectContext *>(_localctx)->structureContext->struc)); 
           break;
         }
 
         case 7: {
           setState(146);
           dynamic_cast<EffectContext *>(_localctx)->varblockContext = varblock();
-           _localctx->eff.AddVarBlock(dynamic_cast<EffectContext *>(_localctx)->varblockContext->block); 
+           _localctx->eff.AddVarBlock(std::move(dynamic_cast<EffectContext *>(_localctx)->varblockContext->block)); 
           break;
         }
 
         case 8: {
           setState(149);
           dynamic_cast<EffectContext *>(_localctx)->varbufferContext = varbuffer();
-           _localctx->eff.AddVarBuffer(dynamic_cast<EffectContext *>(_localctx)->varbufferContext->buffer); 
+           _localctx->eff.AddVarBuffer(std::move(dynamic_cast<EffectContext *>(_localctx)->varbufferContext->buffer)); 
           break;
         }
 
         case 9: {
           setState(152);
           dynamic_cast<EffectContext *>(_localctx)->subroutineContext = subroutine();
-           _localctx->eff.AddSubroutine(dynamic_cast<EffectContext *>(_localctx)->subroutineContext->subrout); 
+           _localctx->eff.AddSubroutine(std::move(dynamic_cast<EffectContext *>(_localctx)->subroutineContext->subrout)); 
           break;
         }
 
         case 10: {
           setState(155);
           dynamic_cast<EffectContext *>(_localctx)->samplerContext = sampler();
-           _localctx->eff.AddSampler(dynamic_cast<EffectContext *>(_localctx)->samplerContext->samp); 
+           _localctx->eff.AddSampler(std::move(dynamic_cast<EffectContext *>(_localctx)->samplerContext->samp)); 
           break;
         }
 
@@ -10,6 +10,7 @@
 extern std::vector<std::string> uncaughtPreprocessorDirectives;
 
 #include "AnyFXToken.h"
+#include "anyfxlines.h"
 #include "../../code/qualifierexpression.h"
 #include "../../code/compileable.h"
 #include "../../code/effect.h"
@@ -112,7 +113,7 @@ public:
   		UpdateLine(stream, -1);
 
   		// assume the previous token is the latest file
-  		auto tu2 = this->lines[this->currentLine];
+  		const auto& tu2 = this->lines[this->currentLine];
   		comp->SetLine(lineOffset);
   		comp->SetPosition(token->getCharPositionInLine());
   		comp->SetFile(std::get<4>(tu2));
@@ -123,28 +124,16 @@ public:
   	{
   		::AnyFXToken* token = (::AnyFXToken*)stream->LT(index);
 
-  		// find the next parsed row which comes after the token
-  		int loop = this->currentLine;
+  		// the table is in source order, so the directive for the token is found by binary search
   		int tokenLine = token->getLine();
-  		while (loop < this->lines.size() - 1)
-  		{
-  			auto temp = this->lines[loop];
-  			if (std::get<1>(temp) > tokenLine)
-  			{
-  				loop--;
-  				break;
-  			}
-  			loop++;
-  		}
-
-  		this->currentLine = loop;
-  		auto tu2 = this->lines[this->currentLine];
+  		this->currentLine = AnyFXFindLine(this->lines, tokenLine);
+  		const auto& tu2 = this->lines[this->currentLine];
   		this->lineOffset = std::get<0>(tu2) + tokenLine;
   	}
 
   	int currentLine = 0;
   	int lineOffset = 0;
-  	std::vector<std::tuple<int, size_t, size_t, size_t, std::string>> lines;
+  	std::vector<AnyFXLine> lines;
 
 
   class StringContext;
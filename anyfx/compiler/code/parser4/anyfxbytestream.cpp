@@ -0,0 +1,119 @@
+#include "anyfxbytestream.h"
+#include "misc/Interval.h"
+#include "Exceptions.h"
+
+using namespace antlr4;
+
+//------------------------------------------------------------------------------
+/**
+*/
+AnyFXByteStream::AnyFXByteStream(const char* data, size_t size, const std::string& name) :
+	data(data),
+	length(size),
+	position(0),
+	name(name)
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnyFXByteStream::consume()
+{
+	if (this->position >= this->length)
+	{
+		throw IllegalStateException("cannot consume EOF");
+	}
+	this->position++;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+size_t
+AnyFXByteStream::LA(ssize_t i)
+{
+	if (i == 0) return 0;
+
+	// LA(-1) is the byte before the current one
+	ssize_t offset = (ssize_t)this->position + (i < 0 ? i : i - 1);
+	if (offset < 0 || offset >= (ssize_t)this->length) return IntStream::EOF;
+	return (unsigned char)this->data[offset];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ssize_t
+AnyFXByteStream::mark()
+{
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnyFXByteStream::release(ssize_t marker)
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+size_t
+AnyFXByteStream::index()
+{
+	return this->position;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnyFXByteStream::seek(size_t index)
+{
+	this->position = std::min(index, this->length);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+size_t
+AnyFXByteStream::size()
+{
+	return this->length;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+AnyFXByteStream::getSourceName() const
+{
+	return this->name.empty() ? IntStream::UNKNOWN_SOURCE_NAME : this->name;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+AnyFXByteStream::getText(const misc::Interval& interval)
+{
+	if (interval.a < 0 || interval.b < interval.a || (size_t)interval.a >= this->length) return "";
+	size_t start = (size_t)interval.a;
+	size_t stop = std::min((size_t)interval.b, this->length - 1);
+	return std::string(this->data + start, stop - start + 1);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+AnyFXByteStream::toString() const
+{
+	return std::string(this->data, this->length);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "antlr4-runtime.h"
+#include "antlr4-common.h"
+#include "CharStream.h"
+
+// char stream over a buffer it doesn't own, indexed by byte, so the text of a token is a plain copy out of the buffer
+// unlike ANTLRInputStream which converts the whole input to UTF-32 first, use with AnyFXScanner which gives tokens byte indices
+class AnyFXByteStream : public antlr4::CharStream
+{
+public:
+	/// construct over buffer, which must outlive the stream and the tokens read from it
+	AnyFXByteStream(const char* data, size_t size, const std::string& name = "");
+
+	/// move to next byte
+	virtual void consume() override;
+	/// look at byte relative to the current position, 1 is the current one
+	virtual size_t LA(ssize_t i) override;
+	/// nothing to mark, the whole buffer is there
+	virtual ssize_t mark() override;
+	/// nothing to release
+	virtual void release(ssize_t marker) override;
+	/// get current position
+	virtual size_t index() override;
+	/// set current position
+	virtual void seek(size_t index) override;
+	/// get size in bytes
+	virtual size_t size() override;
+	/// get name of source
+	virtual std::string getSourceName() const override;
+	/// get bytes in inclusive range
+	virtual std::string getText(const antlr4::misc::Interval& interval) override;
+	/// get whole buffer
+	virtual std::string toString() const override;
+
+private:
+	const char* data;
+	size_t length;
+	size_t position;
+	std::string name;
+};
@@ -4,21 +4,7 @@
 
 void AnyFXLexerHandler::syntaxError(antlr4::Recognizer* recognizer, antlr4::Token* offendingSymbol, size_t line, size_t charPositionInLine, const std::string& msg, std::exception_ptr e)
 {
-	// find the next parsed row which comes after the token
-	int loop = 0;
-	int tokenLine = line;
-	while (loop < this->lines.size() - 1)
-	{
-		auto temp = this->lines[loop];
-		if (std::get<1>(temp) > tokenLine)
-		{
-			loop--;
-			break;
-		}
-		loop++;
-	}
-
-	auto tu2 = this->lines[loop];
+	const auto& tu2 = this->lines[AnyFXFindLine(this->lines, line)];
 	std::string file = std::get<4>(tu2);
 	file = file.substr(1, file.length() - 2); // remove trailing "
 	int correctedLine = std::get<0>(tu2);
@@ -29,21 +15,7 @@ void AnyFXLexerHandler::syntaxError(antlr4::Recognizer* recognizer, antlr4::Toke
 
 void AnyFXParserHandler::syntaxError(antlr4::Recognizer* recognizer, antlr4::Token* offendingSymbol, size_t line, size_t charPositionInLine, const std::string& msg, std::exception_ptr e)
 {
-	// find the next parsed row which comes after the token
-	int loop = 0;
-	int tokenLine = line;
-	while (loop < this->lines.size() - 1)
-	{
-		auto temp = this->lines[loop];
-		if (std::get<1>(temp) > tokenLine)
-		{
-			loop--;
-			break;
-		}
-		loop++;
-	}
-
-	auto tu2 = this->lines[loop];
+	const auto& tu2 = this->lines[AnyFXFindLine(this->lines, line)];
 	std::string file = std::get<4>(tu2);
 	file = file.substr(1, file.length() - 2); // remove trailing "
 	int correctedLine = std::get<0>(tu2);
@@ -2,6 +2,7 @@
 #include "antlr4-runtime.h"
 #include "antlr4-common.h"
 #include "BaseErrorListener.h"
+#include "anyfxlines.h"
 
 class AnyFXLexerHandler : public antlr4::BaseErrorListener
 {
@@ -12,7 +13,7 @@ public:
 	bool hasError = false;
 	std::string errorBuffer;
 	std::string warningBuffer;
-	std::vector<std::tuple<int, size_t, size_t, size_t, std::string>> lines;
+	std::vector<AnyFXLine> lines;
 };
 
 class AnyFXParserHandler : public antlr4::BaseErrorListener
@@ -24,5 +25,5 @@ public:
 	bool hasError = false;
 	std::string errorBuffer;
 	std::string warningBuffer;
-	std::vector<std::tuple<int, size_t, size_t, size_t, std::string>> lines;
+	std::vector<AnyFXLine> lines;
 };
\ No newline at end of file
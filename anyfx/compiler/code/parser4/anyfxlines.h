@@ -0,0 +1,16 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <string>
+#include <algorithm>
+
+// one entry per #line directive left by the preprocessor, in source order:
+// line offset into the original file, line of the directive in the preprocessed source, start and end of the directive, and the quoted file name
+typedef std::tuple<int, size_t, size_t, size_t, std::string> AnyFXLine;
+
+// find the directive which applies to a line in the preprocessed source, which is the last one at or before it
+inline size_t AnyFXFindLine(const std::vector<AnyFXLine>& lines, size_t line)
+{
+	auto it = std::upper_bound(lines.begin(), lines.end(), line, [](size_t value, const AnyFXLine& entry) { return value < std::get<1>(entry); });
+	return it == lines.begin() ? 0 : (size_t)(it - lines.begin()) - 1;
+}
@@ -0,0 +1,472 @@
+#include "anyfxscanner.h"
+#include "AnyFXLexer.h"
+#include <cstring>
+#include <cassert>
+
+using namespace antlr4;
+
+namespace
+{
+
+enum CharClass
+{
+	Digit = 1 << 0,
+	Alpha = 1 << 1,
+	Underscore = 1 << 2,
+	Space = 1 << 3,
+	HexDigit = 1 << 4,		// lower case only, like the grammar
+	Word = Digit | Alpha | Underscore
+};
+
+struct CharTable
+{
+	unsigned char classes[256];
+
+	CharTable()
+	{
+		memset(this->classes, 0, sizeof(this->classes));
+		int c;
+		for (c = '0'; c <= '9'; c++) this->classes[c] |= Digit | HexDigit;
+		for (c = 'a'; c <= 'z'; c++) this->classes[c] |= Alpha;
+		for (c = 'A'; c <= 'Z'; c++) this->classes[c] |= Alpha;
+		for (c = 'a'; c <= 'f'; c++) this->classes[c] |= HexDigit;
+		this->classes['_'] |= Underscore;
+		this->classes['\t'] |= Space;
+		this->classes[' '] |= Space;
+		this->classes['\r'] |= Space;
+		this->classes['\n'] |= Space;
+		this->classes['\f'] |= Space;
+	}
+};
+const CharTable charTable;
+
+struct Keyword
+{
+	const char* text;
+	size_t type;
+};
+
+// literals of the grammar in token type order, '#line' is handled with '#'
+const Keyword keywords[] =
+{
+	{ "true", AnyFXLexer::T__0 }, { "false", AnyFXLexer::T__1 }, { "const", AnyFXLexer::T__3 }, { "shared", AnyFXLexer::T__4 }, { "push", AnyFXLexer::T__5 }, { "flat", AnyFXLexer::T__6 }, { "noperspective", AnyFXLexer::T__7 }, { "patch", AnyFXLexer::T__8 },
+	{ "in", AnyFXLexer::T__9 }, { "out", AnyFXLexer::T__10 }, { "inout", AnyFXLexer::T__11 }, { "groupshared", AnyFXLexer::T__12 },
+	{ "rgba32f", AnyFXLexer::T__13 }, { "rgba16f", AnyFXLexer::T__14 }, { "rg32f", AnyFXLexer::T__15 }, { "rg16f", AnyFXLexer::T__16 }, { "r11g11b10f", AnyFXLexer::T__17 }, { "r32f", AnyFXLexer::T__18 }, { "r16f", AnyFXLexer::T__19 },
+	{ "rgba16", AnyFXLexer::T__20 }, { "rgba8", AnyFXLexer::T__21 }, { "rgb10a2", AnyFXLexer::T__22 }, { "rg16", AnyFXLexer::T__23 }, { "rg8", AnyFXLexer::T__24 }, { "r16", AnyFXLexer::T__25 }, { "r8", AnyFXLexer::T__26 },
+	{ "rgba16snorm", AnyFXLexer::T__27 }, { "rgba8snorm", AnyFXLexer::T__28 }, { "rg16snorm", AnyFXLexer::T__29 }, { "rg8snorm", AnyFXLexer::T__30 }, { "r16snorm", AnyFXLexer::T__31 }, { "r8snorm", AnyFXLexer::T__32 },
+	{ "rgba32i", AnyFXLexer::T__33 }, { "rgba16i", AnyFXLexer::T__34 }, { "rgba8i", AnyFXLexer::T__35 }, { "rg32i", AnyFXLexer::T__36 }, { "rg16i", AnyFXLexer::T__37 }, { "rg8i", AnyFXLexer::T__38 }, { "r32i", AnyFXLexer::T__39 }, { "r16i", AnyFXLexer::T__40 }, { "r8i", AnyFXLexer::T__41 },
+	{ "rgba32ui", AnyFXLexer::T__42 }, { "rgba16ui", AnyFXLexer::T__43 }, { "rgba8ui", AnyFXLexer::T__44 }, { "rg32ui", AnyFXLexer::T__45 }, { "rg16ui", AnyFXLexer::T__46 }, { "rg8ui", AnyFXLexer::T__47 }, { "r32ui", AnyFXLexer::T__48 }, { "r16ui", AnyFXLexer::T__49 }, { "r8ui", AnyFXLexer::T__50 },
+	{ "read", AnyFXLexer::T__51 }, { "write", AnyFXLexer::T__52 }, { "readwrite", AnyFXLexer::T__53 }, { "group", AnyFXLexer::T__54 }, { "index", AnyFXLexer::T__55 }, { "struct", AnyFXLexer::T__56 }, { "varblock", AnyFXLexer::T__57 }, { "varbuffer", AnyFXLexer::T__58 },
+	{ "prototype", AnyFXLexer::T__59 }, { "subroutine", AnyFXLexer::T__60 }, { "feedback", AnyFXLexer::T__61 }, { "slot", AnyFXLexer::T__62 }, { "shader", AnyFXLexer::T__63 }, { "state", AnyFXLexer::T__64 }, { "samplerstate", AnyFXLexer::T__65 },
+	{ "RenderState", AnyFXLexer::T__66 }, { "CompileFlags", AnyFXLexer::T__67 }, { "program", AnyFXLexer::T__68 }
+};
+const size_t MaxKeywordLength = 13;
+
+// keywords bucketed by length, so an identifier is only compared to the few of the same length
+struct KeywordTable
+{
+	std::vector<const Keyword*> buckets[MaxKeywordLength + 1];
+
+	KeywordTable()
+	{
+		for (const Keyword& keyword : keywords)
+		{
+			size_t length = strlen(keyword.text);
+			assert(length <= MaxKeywordLength);
+			this->buckets[length].push_back(&keyword);
+		}
+	}
+};
+const KeywordTable keywordTable;
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+Is(const char* data, size_t size, size_t pos, unsigned char classes)
+{
+	return pos < size && (charTable.classes[(unsigned char)data[pos]] & classes) != 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline char
+At(const char* data, size_t size, size_t pos)
+{
+	return pos < size ? data[pos] : '\0';
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline size_t
+Run(const char* data, size_t size, size_t pos, unsigned char classes)
+{
+	size_t end = pos;
+	while (Is(data, size, end, classes)) end++;
+	return end - pos;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Length of an exponent at pos, 0 if there is none, a sign without digits isn't one.
+*/
+size_t
+Exponent(const char* data, size_t size, size_t pos)
+{
+	char c = At(data, size, pos);
+	if (c != 'e' && c != 'E') return 0;
+	size_t end = pos + 1;
+	c = At(data, size, end);
+	if (c == '+' || c == '-') end++;
+	size_t digits = Run(data, size, end, Digit);
+	return digits > 0 ? end + digits - pos : 0;
+}
+
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+AnyFXScanner::AnyFXScanner(const char* data, size_t size, CharStream* stream) :
+	data(data),
+	size(size),
+	pos(0),
+	line(1),
+	column(0),
+	file(0),
+	nextFile(0),
+	nextFileLine(0),
+	stream(stream),
+	factory(AnyFXTokenFactory::DEFAULT)
+{
+	// the generated lexer never sees a byte order mark
+	if (size >= 3 && memcmp(data, "\xef\xbb\xbf", 3) == 0)
+	{
+		this->pos = 3;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Like the generated lexer, a character no rule starts with is reported and skipped.
+*/
+std::unique_ptr<Token>
+AnyFXScanner::nextToken()
+{
+	while (this->pos < this->size)
+	{
+		size_t start = this->pos;
+		size_t startLine = this->line;
+		size_t startColumn = this->column;
+
+		size_t type;
+		size_t length = this->Match(type);
+		if (length == 0)
+		{
+			// skip the whole code point
+			length = 1;
+			while (this->pos + length < this->size && ((unsigned char)this->data[this->pos + length] & 0xC0) == 0x80) length++;
+
+			std::string msg = "token recognition error at: '" + std::string(this->data + this->pos, length) + "'";
+			for (ANTLRErrorListener* listener : this->listeners)
+			{
+				listener->syntaxError(nullptr, nullptr, startLine, startColumn, msg, nullptr);
+			}
+			this->Advance(length);
+			continue;
+		}
+
+		this->Advance(length);
+		if (type == AnyFXLexer::T__2) this->ReadLineDirective(startLine);
+		if (startLine >= this->nextFileLine) this->file = this->nextFile;
+
+		size_t channel = (type == AnyFXLexer::WS || type == AnyFXLexer::COMMENT || type == AnyFXLexer::ML_COMMENT) ? Token::HIDDEN_CHANNEL : Token::DEFAULT_CHANNEL;
+		std::unique_ptr<CommonToken> token = this->factory->create({ this, this->stream }, type, "", channel, start, this->pos - 1, startLine, startColumn);
+		static_cast<AnyFXToken*>(token.get())->file = this->file;
+		return token;
+	}
+
+	std::unique_ptr<CommonToken> token = this->factory->create({ this, this->stream }, Token::EOF, "", Token::DEFAULT_CHANNEL, this->pos, this->pos - 1, this->line, this->column);
+	static_cast<AnyFXToken*>(token.get())->file = this->file;
+	return token;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Reads the file name of the directive at the current position, which names the file of the lines after it.
+	The directive itself still belongs to the file it is in, a directive without a file name keeps the current one.
+*/
+void
+AnyFXScanner::ReadLineDirective(size_t directiveLine)
+{
+	size_t end = this->pos;
+	while (At(this->data, this->size, end) == ' ' || At(this->data, this->size, end) == '\t') end++;
+	size_t digits = Run(this->data, this->size, end, Digit);
+	if (digits == 0) return;
+	end += digits;
+	while (At(this->data, this->size, end) == ' ' || At(this->data, this->size, end) == '\t') end++;
+	if (At(this->data, this->size, end) != '"') return;
+
+	size_t name = end + 1;
+	for (end = name; end < this->size && this->data[end] != '"' && this->data[end] != '\n'; end++);
+	if (At(this->data, this->size, end) != '"') return;
+
+	this->nextFile = AnyFXToken::InternFile(std::string(this->data + name, end - name));
+	this->nextFileLine = directiveLine + 1;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Follows the lexer rules, the longest match wins and if two rules match as much the one declared first does,
+	which is why keywords beat identifiers, a lone '.' is DOT and 'e5' is an EXPONENT.
+*/
+size_t
+AnyFXScanner::Match(size_t& type) const
+{
+	const char* data = this->data;
+	const size_t size = this->size;
+	const size_t pos = this->pos;
+	const char c = data[pos];
+
+	// identifiers and keywords
+	if (Is(data, size, pos, Alpha))
+	{
+		size_t length = Run(data, size, pos, Word);
+		size_t exponent = Exponent(data, size, pos);
+		if (exponent >= length)
+		{
+			type = AnyFXLexer::EXPONENT;
+			return exponent;
+		}
+
+		type = AnyFXLexer::IDENTIFIER;
+		if (length <= MaxKeywordLength)
+		{
+			for (const Keyword* keyword : keywordTable.buckets[length])
+			{
+				if (memcmp(keyword->text, data + pos, length) == 0)
+				{
+					type = keyword->type;
+					break;
+				}
+			}
+		}
+		return length;
+	}
+	if (c == '_')
+	{
+		// leading underscores only make an identifier if a letter follows them
+		size_t underscores = Run(data, size, pos, Underscore);
+		if (Is(data, size, pos + underscores, Alpha))
+		{
+			type = AnyFXLexer::IDENTIFIER;
+			return Run(data, size, pos, Word);
+		}
+		type = AnyFXLexer::UNDERSC;
+		return 1;
+	}
+
+	// numbers, which may also start with a dot
+	if (Is(data, size, pos, Digit) || c == '.')
+	{
+		if (c == '0' && At(data, size, pos + 1) == 'x')
+		{
+			type = AnyFXLexer::HEX;
+			return 2 + Run(data, size, pos + 2, HexDigit);
+		}
+
+		size_t digits = Run(data, size, pos, Digit);
+		size_t length = digits > 0 ? digits : 1;
+		type = digits > 0 ? AnyFXLexer::INTEGERLITERAL : AnyFXLexer::DOT;
+
+		size_t end = pos + digits;
+		bool fraction = At(data, size, end) == '.';
+		if (fraction)
+		{
+			end++;
+			end += Run(data, size, end, Digit);
+		}
+		size_t exponent = Exponent(data, size, end);
+		end += exponent;
+
+		if (At(data, size, end) == 'f')
+		{
+			type = AnyFXLexer::FLOATLITERAL;
+			return end + 1 - pos;
+		}
+		if ((fraction || exponent > 0) && end - pos > length)
+		{
+			type = AnyFXLexer::DOUBLELITERAL;
+			return end - pos;
+		}
+		return length;
+	}
+
+	if (Is(data, size, pos, Space))
+	{
+		type = AnyFXLexer::WS;
+		return Run(data, size, pos, Space);
+	}
+
+	const char next = At(data, size, pos + 1);
+	switch (c)
+	{
+	case '/':
+		// unterminated comments don't match, leaving a division
+		if (next == '/')
+		{
+			const void* end = memchr(data + pos + 2, '\n', size - pos - 2);
+			if (end != nullptr)
+			{
+				type = AnyFXLexer::COMMENT;
+				return (const char*)end + 1 - (data + pos);
+			}
+		}
+		else if (next == '*')
+		{
+			size_t end;
+			for (end = pos + 2; end + 1 < size; end++)
+			{
+				if (data[end] == '*' && data[end + 1] == '/')
+				{
+					type = AnyFXLexer::ML_COMMENT;
+					return end + 2 - pos;
+				}
+			}
+		}
+		type = AnyFXLexer::DIV_OP;
+		return 1;
+	case '#':
+		if (size - pos >= 5 && memcmp(data + pos + 1, "line", 4) == 0)
+		{
+			type = AnyFXLexer::T__2;
+			return 5;
+		}
+		type = AnyFXLexer::NU;
+		return 1;
+	case '<':
+		type = next == '=' ? AnyFXLexer::LESSEQ : AnyFXLexer::LESS;
+		return next == '=' ? 2 : 1;
+	case '>':
+		type = next == '=' ? AnyFXLexer::GREATEREQ : AnyFXLexer::GREATER;
+		return next == '=' ? 2 : 1;
+	case '=':
+		type = next == '=' ? AnyFXLexer::LOGICEQ : AnyFXLexer::EQ;
+		return next == '=' ? 2 : 1;
+	case '!':
+		type = next == '=' ? AnyFXLexer::NOTEQ : AnyFXLexer::NOT;
+		return next == '=' ? 2 : 1;
+	case '&':
+		type = next == '&' ? AnyFXLexer::LOGICAND : AnyFXLexer::AND;
+		return next == '&' ? 2 : 1;
+	case '|':
+		type = next == '|' ? AnyFXLexer::LOGICOR : AnyFXLexer::OR;
+		return next == '|' ? 2 : 1;
+	case ';': type = AnyFXLexer::SC; return 1;
+	case ',': type = AnyFXLexer::CO; return 1;
+	case ':': type = AnyFXLexer::COL; return 1;
+	case '(': type = AnyFXLexer::LP; return 1;
+	case ')': type = AnyFXLexer::RP; return 1;
+	case '{': type = AnyFXLexer::LB; return 1;
+	case '}': type = AnyFXLexer::RB; return 1;
+	case '[': type = AnyFXLexer::LL; return 1;
+	case ']': type = AnyFXLexer::RR; return 1;
+	case '"': type = AnyFXLexer::QO; return 1;
+	case '?': type = AnyFXLexer::QU; return 1;
+	case '\'': type = AnyFXLexer::Q; return 1;
+	case '\\': type = AnyFXLexer::FORWARDSLASH; return 1;
+	case '%': type = AnyFXLexer::MOD; return 1;
+	case '+': type = AnyFXLexer::ADD_OP; return 1;
+	case '-': type = AnyFXLexer::SUB_OP; return 1;
+	case '*': type = AnyFXLexer::MUL_OP; return 1;
+	default: return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Continuation bytes of UTF-8 sequences don't count towards the column.
+*/
+void
+AnyFXScanner::Advance(size_t bytes)
+{
+	const size_t end = this->pos + bytes;
+	for (; this->pos < end; this->pos++)
+	{
+		const unsigned char c = (unsigned char)this->data[this->pos];
+		if (c == '\n')
+		{
+			this->line++;
+			this->column = 0;
+		}
+		else if ((c & 0xC0) != 0x80)
+		{
+			this->column++;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+size_t
+AnyFXScanner::getLine() const
+{
+	return this->line;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+size_t
+AnyFXScanner::getCharPositionInLine()
+{
+	return this->column;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+CharStream*
+AnyFXScanner::getInputStream()
+{
+	return this->stream;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+AnyFXScanner::getSourceName()
+{
+	return this->stream != nullptr ? this->stream->getSourceName() : IntStream::UNKNOWN_SOURCE_NAME;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Ref<TokenFactory<CommonToken>>
+AnyFXScanner::getTokenFactory()
+{
+	return this->factory;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnyFXScanner::setTokenFactory(const Ref<TokenFactory<CommonToken>>& factory)
+{
+	this->factory = factory;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnyFXScanner::addErrorListener(ANTLRErrorListener* listener)
+{
+	this->listeners.push_back(listener);
+}
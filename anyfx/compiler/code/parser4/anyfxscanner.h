@@ -0,0 +1,56 @@
+#pragma once
+#include "antlr4-runtime.h"
+#include "antlr4-common.h"
+#include "TokenSource.h"
+#include "ANTLRErrorListener.h"
+#include "anyfxtoken.h"
+
+// hand written replacement for the generated AnyFXLexer, scans the preprocessed bytes directly and produces the same tokens,
+// with the same types, channels, positions and errors, so AnyFXParser can't tell the difference
+//
+// token start and stop are byte offsets into the buffer, so the char stream tokens read their text from must be indexed by byte like
+// AnyFXByteStream, columns are still counted in code points so errors point where the generated lexer would
+class AnyFXScanner : public antlr4::TokenSource
+{
+public:
+	/// construct from preprocessed source, stream must be over the same bytes and is where tokens read their text from
+	AnyFXScanner(const char* data, size_t size, antlr4::CharStream* stream);
+
+	/// scan next token, hidden tokens are returned too since function bodies are reconstructed from them
+	virtual std::unique_ptr<antlr4::Token> nextToken() override;
+	/// get line of current position, starts at 1
+	virtual size_t getLine() const override;
+	/// get column of current position, starts at 0
+	virtual size_t getCharPositionInLine() override;
+	/// get stream tokens read their text from
+	virtual antlr4::CharStream* getInputStream() override;
+	/// get name of stream
+	virtual std::string getSourceName() override;
+	/// get token factory
+	virtual Ref<antlr4::TokenFactory<antlr4::CommonToken>> getTokenFactory() override;
+
+	/// set token factory
+	void setTokenFactory(const Ref<antlr4::TokenFactory<antlr4::CommonToken>>& factory);
+	/// add listener which gets token recognition errors, reported the same way the ANTLR lexer does
+	void addErrorListener(antlr4::ANTLRErrorListener* listener);
+
+private:
+	/// get length in bytes of the longest token at the current position, and its type
+	size_t Match(size_t& type) const;
+	/// move past bytes, updating line and column
+	void Advance(size_t bytes);
+	/// read file name of the #line directive just scanned, tokens after the directive's line get it
+	void ReadLineDirective(size_t directiveLine);
+
+	const char* data;
+	size_t size;
+	size_t pos;
+	size_t line;
+	size_t column;
+	unsigned file;
+	unsigned nextFile;
+	size_t nextFileLine;
+	antlr4::CharStream* stream;
+	Ref<antlr4::TokenFactory<antlr4::CommonToken>> factory;
+	std::vector<antlr4::ANTLRErrorListener*> listeners;
+};
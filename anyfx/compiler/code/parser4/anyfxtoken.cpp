@@ -1,4 +1,84 @@
 #include "anyfxtoken.h"
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cstddef>
+
+namespace
+{
+
+// fixed size slots handed out from large chunks, freed slots are linked through their first bytes
+struct TokenPool
+{
+	static const size_t SlotSize = (sizeof(AnyFXToken) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+	static const size_t SlotsPerChunk = 4096;
+
+	std::vector<std::unique_ptr<char[]>> chunks;
+	size_t used = SlotsPerChunk;
+	void* freeList = nullptr;
+};
+
+// lexing and parsing happen on the thread running the compile, so each thread gets its own pool
+thread_local TokenPool pool;
+
+std::mutex fileLock;
+std::deque<std::string> fileNames(1);
+std::unordered_map<std::string, unsigned> fileIndices = { { std::string(), 0 } };
+
+}
+
+void* AnyFXToken::operator new(size_t size)
+{
+	// classes deriving from the token don't fit the slots
+	if (size != sizeof(AnyFXToken))
+	{
+		return ::operator new(size);
+	}
+
+	if (pool.freeList != nullptr)
+	{
+		void* ptr = pool.freeList;
+		pool.freeList = *(void**)ptr;
+		return ptr;
+	}
+
+	if (pool.used == TokenPool::SlotsPerChunk)
+	{
+		pool.chunks.emplace_back(new char[TokenPool::SlotSize * TokenPool::SlotsPerChunk]);
+		pool.used = 0;
+	}
+	return pool.chunks.back().get() + TokenPool::SlotSize * pool.used++;
+}
+
+void AnyFXToken::operator delete(void* ptr, size_t size)
+{
+	if (ptr == nullptr) return;
+	if (size != sizeof(AnyFXToken))
+	{
+		::operator delete(ptr);
+		return;
+	}
+	*(void**)ptr = pool.freeList;
+	pool.freeList = ptr;
+}
+
+unsigned AnyFXToken::InternFile(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(fileLock);
+	auto it = fileIndices.find(name);
+	if (it != fileIndices.end()) return it->second;
+	unsigned index = (unsigned)fileNames.size();
+	fileNames.push_back(name);
+	fileIndices.emplace(name, index);
+	return index;
+}
+
+const std::string& AnyFXToken::GetFileName(unsigned index)
+{
+	// deque elements never move, so the reference outlives the lock
+	std::lock_guard<std::mutex> lock(fileLock);
+	return fileNames[index];
+}
 
 const Ref<TokenFactory<CommonToken>> AnyFXTokenFactory::DEFAULT = std::make_shared<AnyFXTokenFactory>();
 
@@ -10,7 +90,9 @@ std::unique_ptr<CommonToken> AnyFXTokenFactory::create(std::pair<TokenSource*, C
 	std::unique_ptr<AnyFXToken> t(new AnyFXToken(source, type, channel, start, stop));
 	t->setLine(line);
 	t->setCharPositionInLine(charPositionInLine);
-	if (text != "")
+
+	// the lexer only passes text it changed, otherwise the token reads its text from the input stream when asked
+	if (!text.empty())
 	{
 		t->setText(text);
 	}
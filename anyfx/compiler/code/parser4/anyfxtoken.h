@@ -29,7 +29,20 @@ public:
 		file = ((AnyFXToken*)oldToken)->file;
 	};
 
-	std::string file;
+	/// tokens come from a pool which keeps freed tokens for the next ones, since there is one per character range of the input
+	static void* operator new(size_t size);
+	/// return token to the pool
+	static void operator delete(void* ptr, size_t size);
+
+	/// intern file name, every distinct name gets one index, 0 is the empty name
+	static unsigned InternFile(const std::string& name);
+	/// get interned file name
+	static const std::string& GetFileName(unsigned index);
+
+	/// get name of file token comes from
+	const std::string& getFile() const { return GetFileName(file); };
+
+	unsigned file = 0;
 };
 
 class ANTLR4CPP_PUBLIC AnyFXTokenFactory : public TokenFactory<CommonToken>
@@ -8,6 +8,20 @@
 #include <sstream>
 #include "generator.h"
 #include "SPIRV/GlslangToSpv.h"
+#include "SPIRV/SPVRemapper.h"
+#include "compression.h"
+#include "binreader.h"
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+// masks wider than this would need a lookup table too large to be worth it
+static const unsigned MaxPermutationBits = 16;
+
+// bump when the layout of cache entries changes, or when anything feeding glslang changes without showing up in the sources
+static const unsigned SPIRVCacheVersion = 1;
+
 namespace AnyFX
 {
 
@@ -16,7 +30,11 @@ namespace AnyFX
 /**
 */
 Program::Program() :
+	pushConstantOffset(0),
+	pushConstantSize(0),
+	vertexLayoutHash(0),
 	patchSize(0),
+	compressBinaries(false),
 	hasAnnotation(false)
 {
 	this->symbolType = Symbol::ProgramType;
@@ -93,6 +111,18 @@ Program::TypeCheck(TypeChecker& typechecker)
 		typechecker.Error(msg);
 	}
 
+	for (i = 0; i < this->permutationErrors.size(); i++)
+	{
+		std::string msg = Format("%s, %s\n", this->permutationErrors[i].c_str(), this->ErrorSuffix().c_str());
+		typechecker.Error(msg);
+	}
+
+	for (i = 0; i < this->invalidSpecializations.size(); i++)
+	{
+		std::string msg = Format("Invalid value in compile flag '%s' for specialization constant, %s\n", this->invalidSpecializations[i].c_str(), this->ErrorSuffix().c_str());
+		typechecker.Error(msg);
+	}
+
     // make sure that subroutine bindings are valid, traverse all possible program rows besides the render state
     for (i = 0; i < ProgramRow::NumProgramRows-1; i++)
     {
@@ -103,14 +133,14 @@ Program::TypeCheck(TypeChecker& typechecker)
         std::map<std::string, std::string>::const_iterator it;
         for (it = mappings.begin(); it != mappings.end(); it++)
         {
-            if (!typechecker.HasSymbol((*it).first))
+            Symbol* sym = typechecker.FindSymbol((*it).first);
+            if (sym == NULL)
             {
                 std::string msg = AnyFX::Format("Subroutine interface '%s' is not defined, %s\n", (*it).first.c_str(), this->ErrorSuffix().c_str());
                 typechecker.Error(msg);
             }
             else
             {
-                Symbol* sym = typechecker.GetSymbol((*it).first);
                 if (sym->GetType() == Symbol::VariableType)
                 {
                     Variable* sub = (Variable*)sym;
@@ -127,14 +157,14 @@ Program::TypeCheck(TypeChecker& typechecker)
                 }
             }
 
-            if (!typechecker.HasSymbol((*it).second))
+            sym = typechecker.FindSymbol((*it).second);
+            if (sym == NULL)
             {
                 std::string msg = AnyFX::Format("Subroutine implementation '%s' is not defined, %s\n", (*it).second.c_str(), this->ErrorSuffix().c_str());
                 typechecker.Error(msg);
             }
             else
             {
-                Symbol* sym = typechecker.GetSymbol((*it).second);
                 if (sym->GetType() == Symbol::SubroutineType)
                 {
                     Subroutine* sub = (Subroutine*)sym;
@@ -160,14 +190,14 @@ Program::TypeCheck(TypeChecker& typechecker)
     }
 	
 	// get shaders
-	Function* vs = typechecker.HasSymbol(this->slotNames[ProgramRow::VertexShader])		? dynamic_cast<Function*>(typechecker.GetSymbol(this->slotNames[ProgramRow::VertexShader]))		: NULL;
-	Function* ps = typechecker.HasSymbol(this->slotNames[ProgramRow::PixelShader])		? dynamic_cast<Function*>(typechecker.GetSymbol(this->slotNames[ProgramRow::PixelShader]))		: NULL;
-	Function* hs = typechecker.HasSymbol(this->slotNames[ProgramRow::HullShader])		? dynamic_cast<Function*>(typechecker.GetSymbol(this->slotNames[ProgramRow::HullShader]))		: NULL;
-	Function* ds = typechecker.HasSymbol(this->slotNames[ProgramRow::DomainShader])		? dynamic_cast<Function*>(typechecker.GetSymbol(this->slotNames[ProgramRow::DomainShader]))		: NULL;
-	Function* gs = typechecker.HasSymbol(this->slotNames[ProgramRow::GeometryShader])	? dynamic_cast<Function*>(typechecker.GetSymbol(this->slotNames[ProgramRow::GeometryShader]))	: NULL;
-	Function* cs = typechecker.HasSymbol(this->slotNames[ProgramRow::ComputeShader])	? dynamic_cast<Function*>(typechecker.GetSymbol(this->slotNames[ProgramRow::ComputeShader]))	: NULL;
-
-	RenderState* renderState = typechecker.HasSymbol(this->slotNames[ProgramRow::RenderState]) ? dynamic_cast<RenderState*>(typechecker.GetSymbol(this->slotNames[ProgramRow::RenderState]))	: NULL;
+	Function* vs = typechecker.FindFunction(this->slotNames[ProgramRow::VertexShader]);
+	Function* ps = typechecker.FindFunction(this->slotNames[ProgramRow::PixelShader]);
+	Function* hs = typechecker.FindFunction(this->slotNames[ProgramRow::HullShader]);
+	Function* ds = typechecker.FindFunction(this->slotNames[ProgramRow::DomainShader]);
+	Function* gs = typechecker.FindFunction(this->slotNames[ProgramRow::GeometryShader]);
+	Function* cs = typechecker.FindFunction(this->slotNames[ProgramRow::ComputeShader]);
+
+	RenderState* renderState = typechecker.FindRenderState(this->slotNames[ProgramRow::RenderState]);
 	if (!renderState)
 	{
 		std::string message = AnyFX::Format("RenderState '%s' undefined, %s\n", this->slotNames[ProgramRow::RenderState].c_str(), this->ErrorSuffix().c_str());
@@ -476,6 +506,7 @@ Program::Generate(Generator& generator)
 	// now generate target language specifics
 	Header::Type type = generator.GetHeader().GetType();
 	int major = generator.GetHeader().GetMajor();
+	this->compressBinaries = (generator.GetHeader().GetFlags() & Header::CompressBinaries) != 0;
 	switch (type)
 	{
 	case Header::GLSL:
@@ -558,6 +589,43 @@ Program::Compile(BinWriter& writer)
 		}
 	}
 
+	// write vertex input types and where they would go in a tightly packed vertex, in slot order, which lets the runtime build attribute descriptions without knowing the mesh
+	if (this->slotMask[ProgramRow::VertexShader])
+	{
+		std::vector<const Parameter*> inputs = this->shaders[ProgramRow::VertexShader]->GetFunction().GetInputParameters();
+		std::vector<unsigned> offsets(inputs.size());
+		std::vector<unsigned> order(inputs.size());
+		unsigned i;
+		for (i = 0; i < order.size(); i++) order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&inputs](unsigned a, unsigned b) { return inputs[a]->GetSlot() < inputs[b]->GetSlot(); });
+
+		unsigned stride = 0;
+		for (i = 0; i < order.size(); i++)
+		{
+			const Parameter* input = inputs[order[i]];
+			offsets[order[i]] = stride;
+
+			// attributes are kept 4 byte aligned, which all vertex formats allow
+			unsigned size = (DataType::ToByteSize(input->GetDataType()) + 3) & ~3;
+			stride += size * (input->IsArray() ? input->GetArraySize() : 1);
+		}
+
+		this->vertexLayoutHash = HashString64((const char*)&stride, sizeof(stride));
+		for (i = 0; i < inputs.size(); i++)
+		{
+			unsigned input[] = { inputs[i]->GetSlot(), (unsigned)inputs[i]->GetDataType().GetType(), inputs[i]->IsArray() ? inputs[i]->GetArraySize() : 1, offsets[i] };
+			writer.WriteInt(input[1]);
+			writer.WriteUInt(input[2]);
+			writer.WriteUInt(input[3]);
+			this->vertexLayoutHash = HashString64((const char*)input, sizeof(input), this->vertexLayoutHash);
+		}
+		writer.WriteUInt(stride);
+	}
+	else
+	{
+		writer.WriteUInt(0);
+	}
+
     // write geometry shader boolean which tells us we can use transform feedbacks
     writer.WriteBool(this->slotMask[ProgramRow::GeometryShader]);
 
@@ -566,7 +634,7 @@ Program::Compile(BinWriter& writer)
 
 	// write shader programs
 	writer.WriteInt('VERT');
-	writer.WriteString(this->slotNames[ProgramRow::VertexShader]);
+	writer.WriteString(this->GetShaderName(ProgramRow::VertexShader));
     writer.WriteUInt(this->slotSubroutineMappings[ProgramRow::VertexShader].size());
     for (it = this->slotSubroutineMappings[ProgramRow::VertexShader].begin(); it != this->slotSubroutineMappings[ProgramRow::VertexShader].end(); it++)
     {
@@ -576,7 +644,7 @@ Program::Compile(BinWriter& writer)
 	this->WriteBinary(this->binary[ProgramRow::VertexShader], writer);
 
 	writer.WriteInt('HULL');
-	writer.WriteString(this->slotNames[ProgramRow::HullShader]);
+	writer.WriteString(this->GetShaderName(ProgramRow::HullShader));
     writer.WriteUInt(this->slotSubroutineMappings[ProgramRow::HullShader].size());
     for (it = this->slotSubroutineMappings[ProgramRow::HullShader].begin(); it != this->slotSubroutineMappings[ProgramRow::HullShader].end(); it++)
     {
@@ -586,7 +654,7 @@ Program::Compile(BinWriter& writer)
 	this->WriteBinary(this->binary[ProgramRow::HullShader], writer);
 
 	writer.WriteInt('DOMA');
-	writer.WriteString(this->slotNames[ProgramRow::DomainShader]);
+	writer.WriteString(this->GetShaderName(ProgramRow::DomainShader));
     writer.WriteUInt(this->slotSubroutineMappings[ProgramRow::DomainShader].size());
     for (it = this->slotSubroutineMappings[ProgramRow::DomainShader].begin(); it != this->slotSubroutineMappings[ProgramRow::DomainShader].end(); it++)
     {
@@ -596,7 +664,7 @@ Program::Compile(BinWriter& writer)
 	this->WriteBinary(this->binary[ProgramRow::DomainShader], writer);
 
 	writer.WriteInt('GEOM');
-	writer.WriteString(this->slotNames[ProgramRow::GeometryShader]);
+	writer.WriteString(this->GetShaderName(ProgramRow::GeometryShader));
     writer.WriteUInt(this->slotSubroutineMappings[ProgramRow::GeometryShader].size());
     for (it = this->slotSubroutineMappings[ProgramRow::GeometryShader].begin(); it != this->slotSubroutineMappings[ProgramRow::GeometryShader].end(); it++)
     {
@@ -606,7 +674,7 @@ Program::Compile(BinWriter& writer)
 	this->WriteBinary(this->binary[ProgramRow::GeometryShader], writer);
 
 	writer.WriteInt('PIXL');
-	writer.WriteString(this->slotNames[ProgramRow::PixelShader]);
+	writer.WriteString(this->GetShaderName(ProgramRow::PixelShader));
 	writer.WriteUInt(this->slotSubroutineMappings[ProgramRow::PixelShader].size());
 	for (it = this->slotSubroutineMappings[ProgramRow::PixelShader].begin(); it != this->slotSubroutineMappings[ProgramRow::PixelShader].end(); it++)
 	{
@@ -616,7 +684,7 @@ Program::Compile(BinWriter& writer)
 	this->WriteBinary(this->binary[ProgramRow::PixelShader], writer);
 
 	writer.WriteInt('COMP');
-	writer.WriteString(this->slotNames[ProgramRow::ComputeShader]);
+	writer.WriteString(this->GetShaderName(ProgramRow::ComputeShader));
     writer.WriteUInt(this->slotSubroutineMappings[ProgramRow::ComputeShader].size());
     for (it = this->slotSubroutineMappings[ProgramRow::ComputeShader].begin(); it != this->slotSubroutineMappings[ProgramRow::ComputeShader].end(); it++)
     {
@@ -648,6 +716,43 @@ Program::Compile(BinWriter& writer)
 
 	writer.WriteInt('RSTA');
 	writer.WriteString(this->slotNames[ProgramRow::RenderState]);
+
+	// write specialization constant values, constants not in the map keep their declared value
+	writer.WriteUInt(this->specializations.size());
+	for (i = 0; i < this->specializations.size(); i++)
+	{
+		writer.WriteUInt(this->specializations[i].first);
+		writer.WriteUInt(this->specializations[i].second);
+	}
+
+	// write the part of the promoted push constants this program uses, the size is 0 if it uses none
+	writer.WriteUInt(this->pushConstantOffset);
+	writer.WriteUInt(this->pushConstantSize);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Stage hashes are taken over the uncompressed binary, seeded with its size like the runtime does, and are 0 for unused stages.
+	The pipeline layout is the layout of every set, which all stages see, and the push constant range of the program.
+*/
+void
+Program::CompileRecipe(BinWriter& writer, unsigned index, const std::map<std::string, unsigned long long>& renderStateHashes, unsigned long long setLayoutHash)
+{
+	writer.WriteUInt(index);
+	unsigned i;
+	for (i = 0; i < ProgramRow::NumProgramRows - 1; i++)
+	{
+		const std::vector<unsigned>& binary = this->binary[i];
+		unsigned size = binary.size() * sizeof(unsigned);
+		writer.WriteUInt64(size > 0 ? HashString64((const char*)binary.data(), size, size) : 0);
+	}
+
+	const auto it = renderStateHashes.find(this->slotNames[ProgramRow::RenderState]);
+	writer.WriteUInt64(it != renderStateHashes.end() ? it->second : 0);
+	writer.WriteUInt64(this->vertexLayoutHash);
+
+	unsigned pushConstants[] = { this->pushConstantOffset, this->pushConstantSize };
+	writer.WriteUInt64(HashString64((const char*)pushConstants, sizeof(pushConstants), setLayoutHash));
 }
 
 //------------------------------------------------------------------------------
@@ -659,11 +764,258 @@ Program::GetBinary(unsigned shader)
 	return this->binary[shader];
 }
 
+//------------------------------------------------------------------------------
+/**
+	Shaders built with compile flags are named after both the function and the flags, which is the name the runtime looks them up by.
+*/
+const std::string&
+Program::GetShaderName(unsigned slot) const
+{
+	if (this->shaders[slot] != NULL) return this->shaders[slot]->GetName();
+	return this->slotNames[slot];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+Program::SharesShaders(const Program& program) const
+{
+	unsigned i;
+	for (i = 0; i < ProgramRow::NumProgramRows - 1; i++)
+	{
+		if (this->shaders[i] != program.shaders[i]) return false;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Flags are separated by '|', and are either a bare name or written as NAME=VALUE.
+*/
+static void
+SplitCompileFlags(const std::string& flags, std::vector<std::string>& tokens)
+{
+	size_t start = 0;
+	while (start < flags.length())
+	{
+		size_t end = flags.find('|', start);
+		if (end == std::string::npos) end = flags.length();
+		if (end > start) tokens.push_back(flags.substr(start, end - start));
+		start = end + 1;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Value indices are packed in declaration order, each axis taking as few bits as its number of values needs.
+*/
+void
+Program::ExtractPermutationAxes()
+{
+	std::vector<std::string> tokens;
+	SplitCompileFlags(this->compileFlags, tokens);
+
+	std::string flags;
+	unsigned shift = 0;
+	unsigned i;
+	for (i = 0; i < tokens.size(); i++)
+	{
+		const std::string& token = tokens[i];
+		PermutationAxis axis;
+		if (token.back() == '?')
+		{
+			axis.name = token.substr(0, token.length() - 1);
+			axis.flags.push_back("");
+			axis.flags.push_back(axis.name);
+		}
+		else if (token.back() == '}' && token.find("={") != std::string::npos)
+		{
+			size_t open = token.find("={");
+			axis.name = token.substr(0, open);
+			std::string values = token.substr(open + 2, token.length() - open - 3);
+			size_t start = 0;
+			while (start <= values.length())
+			{
+				size_t end = values.find(',', start);
+				if (end == std::string::npos) end = values.length();
+				if (end > start) axis.flags.push_back(axis.name + "=" + values.substr(start, end - start));
+				start = end + 1;
+			}
+		}
+		else
+		{
+			if (!flags.empty()) flags.append("|");
+			flags.append(token);
+			continue;
+		}
+
+		if (axis.name.empty() || axis.flags.empty())
+		{
+			this->permutationErrors.push_back(Format("Invalid permutation axis '%s'", token.c_str()));
+			continue;
+		}
+
+		axis.shift = shift;
+		axis.bits = 0;
+		while ((1u << axis.bits) < axis.flags.size()) axis.bits++;
+		shift += axis.bits;
+		this->permutationAxes.push_back(axis);
+	}
+	this->compileFlags = flags;
+
+	if (shift > MaxPermutationBits)
+	{
+		this->permutationErrors.push_back(Format("Permutation axes need %d mask bits, at most %d are supported", shift, MaxPermutationBits));
+		this->permutationAxes.clear();
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	The permutation where every axis is at its first value keeps the program name, the others append the flags of the axes not at their first value.
+*/
+Program
+Program::MakePermutation(const std::vector<unsigned>& values, unsigned& mask) const
+{
+	Program permutation = *this;
+	permutation.permutationAxes.clear();
+
+	std::string name = this->name;
+	mask = 0;
+	unsigned i;
+	for (i = 0; i < this->permutationAxes.size(); i++)
+	{
+		const PermutationAxis& axis = this->permutationAxes[i];
+		const std::string& flag = axis.flags[values[i]];
+		mask |= values[i] << axis.shift;
+		if (!flag.empty())
+		{
+			if (!permutation.compileFlags.empty()) permutation.compileFlags.append("|");
+			permutation.compileFlags.append(flag);
+		}
+		if (values[i] != 0) name.append("|" + flag);
+	}
+	permutation.SetName(name);
+	return permutation;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Program::GetCompileFlagNames(std::set<std::string>& names) const
+{
+	std::vector<std::string> tokens;
+	SplitCompileFlags(this->compileFlags, tokens);
+	unsigned i;
+	for (i = 0; i < tokens.size(); i++)
+	{
+		names.insert(tokens[i].substr(0, tokens[i].find('=')));
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	A bare name sets a bool to true, otherwise the value is parsed according to the constant type.
+	The value is stored as the 32 bits the specialization constant occupies.
+*/
+static bool
+ParseSpecializationValue(const DataType::Type type, const std::string& value, unsigned& bits)
+{
+	if (type == DataType::Bool)
+	{
+		if (value.empty() || value == "true" || value == "1")	bits = 1;
+		else if (value == "false" || value == "0")				bits = 0;
+		else													return false;
+		return true;
+	}
+
+	if (value.empty()) return false;
+	char* end = NULL;
+	if (type == DataType::Integer)	bits = (unsigned)strtol(value.c_str(), &end, 0);
+	else							bits = (unsigned)strtoul(value.c_str(), &end, 0);
+	return *end == '\0';
+}
+
+//------------------------------------------------------------------------------
+/**
+	Must run before the shaders are built, since the remaining flags become defines in the shader.
+*/
+void
+Program::ExtractSpecializations(const std::map<std::string, const Constant*>& constants)
+{
+	std::vector<std::string> tokens;
+	SplitCompileFlags(this->compileFlags, tokens);
+
+	std::string defines;
+	unsigned i;
+	for (i = 0; i < tokens.size(); i++)
+	{
+		const std::string& token = tokens[i];
+		size_t separator = token.find('=');
+		std::map<std::string, const Constant*>::const_iterator it = constants.find(token.substr(0, separator));
+		if (it == constants.end())
+		{
+			if (!defines.empty()) defines.append("|");
+			defines.append(token);
+			continue;
+		}
+
+		const Constant* constant = it->second;
+		unsigned bits;
+		std::string value = separator == std::string::npos ? "" : token.substr(separator + 1);
+		if (ParseSpecializationValue(constant->GetDataType().GetType(), value, bits))
+		{
+			this->specializations.push_back(std::make_pair(constant->GetSpecializationId(), bits));
+		}
+		else
+		{
+			this->invalidSpecializations.push_back(token);
+		}
+	}
+	this->compileFlags = defines;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Program::AddPushConstantRange(unsigned offset, unsigned size)
+{
+	if (this->pushConstantSize == 0)
+	{
+		this->pushConstantOffset = offset;
+		this->pushConstantSize = size;
+		return;
+	}
+	unsigned end = std::max(this->pushConstantOffset + this->pushConstantSize, offset + size);
+	this->pushConstantOffset = std::min(this->pushConstantOffset, offset);
+	this->pushConstantSize = end - this->pushConstantOffset;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void
-Program::BuildShaders(const Header& header, const std::vector<Function>& functions, std::map<std::string, Shader*>& shaders)
+Program::CopyLink(const Program& program)
+{
+	unsigned i;
+	for (i = 0; i < ProgramRow::NumProgramRows - 1; i++)
+	{
+		this->binary[i] = program.binary[i];
+	}
+	this->activeUniforms = program.activeUniforms;
+	this->activeUniformBlocks = program.activeUniformBlocks;
+	this->uniformBufferOffsets = program.uniformBufferOffsets;
+	this->compressBinaries = program.compressBinaries;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Program::BuildShaders(const Header& header, const std::unordered_map<std::string, const Function*>& functions, std::map<std::string, Shader*>& shaders)
 {
 	unsigned i;
 	for (i = 0; i < ProgramRow::NumProgramRows; i++)
@@ -671,58 +1023,57 @@ Program::BuildShaders(const Header& header, const std::vector<Function>& functio
 		// first check if shader slot is used
 		if (this->slotMask[i])
 		{
-			// get string
-			const std::string& functionName = this->slotNames[i];
+			// get string, copied since the slot name is rewritten below
+			const std::string functionName = this->slotNames[i];
 		
-			unsigned j;
-			for (j = 0; j < functions.size(); j++)
+			const auto match = functions.find(functionName);
+			if (match != functions.end())
 			{
-				const Function& func = functions[j];
+				const Function& func = *match->second;
+
+                // create string which is the function name merged with its compile flags
+                std::string functionNameWithDefines = functionName;
 
-				// ok, we have a matching function
-				if (func.GetName() == functionName && func.IsShader())
+				std::map<std::string, std::string> subroutineMappings;
+				if (header.GetFlags() & Header::NoSubroutines)
 				{
-                    // create string which is the function name merged with its compile flags
-                    std::string functionNameWithDefines = functionName;// +"_" + this->compileFlags;
+					subroutineMappings = this->slotSubroutineMappings[i];
+					std::map<std::string, std::string>::const_iterator it;
 
-					std::map<std::string, std::string> subroutineMappings;
-					if (header.GetFlags() & Header::NoSubroutines)
+					functionNameWithDefines += "(";
+					for (it = subroutineMappings.begin(); it != subroutineMappings.end(); it++)
 					{
-						subroutineMappings = this->slotSubroutineMappings[i];
-						std::map<std::string, std::string>::const_iterator it;
-
-						functionNameWithDefines += "(";
-						for (it = subroutineMappings.begin(); it != subroutineMappings.end(); it++)
+						functionNameWithDefines += AnyFX::Format("%s = %s", (*it).first.c_str(), (*it).second.c_str());
+						if (std::next(it) != subroutineMappings.end())
 						{
-							functionNameWithDefines += AnyFX::Format("%s = %s", (*it).first.c_str(), (*it).second.c_str());
-							if (std::next(it) != subroutineMappings.end())
-							{
-								functionNameWithDefines += ", ";
-							}
+							functionNameWithDefines += ", ";
 						}
-						functionNameWithDefines += ")";
-
-						// remove subroutines from mappings since they are done now...
-						this->slotNames[i] = functionNameWithDefines;
-						this->slotSubroutineMappings[i].clear();
 					}
+					functionNameWithDefines += ")";
 
-					// if the shader has not been created yet, create it
-                    if (shaders.find(functionNameWithDefines) == shaders.end())
-					{
-						Shader* shader = new Shader;
-						shader->SetFunction(func);
-						shader->SetType(i);
-                        shader->SetName(functionNameWithDefines);
-                        shader->SetCompileFlags(this->compileFlags);
-						shader->SetSubroutineMappings(subroutineMappings);
-                        shaders[functionNameWithDefines] = shader;
-						this->shaders[i] = shader;
-					}
-					else
-					{
-						this->shaders[i] = shaders[functionNameWithDefines];
-					}
+					// remove subroutines from mappings since they are done now...
+					this->slotNames[i] = functionNameWithDefines;
+					this->slotSubroutineMappings[i].clear();
+				}
+
+				// programs with different defines need their own shader, flags lowered to specialization constants are gone by now
+				if (!this->compileFlags.empty()) functionNameWithDefines += "|" + this->compileFlags;
+
+				// if the shader has not been created yet, create it
+                if (shaders.find(functionNameWithDefines) == shaders.end())
+				{
+					Shader* shader = new Shader;
+					shader->SetFunction(func);
+					shader->SetType(i);
+                    shader->SetName(functionNameWithDefines);
+                    shader->SetCompileFlags(this->compileFlags);
+					shader->SetSubroutineMappings(subroutineMappings);
+                    shaders[functionNameWithDefines] = shader;
+					this->shaders[i] = shader;
+				}
+				else
+				{
+					this->shaders[i] = shaders[functionNameWithDefines];
 				}
 			}
 		}
@@ -842,6 +1193,47 @@ Program::LinkGLSL3(Generator& generator, Shader* vs, Shader* hs, Shader* ds, Sha
 void
 Program::LinkSPIRV(Generator& generator, Shader* vs, Shader* hs, Shader* ds, Shader* gs, Shader* ps, Shader* cs)
 {
+	EShMessages messages = (EShMessages)(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
+
+	// look for the binaries in the cache, the shaders are only parsed if we miss it
+	const std::string& cacheDir = generator.GetHeader().GetValue("/SPVCACHE");
+	std::string cachePath;
+	if (!cacheDir.empty())
+	{
+		std::string spirvVersion;
+		glslang::GetSpirvVersion(spirvVersion);
+		int toolId = glslang::GetKhronosToolId();
+
+		// the version strings carry the glslang release, so binaries from another glslang aren't reused
+		const char* glslVersion = glslang::GetGlslVersionString();
+		const char* esslVersion = glslang::GetEsslVersionString();
+
+		unsigned long long hash = HashString64((const char*)&SPIRVCacheVersion, sizeof(SPIRVCacheVersion));
+		hash = HashString64(spirvVersion.c_str(), spirvVersion.length() + 1, hash);
+		hash = HashString64((const char*)&toolId, sizeof(toolId), hash);
+		hash = HashString64(glslVersion, strlen(glslVersion) + 1, hash);
+		hash = HashString64(esslVersion, strlen(esslVersion) + 1, hash);
+		hash = HashString64((const char*)&messages, sizeof(messages), hash);
+		hash = HashString64((const char*)&this->compressBinaries, sizeof(this->compressBinaries), hash);
+
+		Shader* stages[] = { vs, hs, ds, gs, ps, cs };
+		unsigned i;
+		for (i = 0; i < ProgramRow::NumProgramRows - 1; i++)
+		{
+			bool used = stages[i] != NULL;
+			hash = HashString64((const char*)&used, sizeof(used), hash);
+			if (used) hash = stages[i]->HashSources(hash);
+		}
+
+		cachePath = Format("%s/%016llx.spvc", cacheDir.c_str(), hash);
+		if (this->ReadSPIRVCache(cachePath)) return;
+
+		for (i = 0; i < ProgramRow::NumProgramRows - 1; i++)
+		{
+			if (stages[i] != NULL) stages[i]->Parse(generator);
+		}
+	}
+
 	glslang::TProgram* program = new glslang::TProgram;
 	glslang::TShader* gvs = vs != NULL ? vs->glslShader : NULL;
 	glslang::TShader* ghs = hs != NULL ? hs->glslShader : NULL;
@@ -856,7 +1248,6 @@ Program::LinkSPIRV(Generator& generator, Shader* vs, Shader* hs, Shader* ds, Sha
 	if (gps) program->addShader(gps);
 	if (gcs) program->addShader(gcs);
 
-	EShMessages messages = (EShMessages)(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 	if (!program->link(messages))
 	{
 		std::string message = program->getInfoLog();
@@ -896,25 +1287,150 @@ Program::LinkSPIRV(Generator& generator, Shader* vs, Shader* hs, Shader* ds, Sha
 		if (intermediate != NULL)
 		{
 			glslang::GlslangToSpv(*intermediate, this->binary[i]);
+
+			// canonicalize ids so equal instruction sequences become equal bytes, which compresses far better
+			if (this->compressBinaries)
+			{
+				spv::spirvbin_t remapper;
+				remapper.remap(this->binary[i], spv::spirvbin_t::MAP_ALL);
+			}
 		}		
 	}
 	
 	delete program;
+
+	// only store programs which compiled without problems
+	if (!cachePath.empty() && generator.GetErrorCount() == 0) this->WriteSPIRVCache(cachePath);
+}
+
+//------------------------------------------------------------------------------
+/**
+	The entry is read in one go, then validated while parsed, so a truncated or stale file is treated like a miss.
+*/
+bool
+Program::ReadSPIRVCache(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	BinReader reader;
+	reader.Open(data.data(), data.size());
+	if (reader.ReadUInt() != 'SPVC' || reader.ReadUInt() != SPIRVCacheVersion)
+	{
+		reader.Close();
+		return false;
+	}
+
+	// every count is checked against the entry size, so garbage never turns into huge allocations
+	std::vector<unsigned> binaries[ProgramRow::NumProgramRows - 1];
+	std::vector<std::string> blocks;
+	std::vector<std::string> uniforms;
+	std::map<std::string, unsigned> offsets;
+	bool valid = true;
+	unsigned i, count;
+	for (i = 0; i < ProgramRow::NumProgramRows - 1 && valid; i++)
+	{
+		count = reader.ReadUInt();
+		valid = count <= data.size() / sizeof(unsigned);
+		if (valid && count > 0)
+		{
+			binaries[i].resize(count);
+			reader.ReadBytes((char*)binaries[i].data(), count * sizeof(unsigned));
+		}
+	}
+
+	count = valid ? reader.ReadUInt() : 0;
+	valid = valid && count <= data.size();
+	for (i = 0; i < count && valid && !reader.Eof(); i++) blocks.push_back(reader.ReadString());
+	count = valid ? reader.ReadUInt() : 0;
+	valid = valid && count <= data.size();
+	for (i = 0; i < count && valid && !reader.Eof(); i++) uniforms.push_back(reader.ReadString());
+	count = valid ? reader.ReadUInt() : 0;
+	valid = valid && count <= data.size();
+	for (i = 0; i < count && valid && !reader.Eof(); i++)
+	{
+		std::string name = reader.ReadString();
+		offsets[name] = reader.ReadUInt();
+	}
+
+	// the end marker tells us the entry was completely written
+	valid = valid && reader.ReadUInt() == 'SPVC' && !reader.Eof();
+	reader.Close();
+	if (!valid) return false;
+
+	for (i = 0; i < ProgramRow::NumProgramRows - 1; i++) this->binary[i].swap(binaries[i]);
+	this->activeUniformBlocks.swap(blocks);
+	this->activeUniforms.swap(uniforms);
+	this->uniformBufferOffsets.swap(offsets);
+	return true;
 }
 
 //------------------------------------------------------------------------------
 /**
+	Writes to a temporary file first, so compilers running in parallel never see a partial entry.
 */
 void
-Program::WriteBinary(const std::vector<unsigned>& binary, BinWriter& writer)
+Program::WriteSPIRVCache(const std::string& path)
 {
-	writer.WriteUInt(binary.size() * sizeof(unsigned));
+	std::string tempPath = Format("%s.%p.tmp", path.c_str(), (void*)this);
+	BinWriter writer;
+	writer.SetPath(tempPath);
+	if (!writer.Open()) return;
+
+	writer.WriteUInt('SPVC');
+	writer.WriteUInt(SPIRVCacheVersion);
 	unsigned i;
-	for (i = 0; i < binary.size(); i++)
+	for (i = 0; i < ProgramRow::NumProgramRows - 1; i++)
 	{
-		const unsigned int word = binary[i];
-		writer.WriteBytes((const char*)&word, 4);
+		writer.WriteUInt(this->binary[i].size());
+		if (!this->binary[i].empty()) writer.WriteBytes((const char*)this->binary[i].data(), this->binary[i].size() * sizeof(unsigned));
 	}
+
+	writer.WriteUInt(this->activeUniformBlocks.size());
+	for (i = 0; i < this->activeUniformBlocks.size(); i++) writer.WriteString(this->activeUniformBlocks[i]);
+	writer.WriteUInt(this->activeUniforms.size());
+	for (i = 0; i < this->activeUniforms.size(); i++) writer.WriteString(this->activeUniforms[i]);
+	writer.WriteUInt(this->uniformBufferOffsets.size());
+	std::map<std::string, unsigned>::const_iterator it;
+	for (it = this->uniformBufferOffsets.begin(); it != this->uniformBufferOffsets.end(); it++)
+	{
+		writer.WriteString(it->first);
+		writer.WriteUInt(it->second);
+	}
+	writer.WriteUInt('SPVC');
+	writer.Close();
+
+	// if another compiler got there first its entry is just as good
+	if (rename(tempPath.c_str(), path.c_str()) != 0) remove(tempPath.c_str());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Program::WriteBinary(const std::vector<unsigned>& binary, BinWriter& writer)
+{
+	unsigned size = binary.size() * sizeof(unsigned);
+	writer.WriteUInt(size);
+
+	// compress if asked to, unless it doesn't pay off
+	if (this->compressBinaries && size > 0)
+	{
+		std::vector<char> compressed(LZCompressBound(size));
+		unsigned compressedSize = LZCompress((const char*)binary.data(), size, compressed.data(), compressed.size());
+		if (compressedSize > 0 && compressedSize < size)
+		{
+			writer.WriteUInt(LZCompression);
+			writer.WriteUInt(compressedSize);
+			writer.WriteBytes(compressed.data(), compressedSize);
+			return;
+		}
+	}
+
+	writer.WriteUInt(NoCompression);
+	if (size > 0) writer.WriteBytes((const char*)binary.data(), size);
 }
 
 //------------------------------------------------------------------------------
@@ -11,21 +11,41 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include "symbol.h"
 #include "renderstate.h"
 #include "programrow.h"
 #include "annotation.h"
 #include "shader.h"
+#include "constant.h"
 namespace AnyFX
 {
 
 class Program : public Symbol
 {
 public:
+
+	struct PermutationAxis
+	{
+		std::string name;
+		std::vector<std::string> flags;		// compile flag each value adds, empty if the value adds none
+		unsigned shift;						// position of the value index in the permutation mask
+		unsigned bits;
+	};
+
 	/// constructor
 	Program();
 	/// destructor
 	virtual ~Program();
+	/// copy constructor
+	Program(const Program&) = default;
+	/// move constructor
+	Program(Program&&) = default;
+	/// copy assignment
+	Program& operator=(const Program&) = default;
+	/// move assignment
+	Program& operator=(Program&&) = default;
 
 	/// set annotation
 	void SetAnnotation(const Annotation& annotation);
@@ -38,14 +58,39 @@ public:
 	void Generate(Generator& generator);
 	/// compiles program
 	void Compile(BinWriter& writer);
+	/// compiles the pipeline recipe of the program, must come after Compile
+	void CompileRecipe(BinWriter& writer, unsigned index, const std::map<std::string, unsigned long long>& renderStateHashes, unsigned long long setLayoutHash);
 	/// get binary representation for shader
 	const std::vector<unsigned>& GetBinary(unsigned shader);
+	/// returns true if program links exactly the same shaders as the other program
+	bool SharesShaders(const Program& program) const;
+
+	/// move permutation axes out of the compile flags, NAME? is a switch and NAME={a,b,c} takes one of the listed values
+	void ExtractPermutationAxes();
+	/// returns true if program declares permutation axes
+	bool HasPermutations() const;
+	/// get permutation axes
+	const std::vector<PermutationAxis>& GetPermutationAxes() const;
+	/// create permutation using the value index chosen on each axis, also returns its mask
+	Program MakePermutation(const std::vector<unsigned>& values, unsigned& mask) const;
+
+	/// grow the push constant range of the program to cover a promoted block
+	void AddPushConstantRange(unsigned offset, unsigned size);
+
+	/// add names switched by the compile flags to set
+	void GetCompileFlagNames(std::set<std::string>& names) const;
+	/// move compile flags which switch specialization constants out of the defines and into the specialization map
+	void ExtractSpecializations(const std::map<std::string, const Constant*>& constants);
 
 private:
 	friend class Effect;
 
 	/// constructs a shader function using the given functions
-	void BuildShaders(const Header& header, const std::vector<Function>& functions, std::map<std::string, Shader*>& shaders);
+	void BuildShaders(const Header& header, const std::unordered_map<std::string, const Function*>& functions, std::map<std::string, Shader*>& shaders);
+	/// get name of shader bound to slot, as written to the binary
+	const std::string& GetShaderName(unsigned slot) const;
+	/// take binaries and reflection from a program which links the same shaders instead of linking again
+	void CopyLink(const Program& program);
 	/// writes binary to file
 	void WriteBinary(const std::vector<unsigned>& binary, BinWriter& writer);
 
@@ -62,6 +107,10 @@ private:
 #pragma region Vulkan
 	/// generates SPIRV target code from GLSL representation
 	void LinkSPIRV(Generator& generator, Shader* vs, Shader* hs, Shader* ds, Shader* gs, Shader* ps, Shader* cs);
+	/// reads binaries and reflection from a cache entry, returns false if it is missing or unusable
+	bool ReadSPIRVCache(const std::string& path);
+	/// writes binaries and reflection to a cache entry
+	void WriteSPIRVCache(const std::string& path);
 #pragma endregion
 
 #pragma region DirectX
@@ -80,7 +129,15 @@ private:
 	Shader* shaders[ProgramRow::NumProgramRows-1];
 	std::vector<unsigned> binary[ProgramRow::NumProgramRows-1];
     std::string compileFlags;
+	std::vector<std::pair<unsigned, unsigned>> specializations;
+	std::vector<std::string> invalidSpecializations;
+	unsigned pushConstantOffset;
+	unsigned pushConstantSize;
+	unsigned long long vertexLayoutHash;
+	std::vector<PermutationAxis> permutationAxes;
+	std::vector<std::string> permutationErrors;
 	unsigned patchSize;
+	bool compressBinaries;
 
 	std::vector<std::string> activeUniforms;
 	std::vector<std::string> activeUniformBlocks;
@@ -91,6 +148,24 @@ private:
 }; 
 
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+Program::HasPermutations() const
+{
+	return !this->permutationAxes.empty();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const std::vector<Program::PermutationAxis>&
+Program::GetPermutationAxes() const
+{
+	return this->permutationAxes;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -16,6 +16,14 @@ struct QualifierExpression
 	QualifierExpression();
 	/// destructor
 	virtual ~QualifierExpression();
+	/// copy constructor
+	QualifierExpression(const QualifierExpression&) = default;
+	/// move constructor
+	QualifierExpression(QualifierExpression&&) = default;
+	/// copy assignment
+	QualifierExpression& operator=(const QualifierExpression&) = default;
+	/// move assignment
+	QualifierExpression& operator=(QualifierExpression&&) = default;
 
 	std::string name;
 	Expression* expr;
@@ -908,4 +908,20 @@ RenderState::Compile(BinWriter& writer)
 	}
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned long long
+RenderState::Hash() const
+{
+	unsigned long long hash = HashString64((const char*)this->blendBoolFlags, sizeof(this->blendBoolFlags));
+	hash = HashString64((const char*)this->blendEnumFlags, sizeof(this->blendEnumFlags), hash);
+	hash = HashString64((const char*)this->drawBoolFlags, sizeof(this->drawBoolFlags), hash);
+	hash = HashString64((const char*)this->drawEnumFlags, sizeof(this->drawEnumFlags), hash);
+	hash = HashString64((const char*)this->drawIntFlags, sizeof(this->drawIntFlags), hash);
+	hash = HashString64((const char*)this->drawUintFlags, sizeof(this->drawUintFlags), hash);
+	hash = HashString64((const char*)this->drawFloatFlags, sizeof(this->drawFloatFlags), hash);
+	return hash;
+}
+
 } // namespace AnyFX
\ No newline at end of file
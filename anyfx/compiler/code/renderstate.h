@@ -23,6 +23,14 @@ public:
 	RenderState();
 	/// destructor
 	virtual ~RenderState();
+	/// copy constructor
+	RenderState(const RenderState&) = default;
+	/// move constructor
+	RenderState(RenderState&&) = default;
+	/// copy assignment
+	RenderState& operator=(const RenderState&) = default;
+	/// move assignment
+	RenderState& operator=(RenderState&&) = default;
 
 	/// set annotation
 	void SetAnnotation(const Annotation& annotation);
@@ -36,6 +44,8 @@ public:
 	void TypeCheck(TypeChecker& typechecker);
 	/// compiles render state
 	void Compile(BinWriter& writer);
+	/// hash the settings as compiled, the name and annotation are left out so equal states hash the same
+	unsigned long long Hash() const;
 
 	/// currently the upper limit of render targets is 8
 	static const int MaxNumRenderTargets = 8;
@@ -19,7 +19,10 @@ namespace AnyFX
 Sampler::Sampler() :
 	numEntries(0),
 	group(0),
-	binding(0)
+	binding(0),
+	mutableExpression(NULL),
+	isMutable(false),
+	isStatic(false)
 {	
 	this->symbolType = Symbol::SamplerType;
 
@@ -191,6 +194,12 @@ Sampler::ConsumeRow(const SamplerRow& row)
 		else if (row.GetFlag() == "MaxLod")			this->floatExpressions[SamplerRow::MaxLod] = row.GetExpression();
 		else if (row.GetFlag() == "MaxAnisotropic")	this->floatExpressions[SamplerRow::MaxAnisotropic] = row.GetExpression();
 		else if (row.GetFlag() == "Comparison")		this->boolExpressions[SamplerRow::Comparison] = row.GetExpression();
+		else if (row.GetFlag() == "Mutable")
+		{
+			// the last row wins, like it does for every other flag
+			delete this->mutableExpression;
+			this->mutableExpression = row.GetExpression();
+		}
 		else this->invalidFlags.push_back(row.GetFlag());
 		break;
 	case SamplerRow::Float4FlagType:
@@ -269,6 +278,13 @@ Sampler::TypeCheck(TypeChecker& typechecker)
 		}
 	}
 
+	if (this->mutableExpression)
+	{
+		this->isMutable = this->mutableExpression->EvalBool(typechecker);
+		delete this->mutableExpression;
+		this->mutableExpression = NULL;
+	}
+
 	for (unsigned i = 0; i < this->qualifierExpressions.size(); i++)
 	{
 		const std::string& qualifier = this->qualifierExpressions[i].name;
@@ -296,6 +312,9 @@ Sampler::TypeCheck(TypeChecker& typechecker)
 			if (header.GetType() == Header::SPIRV)
 			{
 				this->binding = Shader::bindingIndices[this->group]++;
+
+				// a standalone sampler only ever has the settings declared here, unless the effect asks to change them
+				this->isStatic = !this->isMutable && !this->reserved;
 			}
 			else
 			{
@@ -384,6 +403,8 @@ Sampler::Compile(BinWriter& writer)
 	{
 		writer.WriteString(this->textureList.GetTexture(i));
 	}		
+
+	writer.WriteBool(this->isStatic);
 }
 
 //------------------------------------------------------------------------------
@@ -455,4 +476,13 @@ Sampler::Format(const Header& header) const
 	return res;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+Sampler::IsStatic() const
+{
+	return this->isStatic;
+}
+
 } // namespace AnyFX
\ No newline at end of file
@@ -23,6 +23,14 @@ public:
 	Sampler();
 	/// destructor
 	virtual ~Sampler();
+	/// copy constructor
+	Sampler(const Sampler&) = default;
+	/// move constructor
+	Sampler(Sampler&&) = default;
+	/// copy assignment
+	Sampler& operator=(const Sampler&) = default;
+	/// move assignment
+	Sampler& operator=(Sampler&&) = default;
 
 	/// set annotation
 	void SetAnnotation(const Annotation& annotation);
@@ -38,6 +46,9 @@ public:
 	/// format sampler to fit target language
 	std::string Format(const Header& header) const;
 
+	/// returns true if sampler settings are fixed, so the sampler can be an immutable sampler in the descriptor layout
+	bool IsStatic() const;
+
 private:
 	friend class Effect;
 
@@ -61,6 +72,10 @@ private:
 	vector<float, 4> float4Flags[SamplerRow::NumFloat4Flags];
 	vector<Expression*, 4> float4Expressions[SamplerRow::NumFloatFlags];
 
+	Expression* mutableExpression;
+	bool isMutable;
+	bool isStatic;
+
 	bool hasTextures;
 	SamplerTextureList textureList;
 	unsigned binding;
@@ -19,6 +19,14 @@ public:
 	SamplerTextureList();
 	/// destructor
 	virtual ~SamplerTextureList();
+	/// copy constructor
+	SamplerTextureList(const SamplerTextureList&) = default;
+	/// move constructor
+	SamplerTextureList(SamplerTextureList&&) = default;
+	/// copy assignment
+	SamplerTextureList& operator=(const SamplerTextureList&) = default;
+	/// move assignment
+	SamplerTextureList& operator=(SamplerTextureList&&) = default;
 
 	/// adds a texture
 	void AddTexture(const std::string& texture);
@@ -6,6 +6,7 @@
 #include <string>
 #include <algorithm>
 #include <sstream>
+#include <mutex>
 #include "shader.h"
 #include "programrow.h"
 #include "parameter.h"
@@ -27,6 +28,9 @@
 
 TBuiltInResource DefaultResources;
 
+// messages used when parsing for SPIR-V, part of the cache key since they change the output
+static const EShMessages SPIRVParseMessages = (EShMessages)(EShMsgDefault | EShMsgRelaxedErrors | EShMsgSpvRules | EShMsgVulkanRules);
+
 void SetupDefaultResources()
 {
 DefaultResources.maxLights = 32;												;
@@ -137,7 +141,9 @@ Shader::Shader() :
 	codeOffset(0),
 	binary(NULL),
 	binarySize(0),
-	binaryValid(false)
+	binaryValid(false),
+	declarations(NULL),
+	indexToFileMap(NULL)
 {
 	// empty
 }
@@ -181,18 +187,14 @@ Shader::Setup()
 void 
 Shader::Generate( 
 				 Generator& generator, 
-				 const std::vector<Variable>& vars, 
-				 const std::vector<Structure>& structures, 
-				 const std::vector<Constant>& constants,
-				 const std::vector<VarBlock>& blocks,
-                 const std::vector<VarBuffer>& buffers,
-				 const std::vector<Sampler>& samplers,
-                 const std::vector<Subroutine>& subroutines,
-				 const std::vector<Function>& functions,
+				 const std::string& declarations,
+				 const std::map<int, std::pair<std::string, std::string> >& indexToFileMap,
 				 const std::vector<std::string>& passthroughPPs)
 {
-	// clear formatted code
+	// clear formatted code, the preamble only holds what differs per stage
 	this->preamble.clear();
+	this->declarations = &declarations;
+	this->indexToFileMap = &indexToFileMap;
 
 	// get header
 	const Header& header = generator.GetHeader();
@@ -247,21 +249,17 @@ Shader::Generate(
 		}		
 	}
 
-    // add compile flags
-    std::string tempFlags = this->compileFlags;
-    if (tempFlags.length() > 0)
+    // add compile flags, NAME=VALUE defines NAME as VALUE
+    size_t start = 0;
+    while (start < this->compileFlags.length())
     {
-        std::string token;
-        size_t index = 0;
-        while ((index = tempFlags.find("|")) != std::string::npos)
-        {
-            token = tempFlags.substr(0, index);
-            tempFlags.erase(0, index + 1);
-            this->preamble.append("#define " + token + "\n");
-        }
-
-        // fugly solution, but adds the last define
-        this->preamble.append("#define " + tempFlags + "\n");
+        size_t end = this->compileFlags.find('|', start);
+        if (end == std::string::npos) end = this->compileFlags.length();
+        std::string token = this->compileFlags.substr(start, end - start);
+        size_t separator = token.find('=');
+        if (separator != std::string::npos) token[separator] = ' ';
+        if (!token.empty()) this->preamble.append("#define " + token + "\n");
+        start = end + 1;
     }
 
 	// undefine functions which GL will complain about when compiling for certain shader targets (likely they won't be used at all)
@@ -272,73 +270,6 @@ Shader::Generate(
 		this->preamble.append("#define fwidth(val) val\n");
 	}
 
-	unsigned i;
-	for (i = 0; i < structures.size(); i++)
-	{
-		const Structure& structure = structures[i];
-		this->preamble.append(structure.Format(header));
-	}
-
-	for (i = 0; i < samplers.size(); i++)
-	{
-		const Sampler& sampler = samplers[i];
-		this->preamble.append(sampler.Format(header));
-	}
-
-	for (i = 0; i < vars.size(); i++)
-	{
-		const Variable& var = vars[i];
-
-		if (!var.IsSubroutine())
-		{
-			// variable is formatted by resolving the internal type to the target type
-			this->preamble.append(var.Format(header));
-		}		
-	}
-
-	for (i = 0; i < blocks.size(); i++)
-	{
-		const VarBlock& block = blocks[i];
-		this->preamble.append(block.Format(header));
-	}
-
-    for (i = 0; i < buffers.size(); i++)
-    {
-        const VarBuffer& buffer = buffers[i];
-        this->preamble.append(buffer.Format(header));
-    }
-
-	for (i = 0; i < constants.size(); i++)
-	{
-		const Constant& constant = constants[i];
-		this->preamble.append(constant.Format(header));
-	}
-
-	for (i = 0; i < functions.size(); i++)
-	{
-		const Function& func = functions[i];
-		this->preamble.append(func.GetCode());
-        this->indexToFileMap[func.GetFileIndex()] = std::pair<std::string, std::string>(func.GetName(), func.GetFile());
-	}
-
-	for (i = 0; i < subroutines.size(); i++)
-	{
-		const Subroutine& subroutine = subroutines[i];
-		this->preamble.append(subroutine.Format(header));
-		this->indexToFileMap[subroutine.GetFileIndex()] = std::pair<std::string, std::string>(subroutine.GetName(), subroutine.GetFile());
-	}
-
-	for (i = 0; i < vars.size(); i++)
-	{
-		const Variable& var = vars[i];
-
-		if (var.IsSubroutine())
-		{
-			// generate subroutine vars
-			this->preamble.append(var.Format(header));
-		}
-	}
-
 	switch (header.GetType())
 	{
 	case Header::GLSL:
@@ -346,7 +277,13 @@ Shader::Generate(
 		this->binaryValid = false;
 		break;
 	case Header::SPIRV:
-		this->CompileSPIRV(this->GenerateGLSL(&generator, 4, 5), &generator);
+		this->code = this->GenerateGLSL(&generator, 4, 5);
+
+		// parsing is done through Parse, by the effect for all shaders at once or by the programs which miss the cache
+		if (header.GetFlags() & Header::OutputGeneratedShaders)
+		{
+			this->formattedCode = this->preamble + *this->declarations + this->code;
+		}
 		this->binaryValid = true;
 		break;
 	case Header::HLSL:
@@ -381,22 +318,14 @@ Shader::CompileGLSL(const std::string& code, Generator* generator)
 		EShLangCompute			// only accepted in GLSL4.3+
 	};
 
-	// create array of strings
-	int* lengths = new int[2];
-	const char** sources = new const char*[2];
-
-	// the preamble part of the code should be the responsibility of AnyFX to ALWAYS get right
+	// the preamble and declarations should be the responsibility of AnyFX to ALWAYS get right
 	// the rest of the code patches are up to the programmer
-	sources[0] = this->preamble.c_str();
-	lengths[0] = this->preamble.length();
-		
-	// add the shader source lastly, as such, everything before should be already defined
-	sources[1] = code.c_str();
-	lengths[1] = code.length();
+	const char* sources[] = { this->preamble.c_str(), this->declarations->c_str(), code.c_str() };
+	const int lengths[] = { (int)this->preamble.length(), (int)this->declarations->length(), (int)code.length() };
 
 	EShMessages messages = EShMsgSuppressWarnings;
 	glslang::TShader* shaderObject = new glslang::TShader(shaderTable[this->shaderType]);
-	shaderObject->setStringsWithLengths(sources, lengths, 2);
+	shaderObject->setStringsWithLengths(sources, lengths, 3);
 
 	// perform compilation
 	const Header& header = generator->GetHeader();
@@ -408,11 +337,9 @@ Shader::CompileGLSL(const std::string& code, Generator* generator)
 	}
 	
 	this->glslShader = shaderObject;
-	delete[] sources;
-	delete[] lengths;
 
-	// merge code
-	this->formattedCode = this->preamble + code;
+	// merge code, GLSL effects ship it as the shader source since there is no binary
+	this->formattedCode = this->preamble + *this->declarations + code;
 }
 
 //------------------------------------------------------------------------------
@@ -436,27 +363,22 @@ Shader::CompileSPIRV(const std::string& code, Generator* generator)
 		EShLangCompute
 	};
 
-	// create array of strings
-	int* lengths = new int[2];
-	const char** sources = new const char*[2];
-
-	// the preamble part of the code should be the responsibility of AnyFX to ALWAYS get right
+	// the preamble and declarations should be the responsibility of AnyFX to ALWAYS get right
 	// the rest of the code patches are up to the programmer
-	sources[0] = this->preamble.c_str();
-	lengths[0] = this->preamble.length();
-
-	// add the shader source lastly, as such, everything before should be already defined
-	sources[1] = code.c_str();
-	lengths[1] = code.length();
+	const char* sources[] = { this->preamble.c_str(), this->declarations->c_str(), code.c_str() };
+	const int lengths[] = { (int)this->preamble.length(), (int)this->declarations->length(), (int)code.length() };
 
-	EShMessages messages = (EShMessages)(EShMsgDefault | EShMsgRelaxedErrors | EShMsgSpvRules | EShMsgVulkanRules);
+	EShMessages messages = SPIRVParseMessages;
 	glslang::TShader* shaderObject = new glslang::TShader(shaderTable[this->shaderType]);
-	shaderObject->setStringsWithLengths(sources, lengths, 2);
+	shaderObject->setStringsWithLengths(sources, lengths, 3);
 
 	// perform compilation
-	const Header& header = generator->GetHeader();
 	if (!shaderObject->parse(&DefaultResources, 450, EProfile::ECoreProfile, true, true, messages))
 	{
+		// shaders may be parsed on several threads, and strtok isn't reentrant
+		static std::mutex messageLock;
+		std::lock_guard<std::mutex> lock(messageLock);
+
 		const char* ptr = shaderObject->getInfoLog();
 		char* message = new char[strlen(ptr)];
 		memcpy(message, ptr, strlen(ptr));
@@ -506,11 +428,31 @@ Shader::CompileSPIRV(const std::string& code, Generator* generator)
 	}
 
 	this->glslShader = shaderObject;
-	delete[] sources;
-	delete[] lengths;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Thread safe as long as no two threads parse the same shader.
+*/
+void
+Shader::Parse(Generator& generator)
+{
+	if (this->glslShader == NULL) this->CompileSPIRV(this->code, &generator);
+}
 
-	// formatted code is left empty since SPIR-V use a binary representation
-	this->formattedCode = this->preamble + code;
+//------------------------------------------------------------------------------
+/**
+	The sources are hashed exactly as they are handed to glslang, so any change to the declarations, defines or function body gives a new hash.
+*/
+unsigned long long
+Shader::HashSources(unsigned long long hash) const
+{
+	hash = HashString64((const char*)&this->shaderType, sizeof(this->shaderType), hash);
+	hash = HashString64((const char*)&SPIRVParseMessages, sizeof(SPIRVParseMessages), hash);
+	hash = HashString64(this->preamble.c_str(), this->preamble.length() + 1, hash);
+	hash = HashString64(this->declarations->c_str(), this->declarations->length() + 1, hash);
+	hash = HashString64(this->code.c_str(), this->code.length() + 1, hash);
+	return hash;
 }
 
 //------------------------------------------------------------------------------
@@ -650,10 +592,10 @@ Shader::GLSLProblemIntelATI(Generator* generator, std::stringstream& stream)
                     std::string msg = Format("OpenGL error: %s at row %d in file %s.\n", lineRow, lineValue, this->func.GetFile().c_str());
 					generator->Error(msg);
 				}
-                else if (this->indexToFileMap.find(fileValue) != this->indexToFileMap.end())
+                else if (this->indexToFileMap->find(fileValue) != this->indexToFileMap->end())
                 {
                     int lineValue = atoi(line);
-                    const std::pair<std::string, std::string>& func = this->indexToFileMap[fileValue];
+                    const std::pair<std::string, std::string>& func = this->indexToFileMap->find(fileValue)->second;
                     std::string msg = Format("OpenGL error in function '%s' at row %d:%s in file %s.\n", func.first.c_str(), lineValue, lineRow, func.second.c_str());
 					generator->Error(msg);
                 }
@@ -682,10 +624,10 @@ Shader::GLSLProblemIntelATI(Generator* generator, std::stringstream& stream)
                     std::string msg = Format("OpenGL warning: %s at row %d in file %s.\n", lineRow, lineValue, this->func.GetFile().c_str());
 					generator->Warning(msg);
 				}
-                else if (this->indexToFileMap.find(fileValue) != this->indexToFileMap.end())
+                else if (this->indexToFileMap->find(fileValue) != this->indexToFileMap->end())
                 {
                     int lineValue = atoi(line);
-                    const std::pair<std::string, std::string>& func = this->indexToFileMap[fileValue];
+                    const std::pair<std::string, std::string>& func = this->indexToFileMap->find(fileValue)->second;
                     std::string msg = Format("OpenGL warning in function '%s' at row %d:%s in file %s.\n", func.first.c_str(), lineValue, lineRow, func.second.c_str());
 					generator->Warning(msg);
                 }
@@ -738,9 +680,9 @@ Shader::GLSLProblemNvidia(Generator* generator, std::stringstream& stream)
                 std::string msg = Format("OpenGL error: %s at row %d in file %s.\n", lineRow, lineNumber, this->func.GetFile().c_str());
 				generator->Error(msg);
 			}
-            else if (this->indexToFileMap.find(fileNumber) != this->indexToFileMap.end())
+            else if (this->indexToFileMap->find(fileNumber) != this->indexToFileMap->end())
             {
-                const std::pair<std::string, std::string>& func = this->indexToFileMap[fileNumber];
+                const std::pair<std::string, std::string>& func = this->indexToFileMap->find(fileNumber)->second;
                 std::string msg = Format("OpenGL error in function '%s' at row %d:%s in file %s.\n", func.first.c_str(), lineNumber, lineRow, func.second.c_str());
 				generator->Error(msg);
             }
@@ -762,9 +704,9 @@ Shader::GLSLProblemNvidia(Generator* generator, std::stringstream& stream)
                 std::string msg = Format("OpenGL warning: %s at row %d in file %s.\n", lineRow, lineNumber, this->func.GetFile().c_str());
 				generator->Warning(msg);
 			}
-            else if (this->indexToFileMap.find(fileNumber) != this->indexToFileMap.end())
+            else if (this->indexToFileMap->find(fileNumber) != this->indexToFileMap->end())
             {
-                const std::pair<std::string, std::string>& func = this->indexToFileMap[fileNumber];
+                const std::pair<std::string, std::string>& func = this->indexToFileMap->find(fileNumber)->second;
                 std::string msg = Format("OpenGL warning in function '%s' at row %d:%s in file %s.\n", func.first.c_str(), lineNumber, lineRow, func.second.c_str());
 				generator->Warning(msg);
             }            
@@ -825,10 +767,10 @@ Shader::GLSLProblemKhronos(Generator* generator, std::stringstream& stream)
 #endif
 					generator->Error(msg);
 				}
-				else if (this->indexToFileMap.find(fileValue) != this->indexToFileMap.end())
+				else if (this->indexToFileMap->find(fileValue) != this->indexToFileMap->end())
 				{
 					int lineValue = atoi(line);
-					const std::pair<std::string, std::string>& func = this->indexToFileMap[fileValue];
+					const std::pair<std::string, std::string>& func = this->indexToFileMap->find(fileValue)->second;
 #if _MSC_VER
 					std::string msg = Format("%s(%d): error: function '%s' %s", func.first.c_str(), lineValue, func.second.c_str(), lineRow);
 #else
@@ -869,10 +811,10 @@ Shader::GLSLProblemKhronos(Generator* generator, std::stringstream& stream)
 #endif
 					generator->Warning(msg);
 				}
-				else if (this->indexToFileMap.find(fileValue) != this->indexToFileMap.end())
+				else if (this->indexToFileMap->find(fileValue) != this->indexToFileMap->end())
 				{
 					int lineValue = atoi(line);
-					const std::pair<std::string, std::string>& func = this->indexToFileMap[fileValue];
+					const std::pair<std::string, std::string>& func = this->indexToFileMap->find(fileValue)->second;
 #if _MSC_VER
 					std::string msg = Format("%s(%d): warning: function '%s' %s", func.first.c_str(), lineValue, func.second.c_str(), lineRow);
 #else
@@ -68,18 +68,16 @@ public:
 
 	/// sets up shader
 	void Setup();
-	/// generates code for shader
+	/// generates code for shader, declarations and the file map are shared by all shaders in the effect and must outlive the shader
 	void Generate(
 		Generator& generator,
-		const std::vector<Variable>& vars,
-		const std::vector<Structure>& structures,
-		const std::vector<Constant>& constants,
-		const std::vector<VarBlock>& blocks, 
-        const std::vector<VarBuffer>& buffers,
-		const std::vector<Sampler>& samplers,
-        const std::vector<Subroutine>& subroutines,
-		const std::vector<Function>& functions,
+		const std::string& declarations,
+		const std::map<int, std::pair<std::string, std::string> >& indexToFileMap,
 		const std::vector<std::string>& passthroughPPs);
+	/// parses generated code if it hasn't been already, programs call this when their binaries weren't cached
+	void Parse(Generator& generator);
+	/// continues hash with everything which decides the stage binary, only valid after Generate
+	unsigned long long HashSources(unsigned long long hash) const;
 
 	/// static function which resets all bindings
 	static void ResetBindings();
@@ -155,7 +153,9 @@ private:
 	bool binaryValid;
 
 	std::string preamble;
-    std::map<int, std::pair<std::string, std::string> > indexToFileMap;
+	std::string code;
+	const std::string* declarations;
+    const std::map<int, std::pair<std::string, std::string> >* indexToFileMap;
 	std::map<std::string, std::string> subroutineMappings;
 
 }; 
@@ -23,6 +23,14 @@ public:
 	Structure();
 	/// destructor
 	virtual ~Structure();
+	/// copy constructor
+	Structure(const Structure&) = default;
+	/// move constructor
+	Structure(Structure&&) = default;
+	/// copy assignment
+	Structure& operator=(const Structure&) = default;
+	/// move assignment
+	Structure& operator=(Structure&&) = default;
 
 	/// adds a parameter
 	void AddParameter(const Parameter& param);
@@ -30,6 +30,14 @@ public:
 	Subroutine();
 	/// destructor
 	virtual ~Subroutine();
+	/// copy constructor
+	Subroutine(const Subroutine&) = default;
+	/// move constructor
+	Subroutine(Subroutine&&) = default;
+	/// copy assignment
+	Subroutine& operator=(const Subroutine&) = default;
+	/// move assignment
+	Subroutine& operator=(Subroutine&&) = default;
 
     /// set type
     void SetSubroutineType(const SubroutineType& type);
@@ -9,6 +9,7 @@
 */
 //------------------------------------------------------------------------------
 #include "compileable.h"
+#include "compilearena.h"
 
 #include <string>
 namespace AnyFX
@@ -37,11 +38,21 @@ public:
 	Symbol();
 	/// destructor
 	virtual ~Symbol();
+	/// copy constructor
+	Symbol(const Symbol&) = default;
+	/// move constructor
+	Symbol(Symbol&&) = default;
+	/// copy assignment
+	Symbol& operator=(const Symbol&) = default;
+	/// move assignment
+	Symbol& operator=(Symbol&&) = default;
 
 	/// set name of program
 	void SetName(const std::string& name);
 	/// gets name of program
 	const std::string& GetName() const;
+	/// get name interned in the compile arena, symbols with equal names share the same pointer, NULL if named outside a compile
+	const std::string* GetInternedName() const;
     /// set if symbol is a reserved (by the compiler)
     void SetReserved(bool b);
     /// get if symbol is reserved
@@ -56,6 +67,7 @@ protected:
 
     bool reserved;
 	std::string name;
+	const std::string* internedName;
 	std::string signature;
 	Type symbolType;
 }; 
@@ -67,6 +79,8 @@ inline void
 Symbol::SetName(const std::string& name)
 {
 	this->name = name;
+	CompileArena* arena = CompileArena::GetCurrent();
+	this->internedName = arena ? &arena->Intern(name) : NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -78,6 +92,15 @@ Symbol::GetName() const
 	return this->name;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline const std::string*
+Symbol::GetInternedName() const
+{
+	return this->internedName;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -5,6 +5,9 @@
 #include "typechecker.h"
 #include "util.h"
 #include "symbol.h"
+#include "function.h"
+#include "renderstate.h"
+#include "structure.h"
 
 namespace AnyFX
 {
@@ -15,10 +18,14 @@ TypeChecker* TypeChecker::instance = 0;
 */
 TypeChecker::TypeChecker() :
 	errorCount(0),
-	warningCount(0)
+	warningCount(0),
+	numSymbols(0)
 {
 	assert(0 == instance);
 	instance = this;
+
+	SymbolEntry empty = { 0, NULL, NULL, InvalidIndex };
+	this->symbols.resize(256, empty);
 }
 
 //------------------------------------------------------------------------------
@@ -40,33 +47,95 @@ TypeChecker::Instance()
 	return instance;
 }
 
+//------------------------------------------------------------------------------
+/**
+	Linear probing, the table is a power of two and never more than half full so a probe always ends
+*/
+unsigned
+TypeChecker::FindEntry(const std::string& name, const std::string* interned, unsigned hash) const
+{
+	const unsigned mask = (unsigned)this->symbols.size() - 1;
+	unsigned index = hash & mask;
+	for (;;)
+	{
+		const SymbolEntry& entry = this->symbols[index];
+		if (entry.symbol == NULL) return index;
+		if (entry.hash == hash)
+		{
+			if (interned != NULL && entry.name == interned) return index;
+			if (*entry.name == name) return index;
+		}
+		index = (index + 1) & mask;
+	}
+}
+
 //------------------------------------------------------------------------------
 /**
 */
+void
+TypeChecker::Grow()
+{
+	std::vector<SymbolEntry> old;
+	old.swap(this->symbols);
+	SymbolEntry empty = { 0, NULL, NULL, InvalidIndex };
+	this->symbols.resize(old.size() * 2, empty);
+
+	const unsigned mask = (unsigned)this->symbols.size() - 1;
+	unsigned i;
+	for (i = 0; i < old.size(); i++)
+	{
+		if (old[i].symbol == NULL) continue;
+		unsigned index = old[i].hash & mask;
+		while (this->symbols[index].symbol != NULL) index = (index + 1) & mask;
+		this->symbols[index] = old[i];
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Symbols with the same name but different signatures are kept as overloads of the first one
+*/
 bool
 TypeChecker::AddSymbol(Symbol* symbol)
 {
-	if (this->symbols.find(symbol->GetName()) != this->symbols.end())
+	const std::string& name = symbol->GetName();
+	const std::string* interned = symbol->GetInternedName();
+	unsigned hash = HashString(name.c_str(), name.length());
+	unsigned index = this->FindEntry(name, interned, hash);
+	SymbolEntry& entry = this->symbols[index];
+
+	if (entry.symbol != NULL)
 	{
-		Symbol* origSymbol = this->symbols[symbol->GetName()];
-		if (origSymbol->GetSignature() == symbol->GetSignature())
-		{
-			std::string err;
-			if (origSymbol->IsReserved())										err = Format("Symbol '%s' is a reserved name and can not be used.", symbol->GetName().c_str());
-			else																err = Format("Symbol '%s' redefinition at %d in %s. Previously defined near row %d in %s\n", symbol->GetName().c_str(), symbol->GetLine(), symbol->GetFile().c_str(), origSymbol->GetLine(), origSymbol->GetFile().c_str());
-			this->Error(err);
-			return false;
-		}        
-		else
+		// check the signature against every symbol already declared with this name
+		Symbol* origSymbol = entry.symbol;
+		unsigned overload = entry.overloads;
+		for (;;)
 		{
-			// register with signature instead, this however makes the symbol unable to be looked up
-			this->symbols[symbol->GetSignature()] = symbol;
-			return true;
+			if (origSymbol->GetSignature() == symbol->GetSignature())
+			{
+				std::string err;
+				if (origSymbol->IsReserved())										err = Format("Symbol '%s' is a reserved name and can not be used.", name.c_str());
+				else																err = Format("Symbol '%s' redefinition at %d in %s. Previously defined near row %d in %s\n", name.c_str(), symbol->GetLine(), symbol->GetFile().c_str(), origSymbol->GetLine(), origSymbol->GetFile().c_str());
+				this->Error(err);
+				return false;
+			}
+			if (overload == InvalidIndex) break;
+			origSymbol = this->overloads[overload].symbol;
+			overload = this->overloads[overload].next;
 		}
+
+		Overload entryOverload = { symbol, entry.overloads };
+		entry.overloads = (unsigned)this->overloads.size();
+		this->overloads.push_back(entryOverload);
+		return true;
 	}
 	else
 	{
-		this->symbols[symbol->GetName()] = symbol;
+		entry.hash = hash;
+		entry.name = interned ? interned : &name;
+		entry.symbol = symbol;
+		entry.overloads = InvalidIndex;
+		if (++this->numSymbols * 2 > this->symbols.size()) this->Grow();
 		return true;
 	}
 }
@@ -77,7 +146,7 @@ TypeChecker::AddSymbol(Symbol* symbol)
 bool
 TypeChecker::HasSymbol(const std::string& name)
 {
-	return this->symbols.find(name) != this->symbols.end();
+	return this->FindSymbol(name) != NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -86,16 +155,53 @@ TypeChecker::HasSymbol(const std::string& name)
 Symbol*
 TypeChecker::GetSymbol(const std::string& name)
 {
-	if (this->symbols.find(name) == this->symbols.end())
+	Symbol* symbol = this->FindSymbol(name);
+	if (symbol == NULL)
 	{
 		std::string err = Format("Symbol '%s' is not defined\n", name.c_str());
 		this->Error(err);
-		return NULL;
-	}
-	else
-	{
-		return this->symbols[name];
 	}
+	return symbol;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Symbol*
+TypeChecker::FindSymbol(const std::string& name)
+{
+	unsigned hash = HashString(name.c_str(), name.length());
+	return this->symbols[this->FindEntry(name, NULL, hash)].symbol;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Function*
+TypeChecker::FindFunction(const std::string& name)
+{
+	Symbol* symbol = this->FindSymbol(name);
+	return symbol && symbol->GetType() == Symbol::FunctionType ? static_cast<Function*>(symbol) : NULL;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+RenderState*
+TypeChecker::FindRenderState(const std::string& name)
+{
+	Symbol* symbol = this->FindSymbol(name);
+	return symbol && symbol->GetType() == Symbol::RenderStateType ? static_cast<RenderState*>(symbol) : NULL;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Structure*
+TypeChecker::FindStructure(const std::string& name)
+{
+	Symbol* symbol = this->FindSymbol(name);
+	return symbol && symbol->GetType() == Symbol::StructureType ? static_cast<Structure*>(symbol) : NULL;
 }
 
 //------------------------------------------------------------------------------
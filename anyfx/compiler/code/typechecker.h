@@ -5,18 +5,26 @@
     
     The type checker assures default values for variables match their types
 	and also makes sure shader linkage is possible
+
+	Symbols live in an open addressed hash table keyed on their name. Names
+	interned by the compile arena are compared by address before falling back
+	on the characters. Overloads share the entry of their name, so the first
+	symbol registered is what name lookups return.
     
     (C) 2013 Gustav Sterbrant
 */
 //------------------------------------------------------------------------------
 #include <string>
-#include <map>
+#include <vector>
 #include "util.h"
 #include "header.h"
 
 namespace AnyFX
 {
 class Symbol;
+class Function;
+class RenderState;
+class Structure;
 class TypeChecker
 {
 public:
@@ -44,6 +52,14 @@ public:
 	bool HasSymbol(const std::string& name);
 	/// gets symbol from type checker
 	Symbol* GetSymbol(const std::string& name);
+	/// gets symbol if it exists, without reporting an error if it doesn't
+	Symbol* FindSymbol(const std::string& name);
+	/// gets function, returns NULL if there is no symbol with the name or it's not a function
+	Function* FindFunction(const std::string& name);
+	/// gets render state, returns NULL if there is no symbol with the name or it's not a render state
+	RenderState* FindRenderState(const std::string& name);
+	/// gets structure, returns NULL if there is no symbol with the name or it's not a structure
+	Structure* FindStructure(const std::string& name);
 
 	/// posts a type error
 	void Error(const std::string& message);
@@ -74,14 +90,36 @@ public:
 	const std::string& GetErrorBuffer() const;
 private:
 
+	struct SymbolEntry
+	{
+		unsigned hash;
+		const std::string* name;	// interned name of the first symbol, or its own name if declared outside a compile
+		Symbol* symbol;				// NULL if entry is empty
+		unsigned overloads;			// index of first overload, or InvalidIndex
+	};
+
+	struct Overload
+	{
+		Symbol* symbol;
+		unsigned next;
+	};
+
+	static const unsigned InvalidIndex = 0xFFFFFFFF;
+
+	/// get index of entry with name, or of the empty entry where it should go
+	unsigned FindEntry(const std::string& name, const std::string* interned, unsigned hash) const;
+	/// double the size of the table and reinsert all entries
+	void Grow();
+
 	Header header;
 	static TypeChecker* instance;
 
 	std::string errorBuffer;
 	unsigned errorCount;
 	unsigned warningCount;
-	std::map<std::string, Symbol*> symbols;
-    std::map<std::string, Symbol*> reservedSymbols;
+	std::vector<SymbolEntry> symbols;
+	std::vector<Overload> overloads;
+	unsigned numSymbols;
 }; 
 
 //------------------------------------------------------------------------------
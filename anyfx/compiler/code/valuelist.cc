@@ -76,8 +76,11 @@ ValueList::ConvertToString(const DataType& type, TypeChecker& typechecker)
 		break;
 	}
 
-	// clear string
+	// clear string and binary
 	this->formattedString.clear();
+	this->binary.clear();
+	bool isDouble = type.GetType() >= DataType::Double && type.GetType() <= DataType::Double4;
+	bool isShort = type.GetType() >= DataType::Short && type.GetType() <= DataType::Short4;
 
 	unsigned i;
 	for (i = 0; i < this->values.size(); i++)
@@ -91,14 +94,33 @@ ValueList::ConvertToString(const DataType& type, TypeChecker& typechecker)
 
 		if (code == FLOAT)
 		{
-			fragment = Format("%f", this->values[i]->EvalFloat(typechecker));
+			float value = this->values[i]->EvalFloat(typechecker);
+			fragment = Format("%f", value);
 			this->formattedString.append(fragment);
+			if (isDouble)
+			{
+				double d = value;
+				this->binary.insert(this->binary.end(), (const char*)&d, (const char*)&d + sizeof(double));
+			}
+			else this->binary.insert(this->binary.end(), (const char*)&value, (const char*)&value + sizeof(float));
 		}
 		else if (code == INTEGER ||
 				 code == BOOLEAN)
 		{
-			fragment = Format("%d", this->values[i]->EvalInt(typechecker));
+			int value = this->values[i]->EvalInt(typechecker);
+			fragment = Format("%d", value);
 			this->formattedString.append(fragment);
+			if (code == BOOLEAN)
+			{
+				bool b = value != 0;
+				this->binary.insert(this->binary.end(), (const char*)&b, (const char*)&b + sizeof(bool));
+			}
+			else if (isShort)
+			{
+				short sh = (short)value;
+				this->binary.insert(this->binary.end(), (const char*)&sh, (const char*)&sh + sizeof(short));
+			}
+			else this->binary.insert(this->binary.end(), (const char*)&value, (const char*)&value + sizeof(int));
 		}
 		else
 		{
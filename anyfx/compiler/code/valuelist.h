@@ -23,6 +23,14 @@ public:
 	ValueList();
 	/// destructor
 	virtual ~ValueList();
+	/// copy constructor
+	ValueList(const ValueList&) = default;
+	/// move constructor
+	ValueList(ValueList&&) = default;
+	/// copy assignment
+	ValueList& operator=(const ValueList&) = default;
+	/// move assignment
+	ValueList& operator=(ValueList&&) = default;
 
 	/// set value as string, decomposes into inferred type
 	void AddValue(Expression* expr);
@@ -33,12 +41,15 @@ public:
 
 	/// return value list as string
 	const std::string& GetString() const;
+	/// return value list as binary, laid out as the runtime stores the value
+	const std::vector<char>& GetBinary() const;
 	
-	/// converts valuelist to string
+	/// converts valuelist to string and binary
 	void ConvertToString(const DataType& type, TypeChecker& typechecker);
 
 private:
 	std::string formattedString;
+	std::vector<char> binary;
 	std::vector<Expression*> values;
 }; 
 
@@ -69,6 +80,15 @@ ValueList::GetString() const
 	return this->formattedString;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline const std::vector<char>&
+ValueList::GetBinary() const
+{
+	return this->binary;
+}
+
 
 } // namespace AnyFX
 //------------------------------------------------------------------------------
\ No newline at end of file
@@ -17,6 +17,8 @@ namespace AnyFX
 /**
 */
 VarBlock::VarBlock() :
+	alignedSize(0),
+	pushConstantOffset(0),
 	hasAnnotation(false),
 	group(0),
 	binding(0)
@@ -96,7 +98,6 @@ VarBlock::TypeCheck(TypeChecker& typechecker)
 		Shader::bindingIndices[this->group]++;
 	}
 
-	unsigned offset = 0;
 	unsigned i;
 	for (i = 0; i < this->variables.size(); i++)
 	{
@@ -110,8 +111,55 @@ VarBlock::TypeCheck(TypeChecker& typechecker)
 
         // since TypeCheck might modify the variable, we must replace the old one. 
 		var.TypeCheck(typechecker);
+	}
+
+	// now we know array sizes, so compute offsets, if we have a push constant, use std430, otherwise std140
+	this->Layout(0, !HasFlags(this->qualifierFlags, Qualifiers::Push), typechecker);
+
+	Header::Type type = header.GetType();
+	int major = header.GetMajor();
+	if (type == Header::GLSL)
+	{
+		if (major < 3)
+		{
+			std::string message = AnyFX::Format("Varblocks are only supported in GLSL versions 3+, %s\n", this->ErrorSuffix().c_str());
+			typechecker.Error(message);
+		}
+	}
+	else if (type == Header::HLSL)
+	{
+		if (major < 4)
+		{
+			std::string message = AnyFX::Format("Varblocks are only supported in HLSL versions 4+, %s\n", this->ErrorSuffix().c_str());
+			typechecker.Error(message);
+		}
+	}
+	else if (type == Header::SPIRV)
+	{
+		if (HasFlags(this->qualifierFlags, Qualifiers::Shared | Qualifiers::Push))
+		{
+			std::string message = AnyFX::Format("Varblocks can not both qualifiers 'shared' and 'push', %s\n", this->ErrorSuffix().c_str());
+			typechecker.Error(message);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Offsets are absolute, so blocks laid out from a non-zero offset can share a range with other blocks.
+*/
+void
+VarBlock::Layout(unsigned offset, bool std140, TypeChecker& typechecker)
+{
+	const Header& header = typechecker.GetHeader();
+	this->offsetsByName.clear();
+	this->pushConstantOffset = offset;
+
+	unsigned i;
+	for (i = 0; i < this->variables.size(); i++)
+	{
+		Variable& var = this->variables[i];
 
-		// handle offset later, now we know array size
 		unsigned alignedSize = 0;
 		unsigned stride = 0;
 		unsigned elementStride = 0;
@@ -119,11 +167,7 @@ VarBlock::TypeCheck(TypeChecker& typechecker)
 		std::vector<unsigned> suboffsets;
 		if (header.GetType() == Header::GLSL || header.GetType() == Header::SPIRV)
 		{
-			// if we have a push constant, use std430, otherwise std140
-			if (HasFlags(this->qualifierFlags, Qualifiers::Push))
-				alignment = Effect::GetAlignmentGLSL(var.GetDataType(), var.GetArraySize(), alignedSize, stride, elementStride, suboffsets, false, typechecker);
-			else
-				alignment = Effect::GetAlignmentGLSL(var.GetDataType(), var.GetArraySize(), alignedSize, stride, elementStride, suboffsets, true, typechecker);
+			alignment = Effect::GetAlignmentGLSL(var.GetDataType(), var.GetArraySize(), alignedSize, stride, elementStride, suboffsets, std140, typechecker);
 		}
 
 		// if we have a struct, we need to unroll it, and calculate the offsets
@@ -162,38 +206,57 @@ VarBlock::TypeCheck(TypeChecker& typechecker)
 			this->offsetsByName[var.GetName()] = offset;
 		}
 
+
 		// offset should be size of struct, round of
 		offset += alignedSize;
 	}
 	// aligned size must be the sum of all offsets
-	this->alignedSize = offset;
+	this->alignedSize = offset - this->pushConstantOffset;
+}
 
-	Header::Type type = header.GetType();
-	int major = header.GetMajor();
-	if (type == Header::GLSL)
+//------------------------------------------------------------------------------
+/**
+	Shared blocks must keep their layout across effects and range bound blocks live in buffers, so neither can move to push constants.
+*/
+bool
+VarBlock::IsPromotable() const
+{
+	const Qualifiers excluded = Qualifiers::Shared | Qualifiers::Push | Qualifiers::RangeBind;
+	return !this->variables.empty() && (this->qualifierFlags & excluded) == Qualifiers::None;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+VarBlock::PromoteToPushConstants(unsigned offset, unsigned budget, TypeChecker& typechecker)
+{
+	this->Layout(offset, false, typechecker);
+	if (offset + this->alignedSize > budget)
 	{
-		if (major < 3)
-		{
-			std::string message = AnyFX::Format("Varblocks are only supported in GLSL versions 3+, %s\n", this->ErrorSuffix().c_str());
-			typechecker.Error(message);
-		}
+		this->Layout(0, true, typechecker);
+		return false;
 	}
-	else if (type == Header::HLSL)
-	{
-		if (major < 4)
-		{
-			std::string message = AnyFX::Format("Varblocks are only supported in HLSL versions 4+, %s\n", this->ErrorSuffix().c_str());
-			typechecker.Error(message);
-		}
-	}
-	else if (type == Header::SPIRV)
+	this->qualifierFlags |= Qualifiers::Push | Qualifiers::Promoted;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Members are placed explicitly, since the merged block holds several varblocks which were laid out one after the other.
+*/
+std::string
+VarBlock::FormatPushConstantMembers(const Header& header) const
+{
+	std::string formattedCode;
+	unsigned i;
+	for (i = 0; i < this->variables.size(); i++)
 	{
-		if (HasFlags(this->qualifierFlags, Qualifiers::Shared | Qualifiers::Push))
-		{
-			std::string message = AnyFX::Format("Varblocks can not both qualifiers 'shared' and 'push', %s\n", this->ErrorSuffix().c_str());
-			typechecker.Error(message);
-		}
+		const Variable& var = this->variables[i];
+		formattedCode.append(AnyFX::Format("layout(offset=%d) ", var.alignedOffset));
+		formattedCode.append(var.Format(header, true));
 	}
+	return formattedCode;
 }
 
 //------------------------------------------------------------------------------
@@ -207,6 +270,9 @@ VarBlock::Format(const Header& header) const
     // only output if we have variables
     if (this->variables.empty()) return formattedCode;
 
+	// promoted blocks are part of the push constant block formatted by the effect
+	if (this->IsPromoted()) return formattedCode;
+
     if (HasFlags(this->qualifierFlags, Qualifiers::Shared))
     {
         // varblocks of this type are only available in GLSL3-4, HLSL4-5 and SPIR-V
@@ -23,6 +23,14 @@ public:
 	VarBlock();
 	/// destructor
 	virtual ~VarBlock();
+	/// copy constructor
+	VarBlock(const VarBlock&) = default;
+	/// move constructor
+	VarBlock(VarBlock&&) = default;
+	/// copy assignment
+	VarBlock& operator=(const VarBlock&) = default;
+	/// move assignment
+	VarBlock& operator=(VarBlock&&) = default;
 
 	/// set annotation
 	void SetAnnotation(const Annotation& annotation);
@@ -40,18 +48,34 @@ public:
 
 	/// type checks var block
 	void TypeCheck(TypeChecker& typechecker);
+	/// returns true if block may be promoted to push constants
+	bool IsPromotable() const;
+	/// lay block out as push constants starting at offset, fails and keeps the uniform buffer layout if it would end past the budget
+	bool PromoteToPushConstants(unsigned offset, unsigned budget, TypeChecker& typechecker);
+	/// returns true if block was promoted to push constants
+	bool IsPromoted() const;
+	/// get offset of block in the push constant range
+	unsigned GetPushConstantOffset() const;
+	/// get size of block
+	unsigned GetAlignedSize() const;
 	/// compiles var block
 	void Compile(BinWriter& writer);
 
-	/// format variable to fit target language
+	/// format variable to fit target language, promoted blocks are left to the effect which merges them into one push constant block
 	std::string Format(const Header& header) const;
+	/// format variables as members of the merged push constant block
+	std::string FormatPushConstantMembers(const Header& header) const;
 
 private:
 
+	/// compute variable offsets, starting at offset, using std140 or the std430 layout of push constants
+	void Layout(unsigned offset, bool std140, TypeChecker& typechecker);
+
 	friend class Effect;
 	std::vector<Variable> variables;
 	std::map<std::string, unsigned> offsetsByName;
 	unsigned alignedSize;
+	unsigned pushConstantOffset;
 
 	unsigned group;
 	unsigned binding;
@@ -60,6 +84,33 @@ private:
 	Annotation annotation;
 }; 
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+VarBlock::IsPromoted() const
+{
+	return HasFlags(this->qualifierFlags, Qualifiers::Promoted);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+VarBlock::GetPushConstantOffset() const
+{
+	return this->pushConstantOffset;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline unsigned
+VarBlock::GetAlignedSize() const
+{
+	return this->alignedSize;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
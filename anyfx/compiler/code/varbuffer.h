@@ -23,6 +23,14 @@ public:
 	VarBuffer();
 	/// destructor
 	virtual ~VarBuffer();
+	/// copy constructor
+	VarBuffer(const VarBuffer&) = default;
+	/// move constructor
+	VarBuffer(VarBuffer&&) = default;
+	/// copy assignment
+	VarBuffer& operator=(const VarBuffer&) = default;
+	/// move assignment
+	VarBuffer& operator=(VarBuffer&&) = default;
 
 	/// set annotation
 	void SetAnnotation(const Annotation& annotation);
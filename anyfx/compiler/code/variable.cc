@@ -444,6 +444,16 @@ Variable::Compile(BinWriter& writer)
 
 		// write amount of array default variables
 		writer.WriteString(valueString);
+
+		// write values precomputed in the runtime layout, so the loader can copy them straight in
+		std::vector<char> binary;
+		for (i = 0; i < this->valueTable.size(); i++)
+		{
+			const std::vector<char>& values = this->valueTable[i].second.GetBinary();
+			binary.insert(binary.end(), values.begin(), values.end());
+		}
+		writer.WriteUInt(binary.size());
+		if (!binary.empty()) writer.WriteBytes(binary.data(), binary.size());
 	}
 }
 
@@ -104,6 +104,14 @@ public:
 	Variable();
 	/// destructor
 	virtual ~Variable();
+	/// copy constructor
+	Variable(const Variable&) = default;
+	/// move constructor
+	Variable(Variable&&) = default;
+	/// copy assignment
+	Variable& operator=(const Variable&) = default;
+	/// move assignment
+	Variable& operator=(Variable&&) = default;
 
     /// set annotation
     void SetAnnotation(const Annotation& annotation);
@@ -4,6 +4,7 @@
 //------------------------------------------------------------------------------
 #include "binreader.h"
 #include <sstream>
+#include <string.h>
 
 static char encryptionTable[] = {'A', 'T', 'C', 'G', 'F', 'F', 'W', 'I', 'T', 'C', 'H', 'E', 'R'};
 namespace AnyFX
@@ -15,7 +16,10 @@ namespace AnyFX
 BinReader::BinReader() :
 	isOpen(false),
 	inputFile(NULL),
-	inputString(NULL)
+	inputData(NULL),
+	inputSize(0),
+	inputPos(0),
+	inputEof(false)
 {
 	// empty
 }
@@ -46,8 +50,10 @@ BinReader::Open()
 bool
 BinReader::Open(const char* data, size_t size)
 {
-	this->inputString = new std::istringstream;
-	this->inputString->str(std::string(data, size));
+	this->inputData = data;
+	this->inputSize = size;
+	this->inputPos = 0;
+	this->inputEof = false;
 	this->isOpen = true;
 	return this->isOpen;
 }
@@ -63,10 +69,33 @@ BinReader::Close()
 	{
 		this->inputFile->close();
 		delete this->inputFile;
+		this->inputFile = NULL;
 	}
-	else if (this->inputString)
+	this->inputData = NULL;
+	this->inputSize = 0;
+	this->inputPos = 0;
+	this->isOpen = false;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Memory reads behave like the file stream, reading past the end flags eof
+*/
+void
+BinReader::Read(char* dst, unsigned numbytes)
+{
+	if (this->inputFile) this->inputFile->read(dst, numbytes);
+	else
 	{
-		delete this->inputString;
+		size_t available = this->inputSize - this->inputPos;
+		if (numbytes > available)
+		{
+			memset(dst, 0, numbytes);
+			numbytes = (unsigned)available;
+			this->inputEof = true;
+		}
+		memcpy(dst, this->inputData + this->inputPos, numbytes);
+		this->inputPos += numbytes;
 	}
 }
 
@@ -78,8 +107,7 @@ BinReader::ReadInt()
 {
 	assert(this->isOpen);
 	int value;
-	if (this->inputFile) this->inputFile->read((char*)&value, sizeof(int));
-	else this->inputString->read((char*)&value, sizeof(int));
+	this->Read((char*)&value, sizeof(int));
 	return value;
 }
 
@@ -91,8 +119,19 @@ BinReader::ReadUInt()
 {
 	assert(this->isOpen);
 	unsigned value;
-	if (this->inputFile) this->inputFile->read((char*)&value, sizeof(unsigned));
-	else this->inputString->read((char*)&value, sizeof(unsigned));
+	this->Read((char*)&value, sizeof(unsigned));
+	return value;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned long long
+BinReader::ReadUInt64()
+{
+	assert(this->isOpen);
+	unsigned long long value;
+	this->Read((char*)&value, sizeof(unsigned long long));
 	return value;
 }
 
@@ -104,8 +143,7 @@ BinReader::ReadBool()
 {
 	assert(this->isOpen);
 	bool value;
-	if (this->inputFile) this->inputFile->read((char*)&value, sizeof(bool));
-	else this->inputString->read((char*)&value, sizeof(bool));
+	this->Read((char*)&value, sizeof(bool));
 	return value;
 }
 
@@ -117,8 +155,7 @@ BinReader::ReadFloat()
 {
 	assert(this->isOpen);
 	float value;
-	if (this->inputFile) this->inputFile->read((char*)&value, sizeof(float));
-	else this->inputString->read((char*)&value, sizeof(float));
+	this->Read((char*)&value, sizeof(float));
 	return value;
 }
 
@@ -130,8 +167,7 @@ BinReader::ReadDouble()
 {
 	assert(this->isOpen);
 	double value;
-	if (this->inputFile) this->inputFile->read((char*)&value, sizeof(double));
-	else this->inputString->read((char*)&value, sizeof(double));
+	this->Read((char*)&value, sizeof(double));
 	return value;
 }
 
@@ -143,8 +179,7 @@ BinReader::ReadShort()
 {
 	assert(this->isOpen);
 	short value;
-	if (this->inputFile) this->inputFile->read((char*)&value, sizeof(int));
-	else this->inputString->read((char*)&value, sizeof(int));
+	this->Read((char*)&value, sizeof(int));
 	return value;
 }
 
@@ -163,8 +198,7 @@ BinReader::ReadString()
 	char* buf = new char[len];
 
 	// finally read to string
-	if (this->inputFile) this->inputFile->read(buf, len);
-	else this->inputString->read(buf, len);
+	this->Read(buf, len);
 
 	// decrypt using simple XOR encryption
 	unsigned i;
@@ -187,7 +221,7 @@ BinReader::ReadChar()
 	assert(this->isOpen);
 	char c;
 	if (this->inputFile) this->inputFile->get(c);
-	else this->inputString->get(c);
+	else this->Read(&c, 1);
 	return c;
 }
 
@@ -200,13 +234,21 @@ BinReader::ReadBytes(unsigned numbytes)
 	if (numbytes > 0)
 	{
 		char* value = new char[numbytes];
-		if (this->inputFile) this->inputFile->read(value, numbytes);
-		else this->inputString->read(value, numbytes);
+		this->Read(value, numbytes);
 		return value;
 	}
 	return NULL;	
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BinReader::ReadBytes(char* dst, unsigned numbytes)
+{
+	if (numbytes > 0) this->Read(dst, numbytes);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -214,6 +256,45 @@ void
 BinReader::Skip(unsigned n)
 {
 	if (this->inputFile) this->inputFile->ignore(n);
-	else this->inputString->ignore(n);
+	else
+	{
+		if (this->inputPos + n > this->inputSize)
+		{
+			this->inputPos = this->inputSize;
+			this->inputEof = true;
+		}
+		else this->inputPos += n;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BinReader::Seek(unsigned offset)
+{
+	assert(this->isOpen);
+	if (this->inputFile)
+	{
+		this->inputFile->clear();
+		this->inputFile->seekg(offset, std::ios::beg);
+	}
+	else
+	{
+		assert(offset <= this->inputSize);
+		this->inputPos = offset;
+		this->inputEof = false;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned
+BinReader::Tell() const
+{
+	assert(this->isOpen);
+	if (this->inputFile) return (unsigned)this->inputFile->tellg();
+	else return (unsigned)this->inputPos;
 }
 } // namespace AnyFX
\ No newline at end of file
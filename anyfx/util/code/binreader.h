@@ -28,7 +28,7 @@ public:
 	void SetPath(const std::string& path);
 	/// opens reader from set path
 	bool Open();
-	/// opens reader on buffer
+	/// opens reader on buffer, the buffer is read in place and must outlive the reader
 	bool Open(const char* data, size_t size);
 	/// closes reader
 	void Close();
@@ -41,6 +41,8 @@ public:
 	int ReadInt();
 	/// reads unsigned integer
 	unsigned ReadUInt();
+	/// reads 64 bit unsigned integer
+	unsigned long long ReadUInt64();
 	/// reads boolean
 	bool ReadBool();
 	/// reads float
@@ -55,13 +57,25 @@ public:
 	char ReadChar();
 	/// reads byte array, remember to delete it when it is no longer needed
 	char* ReadBytes(unsigned numbytes);
+	/// read bytes into existing buffer
+	void ReadBytes(char* dst, unsigned numbytes);
 	/// skips n characters in stream
 	void Skip(unsigned n);
+	/// moves read position to absolute offset in stream
+	void Seek(unsigned offset);
+	/// returns absolute read position in stream
+	unsigned Tell() const;
 
 private:
+	/// reads raw bytes from either the file or the memory buffer
+	void Read(char* dst, unsigned numbytes);
+
 	std::string path;
 	std::ifstream* inputFile;
-	std::istringstream* inputString;
+	const char* inputData;
+	size_t inputSize;
+	size_t inputPos;
+	bool inputEof;
 	bool isOpen;
 }; 
 
@@ -92,7 +106,7 @@ BinReader::Eof() const
 {
 	assert(this->isOpen);
 	if (this->inputFile) return this->inputFile->eof();
-	else return this->inputString->eof();
+	else return this->inputEof;
 }
 
 } // namespace AnyFX
@@ -72,6 +72,16 @@ BinWriter::WriteUInt(unsigned val)
 	this->output.write((const char*)&val, sizeof(unsigned));
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BinWriter::WriteUInt64(unsigned long long val)
+{
+	// convert to char* and write
+	this->output.write((const char*)&val, sizeof(unsigned long long));
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -157,4 +167,31 @@ BinWriter::WriteBytes(const char* ptr, unsigned numbytes)
 	this->output.write(ptr, numbytes);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned
+BinWriter::Tell()
+{
+	return (unsigned)this->output.tellp();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BinWriter::Seek(unsigned offset)
+{
+	this->output.seekp(offset, std::ios::beg);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BinWriter::SeekToEnd()
+{
+	this->output.seekp(0, std::ios::end);
+}
+
 } // namespace AnyFX
\ No newline at end of file
@@ -35,6 +35,8 @@ public:
 	void WriteInt(int val);
 	/// write unsigned integer
 	void WriteUInt(unsigned val);
+	/// write 64 bit unsigned integer
+	void WriteUInt64(unsigned long long val);
 	/// write boolean
 	void WriteBool(bool val);
 	/// write float
@@ -50,6 +52,13 @@ public:
 	/// write bytes
 	void WriteBytes(const char* ptr, unsigned numbytes);
 
+	/// returns absolute write position in stream
+	unsigned Tell();
+	/// moves write position to absolute offset in stream, used to patch previously written placeholders
+	void Seek(unsigned offset);
+	/// moves write position to the end of the stream
+	void SeekToEnd();
+
 private:
 	std::string path;
 	std::ofstream output;
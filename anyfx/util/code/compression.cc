@@ -0,0 +1,200 @@
+//------------------------------------------------------------------------------
+//  compression.cc
+//  (C) 2016 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "compression.h"
+#include <string.h>
+
+namespace AnyFX
+{
+
+static const unsigned MinMatch = 4;
+static const unsigned LastLiterals = 5;				// the last bytes of a block are always literals
+static const unsigned MatchFindLimit = 12;			// no match may start in the last bytes of a block
+static const unsigned MaxOffset = 65535;
+static const unsigned HashLog = 12;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline unsigned
+Read32(const unsigned char* p)
+{
+	unsigned value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline unsigned
+Hash(unsigned sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HashLog);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Writes a length which doesn't fit in the token as a run of 255 bytes and a remainder
+*/
+static inline unsigned char*
+WriteLength(unsigned char* op, unsigned length)
+{
+	while (length >= 255)
+	{
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned
+LZCompressBound(unsigned size)
+{
+	return size + size / 255 + 16;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned
+LZCompress(const char* src, unsigned srcSize, char* dst, unsigned dstCapacity)
+{
+	const unsigned char* in = (const unsigned char*)src;
+	const unsigned char* ip = in;
+	const unsigned char* anchor = in;
+	const unsigned char* end = in + srcSize;
+	unsigned char* op = (unsigned char*)dst;
+	unsigned char* oend = op + dstCapacity;
+
+	// positions are stored offset by one so zero means empty
+	unsigned table[1 << HashLog];
+	memset(table, 0, sizeof(table));
+
+	if (srcSize > MatchFindLimit)
+	{
+		const unsigned char* matchLimit = end - MatchFindLimit;
+		const unsigned char* matchEnd = end - LastLiterals;
+		while (ip < matchLimit)
+		{
+			unsigned sequence = Read32(ip);
+			unsigned h = Hash(sequence);
+			unsigned candidate = table[h];
+			table[h] = (unsigned)(ip - in) + 1;
+
+			const unsigned char* ref = in + candidate - 1;
+			if (candidate == 0 || (unsigned)(ip - ref) > MaxOffset || Read32(ref) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			// extend match forward
+			unsigned matchLength = MinMatch;
+			while (ip + matchLength < matchEnd && ip[matchLength] == ref[matchLength]) matchLength++;
+
+			// worst case size of this sequence
+			unsigned literalLength = (unsigned)(ip - anchor);
+			if (op + 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1 > oend) return 0;
+
+			unsigned char* token = op++;
+			*token = (unsigned char)((literalLength >= 15 ? 15 : literalLength) << 4);
+			if (literalLength >= 15) op = WriteLength(op, literalLength - 15);
+			memcpy(op, anchor, literalLength);
+			op += literalLength;
+
+			unsigned offset = (unsigned)(ip - ref);
+			*op++ = (unsigned char)(offset & 0xFF);
+			*op++ = (unsigned char)(offset >> 8);
+
+			unsigned extra = matchLength - MinMatch;
+			*token |= (unsigned char)(extra >= 15 ? 15 : extra);
+			if (extra >= 15) op = WriteLength(op, extra - 15);
+
+			ip += matchLength;
+			anchor = ip;
+		}
+	}
+
+	// write remaining bytes as a final literal run
+	unsigned literalLength = (unsigned)(end - anchor);
+	if (op + 1 + literalLength / 255 + 1 + literalLength > oend) return 0;
+	unsigned char* token = op++;
+	*token = (unsigned char)((literalLength >= 15 ? 15 : literalLength) << 4);
+	if (literalLength >= 15) op = WriteLength(op, literalLength - 15);
+	memcpy(op, anchor, literalLength);
+	op += literalLength;
+
+	return (unsigned)(op - (unsigned char*)dst);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+LZDecompress(const char* src, unsigned srcSize, char* dst, unsigned dstSize)
+{
+	const unsigned char* ip = (const unsigned char*)src;
+	const unsigned char* iend = ip + srcSize;
+	unsigned char* op = (unsigned char*)dst;
+	unsigned char* ostart = op;
+	unsigned char* oend = op + dstSize;
+
+	while (ip < iend)
+	{
+		unsigned token = *ip++;
+
+		// read literals
+		unsigned literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			unsigned char b;
+			do
+			{
+				if (ip >= iend) return false;
+				b = *ip++;
+				literalLength += b;
+			} while (b == 255);
+		}
+		if (literalLength > (unsigned)(iend - ip) || literalLength > (unsigned)(oend - op)) return false;
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// the last sequence only has literals
+		if (ip == iend) break;
+
+		if (iend - ip < 2) return false;
+		unsigned offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (unsigned)(op - ostart)) return false;
+
+		unsigned matchLength = token & 15;
+		if (matchLength == 15)
+		{
+			unsigned char b;
+			do
+			{
+				if (ip >= iend) return false;
+				b = *ip++;
+				matchLength += b;
+			} while (b == 255);
+		}
+		matchLength += MinMatch;
+		if (matchLength > (unsigned)(oend - op)) return false;
+
+		// matches may overlap the output, so copy forward byte by byte
+		const unsigned char* ref = op - offset;
+		unsigned i;
+		for (i = 0; i < matchLength; i++) op[i] = ref[i];
+		op += matchLength;
+	}
+	return op == oend;
+}
+
+} // namespace AnyFX
@@ -0,0 +1,33 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file compression.h
+
+    Small LZ codec used to compress shader binaries in the AnyFX binary format.
+
+	The stream follows the LZ4 block layout: a token with literal and match
+	lengths, the literals, and a 16 bit offset back into the output. It favours
+	decompression speed over ratio, which suits SPIR-V since its instructions
+	repeat a lot once the ids have been canonicalised.
+
+    (C) 2016 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+namespace AnyFX
+{
+
+enum Compression
+{
+	NoCompression = 0,
+	LZCompression = 1
+};
+
+/// returns worst case compressed size for the given input size
+unsigned LZCompressBound(unsigned size);
+/// compresses src into dst, returns compressed size or 0 if dst is too small
+unsigned LZCompress(const char* src, unsigned srcSize, char* dst, unsigned dstCapacity);
+/// decompresses src into dst, dstSize must be the exact uncompressed size, returns false on corrupt input
+bool LZDecompress(const char* src, unsigned srcSize, char* dst, unsigned dstSize);
+
+} // namespace AnyFX
+//------------------------------------------------------------------------------
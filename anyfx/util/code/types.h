@@ -30,6 +30,7 @@ enum class Qualifiers : unsigned int
 	Shared = 1,			// resource should have the same layout despite the shader (useful for include headers)
 	Push = 2,			// resource is a push-constant block
 	RangeBind = 4,		// resource can be bound as a range of a buffer	
+	Promoted = 8,		// push-constant block promoted by the compiler, offsets are relative to the start of the push constant range
 };
 ENUM_OPERATORS(Qualifiers)
 
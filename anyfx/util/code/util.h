@@ -91,6 +91,39 @@ operator==(const std::string& lhs, const char* rhs)
 	return lhs.compare(rhs) == 0;
 }
 
+//------------------------------------------------------------------------------
+/**
+	32 bit FNV-1a hash of string, stable across platforms so it can be stored in files
+*/
+static unsigned
+HashString(const char* str, size_t len)
+{
+	unsigned hash = 2166136261u;
+	size_t i;
+	for (i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+//------------------------------------------------------------------------------
+/**
+	64 bit FNV-1a hash, pass the previous result as hash to continue hashing over several buffers
+*/
+static unsigned long long
+HashString64(const char* str, size_t len, unsigned long long hash = 14695981039346656037ull)
+{
+	size_t i;
+	for (i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)str[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
 //------------------------------------------------------------------------------
 /**
 	Neat macro to make enums act as bit flags, be able to check if bits are set, and convert to integers
@@ -0,0 +1,270 @@
+//------------------------------------------------------------------------------
+//  benchapp.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "effectgenerator.h"
+#include "afxcompiler.h"
+#include "effectfactory.h"
+#include "argh.h"
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <stdio.h>
+
+using namespace AnyFX;
+
+//------------------------------------------------------------------------------
+/**
+	Collects samples of a single benchmark, in seconds
+*/
+struct Samples
+{
+	std::vector<double> values;
+
+	// add sample
+	void Add(double seconds)
+	{
+		this->values.push_back(seconds);
+	}
+
+	// print as one json object per line, so the output can be appended to and diffed
+	void Print(const char* bench, const std::string& effect, unsigned opsPerSample = 1) const
+	{
+		if (this->values.empty()) return;
+		double min = this->values[0], max = this->values[0], sum = 0;
+		for (double v : this->values)
+		{
+			if (v < min) min = v;
+			if (v > max) max = v;
+			sum += v;
+		}
+		double mean = sum / this->values.size();
+		fprintf(stdout, "{\"bench\":\"%s\",\"effect\":\"%s\",\"samples\":%u,\"ops\":%u,\"min_ms\":%.4f,\"mean_ms\":%.4f,\"max_ms\":%.4f}\n",
+			bench, effect.c_str(), (unsigned)this->values.size(), opsPerSample, min * 1000.0, mean * 1000.0, max * 1000.0);
+		fflush(stdout);
+	}
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static double
+Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+/**
+	Compiles effect the same way anyfxcompiler does, without debug output
+*/
+static bool
+Compile(const std::string& src, const std::string& dst, AnyFXCompileTimings& timings)
+{
+	std::filesystem::path sp(src);
+	std::vector<std::string> defines;
+	defines.push_back("-D GLSL");
+	defines.push_back("-I" + sp.parent_path().string() + "/");
+
+	std::vector<std::string> flags;
+	flags.push_back("/NOSUB");
+	flags.push_back("/GBLOCK");
+	flags.push_back("/DEFAULTSET 0");
+
+	AnyFXErrorBlob* errors = NULL;
+	bool res = AnyFXCompile(src, dst, dst + ".h", "spv10", "Khronos", defines, flags, &errors, &timings);
+	if (errors)
+	{
+		if (!res) fprintf(stderr, "%s\n", errors->buffer);
+		delete errors;
+	}
+	return res;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+RunBenchmark(const EffectGenerator& gen, const std::string& dir, unsigned iterations)
+{
+	std::string name = gen.GetName();
+	std::string src = gen.Write(dir);
+	if (src.empty())
+	{
+		fprintf(stderr, "[anyfx_bench] error: could not write effect '%s' to '%s'\n", name.c_str(), dir.c_str());
+		return false;
+	}
+	std::string dst = dir + "/" + name + ".fxb";
+
+	// compile
+	Samples preprocess, parse, typeCheck, generate, write, compile;
+	unsigned i;
+	for (i = 0; i < iterations; i++)
+	{
+		AnyFXCompileTimings timings;
+		double start = Now();
+		if (!Compile(src, dst, timings))
+		{
+			fprintf(stderr, "[anyfx_bench] error: failed to compile '%s'\n", src.c_str());
+			return false;
+		}
+		compile.Add(Now() - start);
+		preprocess.Add(timings.preprocess);
+		parse.Add(timings.parse);
+		typeCheck.Add(timings.typeCheck);
+		generate.Add(timings.generate);
+		write.Add(timings.write);
+	}
+	compile.Print("compile.total", name);
+	preprocess.Print("compile.preprocess", name);
+	parse.Print("compile.parse", name);
+	typeCheck.Print("compile.typecheck", name);
+	generate.Print("compile.generate", name);
+	write.Print("compile.write", name);
+
+	// load from file, goes through the stream loader like an application would
+	Samples loadFile;
+	for (i = 0; i < iterations; i++)
+	{
+		double start = Now();
+		ShaderEffect* effect = EffectFactory::Instance()->CreateShaderEffectFromFile(dst);
+		loadFile.Add(Now() - start);
+		if (effect == NULL)
+		{
+			fprintf(stderr, "[anyfx_bench] error: failed to load '%s'\n", dst.c_str());
+			return false;
+		}
+		delete effect;
+	}
+	loadFile.Print("load.file", name);
+
+	// load from memory, excludes file io
+	std::ifstream file(dst, std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Samples loadMemory;
+	for (i = 0; i < iterations; i++)
+	{
+		double start = Now();
+		ShaderEffect* effect = EffectFactory::Instance()->CreateShaderEffectFromMemory(data.data(), data.size());
+		loadMemory.Add(Now() - start);
+		if (effect == NULL)
+		{
+			fprintf(stderr, "[anyfx_bench] error: failed to load '%s' from memory\n", dst.c_str());
+			return false;
+		}
+		delete effect;
+	}
+	loadMemory.Print("load.memory", name);
+
+	// name lookups, each sample looks up every name once
+	ShaderEffect* effect = EffectFactory::Instance()->CreateShaderEffectFromMemory(data.data(), data.size());
+	if (effect == NULL) return false;
+	std::vector<std::string> programs = gen.GetProgramNames();
+	std::vector<std::string> varblocks = gen.GetVarblockNames();
+	std::vector<std::string> variables = gen.GetVariableNames();
+
+	// the getters assert on unknown names, so only names the effect has are timed
+	size_t generated = programs.size() + varblocks.size() + variables.size();
+	programs.erase(std::remove_if(programs.begin(), programs.end(), [effect](const std::string& n) { return !effect->HasProgram(n); }), programs.end());
+	varblocks.erase(std::remove_if(varblocks.begin(), varblocks.end(), [effect](const std::string& n) { return !effect->HasVarblock(n); }), varblocks.end());
+	variables.erase(std::remove_if(variables.begin(), variables.end(), [effect](const std::string& n) { return !effect->HasVariable(n); }), variables.end());
+	size_t misses = generated - (programs.size() + varblocks.size() + variables.size());
+
+	Samples lookupProgram, lookupVarblock, lookupVariable;
+	volatile unsigned found = 0;		// keeps the lookups from being optimized away
+	for (i = 0; i < iterations; i++)
+	{
+		double start = Now();
+		for (const std::string& n : programs) found += effect->GetProgram(n) != NULL;
+		lookupProgram.Add(Now() - start);
+
+		start = Now();
+		for (const std::string& n : varblocks) found += effect->GetVarblock(n) != NULL;
+		lookupVarblock.Add(Now() - start);
+
+		start = Now();
+		for (const std::string& n : variables) found += effect->GetVariable(n) != NULL;
+		lookupVariable.Add(Now() - start);
+	}
+	delete effect;
+	lookupProgram.Print("lookup.program", name, (unsigned)programs.size());
+	lookupVarblock.Print("lookup.varblock", name, (unsigned)varblocks.size());
+	lookupVariable.Print("lookup.variable", name, (unsigned)variables.size());
+
+	// unused objects may be stripped by the compiler, so a miss is only worth a warning
+	if (misses > 0) fprintf(stderr, "[anyfx_bench] warning: %u names in '%s' were not found and not timed\n", (unsigned)misses, name.c_str());
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Usage: anyfx_bench -o <workdir> [-n <iterations>] [-p <programs> -f <functions> -b <varblocks> -v <variables> -d <include depth>]
+
+	Without any sizes a fixed set of small, medium and large effects is measured.
+	Results are written to standard output as one JSON object per line.
+*/
+int __cdecl
+main(int argc, const char** argv)
+{
+	argh::parser args;
+	args.add_params({ "-o", "-n", "-p", "-f", "-b", "-v", "-d" });
+	args.parse(argv);
+
+	std::string dir;
+	if (!(args("o") >> dir))
+	{
+		fprintf(stderr, "[anyfx_bench] error: no working directory specified\n");
+		return 1;
+	}
+	std::filesystem::create_directories(dir);
+
+	unsigned iterations = 5;
+	args("n") >> iterations;
+	if (iterations == 0) iterations = 1;
+
+	std::vector<EffectGenerator> generators;
+	unsigned value;
+	if (args("p") || args("f") || args("b") || args("v") || args("d"))
+	{
+		EffectGenerator gen;
+		if (args("p") >> value) gen.SetNumPrograms(value);
+		if (args("f") >> value) gen.SetNumFunctions(value);
+		if (args("b") >> value) gen.SetNumVarblocks(value);
+		if (args("v") >> value) gen.SetNumVariablesPerBlock(value);
+		if (args("d") >> value) gen.SetIncludeDepth(value);
+		generators.push_back(gen);
+	}
+	else
+	{
+		// programs, functions, varblocks, variables per block, include depth
+		static const unsigned sizes[][5] =
+		{
+			{ 1, 4, 1, 4, 0 },
+			{ 8, 32, 4, 16, 2 },
+			{ 64, 256, 16, 32, 8 }
+		};
+		for (const auto& size : sizes)
+		{
+			EffectGenerator gen;
+			gen.SetNumPrograms(size[0]);
+			gen.SetNumFunctions(size[1]);
+			gen.SetNumVarblocks(size[2]);
+			gen.SetNumVariablesPerBlock(size[3]);
+			gen.SetIncludeDepth(size[4]);
+			generators.push_back(gen);
+		}
+	}
+
+	bool success = true;
+	AnyFXBeginCompile();
+	for (const EffectGenerator& gen : generators)
+	{
+		success &= RunBenchmark(gen, dir, iterations);
+	}
+	AnyFXEndCompile();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+//------------------------------------------------------------------------------
+//  effectgenerator.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "effectgenerator.h"
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+/**
+*/
+EffectGenerator::EffectGenerator() :
+	numPrograms(8),
+	numFunctions(16),
+	numVarblocks(4),
+	numVariablesPerBlock(8),
+	includeDepth(2)
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+EffectGenerator::~EffectGenerator()
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+EffectGenerator::GetName() const
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "bench_p%u_f%u_b%ux%u_d%u", this->numPrograms, this->numFunctions, this->numVarblocks, this->numVariablesPerBlock, this->includeDepth);
+	return buf;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::vector<std::string>
+EffectGenerator::GetProgramNames() const
+{
+	std::vector<std::string> names;
+	char buf[64];
+	unsigned i;
+	for (i = 0; i < this->numPrograms; i++)
+	{
+		snprintf(buf, sizeof(buf), "Program%u", i);
+		names.push_back(buf);
+	}
+	return names;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::vector<std::string>
+EffectGenerator::GetVarblockNames() const
+{
+	std::vector<std::string> names;
+	char buf[64];
+	unsigned i;
+	for (i = 0; i < this->numVarblocks; i++)
+	{
+		snprintf(buf, sizeof(buf), "Block%u", i);
+		names.push_back(buf);
+	}
+	return names;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::vector<std::string>
+EffectGenerator::GetVariableNames() const
+{
+	std::vector<std::string> names;
+	char buf[64];
+	unsigned i, j;
+	for (i = 0; i < this->numVarblocks; i++)
+	{
+		for (j = 0; j < this->numVariablesPerBlock; j++)
+		{
+			snprintf(buf, sizeof(buf), "Block%u_Value%u", i, j);
+			names.push_back(buf);
+		}
+	}
+	return names;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Declarations are split in contiguous ranges over the effect and its includes, depth 0 being the effect itself.
+	Lower indices go deeper, and since the deepest include ends up first in the preprocessed code, a declaration
+	can always refer to those with a lower index.
+*/
+bool
+EffectGenerator::BelongsTo(unsigned index, unsigned count, unsigned depth) const
+{
+	return this->includeDepth - (index * (this->includeDepth + 1)) / count == depth;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectGenerator::WriteDeclarations(std::string& out, unsigned depth) const
+{
+	char buf[256];
+	unsigned i, j;
+	for (i = 0; i < this->numVarblocks; i++)
+	{
+		if (!this->BelongsTo(i, this->numVarblocks, depth)) continue;
+		snprintf(buf, sizeof(buf), "varblock Block%u\n{\n", i);
+		out.append(buf);
+		for (j = 0; j < this->numVariablesPerBlock; j++)
+		{
+			snprintf(buf, sizeof(buf), "\tvec4 Block%u_Value%u;\n", i, j);
+			out.append(buf);
+		}
+		out.append("};\n\n");
+	}
+
+	// helpers only call helpers with a lower index, which are always declared before
+	for (i = 0; i < this->numFunctions; i++)
+	{
+		if (!this->BelongsTo(i, this->numFunctions, depth)) continue;
+		snprintf(buf, sizeof(buf), "vec4\nHelper%u(vec4 v)\n{\n\tvec4 r = v * %u.0f + vec4(0.5f);\n", i, i + 1);
+		out.append(buf);
+		if (i > 0)
+		{
+			snprintf(buf, sizeof(buf), "\tr = r + Helper%u(v * 0.5f);\n", (i - 1) / 2);
+			out.append(buf);
+		}
+		out.append("\treturn normalize(r) * length(v);\n}\n\n");
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+EffectGenerator::Write(const std::string& dir) const
+{
+	std::string name = this->GetName();
+	char buf[512];
+	unsigned i, j;
+
+	// deepest include first, each one includes the next deeper one
+	unsigned depth;
+	for (depth = this->includeDepth; depth > 0; depth--)
+	{
+		std::string out;
+		snprintf(buf, sizeof(buf), "#ifndef %s_INC%u\n#define %s_INC%u\n\n", name.c_str(), depth, name.c_str(), depth);
+		out.append(buf);
+		if (depth < this->includeDepth)
+		{
+			snprintf(buf, sizeof(buf), "#include \"%s_%u.fxh\"\n\n", name.c_str(), depth + 1);
+			out.append(buf);
+		}
+		this->WriteDeclarations(out, depth);
+		out.append("#endif\n");
+
+		snprintf(buf, sizeof(buf), "%s/%s_%u.fxh", dir.c_str(), name.c_str(), depth);
+		FILE* file = fopen(buf, "wb");
+		if (file == NULL) return "";
+		fwrite(out.c_str(), 1, out.length(), file);
+		fclose(file);
+	}
+
+	std::string out;
+	if (this->includeDepth > 0)
+	{
+		snprintf(buf, sizeof(buf), "#include \"%s_1.fxh\"\n\n", name.c_str());
+		out.append(buf);
+	}
+	this->WriteDeclarations(out, 0);
+	out.append("state BenchState\n{\n\tDepthEnabled = true;\n\tCullMode = Back;\n};\n\n");
+
+	for (i = 0; i < this->numPrograms; i++)
+	{
+		// vertex shader reads every block, so every block is live in every program
+		snprintf(buf, sizeof(buf), "shader\nvoid\nvs%u(in vec3 position, in vec2 uv, out vec2 UV, out vec4 Color)\n{\n\tvec4 c = vec4(position, %u.0f);\n", i, i);
+		out.append(buf);
+		for (j = 0; j < this->numVarblocks && this->numVariablesPerBlock > 0; j++)
+		{
+			snprintf(buf, sizeof(buf), "\tc = c + Block%u_Value%u;\n", j, i % this->numVariablesPerBlock);
+			out.append(buf);
+		}
+		if (this->numFunctions > 0)
+		{
+			snprintf(buf, sizeof(buf), "\tc = Helper%u(c);\n", i % this->numFunctions);
+			out.append(buf);
+		}
+		out.append("\tgl_Position = c;\n\tUV = uv;\n\tColor = c;\n}\n\n");
+
+		snprintf(buf, sizeof(buf), "shader\nvoid\nps%u(in vec2 UV, in vec4 Color, [color0] out vec4 Result)\n{\n\tvec4 c = Color * vec4(UV, %u.0f, 1.0f);\n", i, i);
+		out.append(buf);
+		if (this->numFunctions > 0)
+		{
+			snprintf(buf, sizeof(buf), "\tc = Helper%u(c);\n", (i * 7) % this->numFunctions);
+			out.append(buf);
+		}
+		out.append("\tResult = c;\n}\n\n");
+
+		snprintf(buf, sizeof(buf), "program Program%u\n{\n\tVertexShader = vs%u();\n\tPixelShader = ps%u();\n\tRenderState = BenchState;\n};\n\n", i, i, i);
+		out.append(buf);
+	}
+
+	std::string path = dir + "/" + name + ".fx";
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) return "";
+	fwrite(out.c_str(), 1, out.length(), file);
+	fclose(file);
+	return path;
+}
@@ -0,0 +1,111 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class EffectGenerator
+
+	Writes synthetic effects for benchmarking the compiler and the loader.
+
+	The effect is spread over a chain of includes, each including the next, with
+	the varblocks and helper functions split over the chain. Every program
+	gets its own vertex and pixel shader which read from all varblocks and call
+	a few helper functions, so all parts of the compiler scale with the sizes.
+
+    (C) 2019 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+
+#include <string>
+#include <vector>
+
+class EffectGenerator
+{
+public:
+
+	/// constructor
+	EffectGenerator();
+	/// destructor
+	~EffectGenerator();
+
+	/// set number of programs, each has its own pair of shaders
+	void SetNumPrograms(unsigned num);
+	/// set number of helper functions
+	void SetNumFunctions(unsigned num);
+	/// set number of varblocks
+	void SetNumVarblocks(unsigned num);
+	/// set number of variables per varblock
+	void SetNumVariablesPerBlock(unsigned num);
+	/// set depth of include chain, 0 puts everything in the effect file
+	void SetIncludeDepth(unsigned depth);
+
+	/// get name describing the sizes, usable as a file name
+	std::string GetName() const;
+	/// get names of programs written
+	std::vector<std::string> GetProgramNames() const;
+	/// get names of varblocks written
+	std::vector<std::string> GetVarblockNames() const;
+	/// get names of variables written
+	std::vector<std::string> GetVariableNames() const;
+
+	/// write effect and its includes to directory, returns path to effect or an empty string on failure
+	std::string Write(const std::string& dir) const;
+
+private:
+
+	/// returns true if declaration with index out of count belongs in include file at depth
+	bool BelongsTo(unsigned index, unsigned count, unsigned depth) const;
+	/// writes declarations belonging to depth
+	void WriteDeclarations(std::string& out, unsigned depth) const;
+
+	unsigned numPrograms;
+	unsigned numFunctions;
+	unsigned numVarblocks;
+	unsigned numVariablesPerBlock;
+	unsigned includeDepth;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+EffectGenerator::SetNumPrograms(unsigned num)
+{
+	this->numPrograms = num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+EffectGenerator::SetNumFunctions(unsigned num)
+{
+	this->numFunctions = num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+EffectGenerator::SetNumVarblocks(unsigned num)
+{
+	this->numVarblocks = num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+EffectGenerator::SetNumVariablesPerBlock(unsigned num)
+{
+	this->numVariablesPerBlock = num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+EffectGenerator::SetIncludeDepth(unsigned depth)
+{
+	this->includeDepth = depth;
+}
+
+//------------------------------------------------------------------------------
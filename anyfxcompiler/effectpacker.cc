@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+//  effectpacker.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "effectpacker.h"
+#include "effectpack.h"
+#include "binwriter.h"
+#include "util.h"
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+
+using namespace AnyFX;
+
+//------------------------------------------------------------------------------
+/**
+*/
+EffectPacker::EffectPacker() :
+	alignment(EffectPack::DefaultAlignment)
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+EffectPacker::~EffectPacker()
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectPacker::AddEffect(const std::string& name, const std::string& path)
+{
+	Item item;
+	item.name = name;
+	item.path = path;
+	item.hash = HashString(name.c_str(), name.length());
+	this->items.push_back(item);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EffectPacker::AddDirectory(const std::string& dir)
+{
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(dir))
+	{
+		if (entry.is_regular_file() && entry.path().extension().string() == ".fxb")
+		{
+			// use forward slashes so names are the same on all platforms
+			std::string name = std::filesystem::relative(entry.path(), dir).generic_string();
+			this->AddEffect(name, entry.path().string());
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Entries are sorted on hash so the runtime can binary search the index, then names and payloads follow in the same order.
+*/
+bool
+EffectPacker::Write(const std::string& dst)
+{
+	if (this->alignment == 0 || (this->alignment & (this->alignment - 1)) != 0)
+	{
+		fprintf(stderr, "[anyfxpacker] error: alignment %d is not a power of two\n", this->alignment);
+		return false;
+	}
+
+	std::sort(this->items.begin(), this->items.end(), [](const Item& a, const Item& b)
+	{
+		if (a.hash != b.hash) return a.hash < b.hash;
+		return a.name < b.name;
+	});
+
+	unsigned i;
+	for (i = 1; i < this->items.size(); i++)
+	{
+		if (this->items[i].name == this->items[i - 1].name)
+		{
+			fprintf(stderr, "[anyfxpacker] error: effect '%s' added twice\n", this->items[i].name.c_str());
+			return false;
+		}
+	}
+
+	// read all payloads up front, so we know the sizes when writing the index
+	std::vector<std::vector<char>> payloads(this->items.size());
+	for (i = 0; i < this->items.size(); i++)
+	{
+		std::ifstream file(this->items[i].path, std::ios::binary);
+		if (!file.is_open())
+		{
+			fprintf(stderr, "[anyfxpacker] error: could not open '%s'\n", this->items[i].path.c_str());
+			return false;
+		}
+		payloads[i].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// calculate layout
+	EffectPack::Header header;
+	header.magic = EffectPack::Magic;
+	header.version = EffectPack::Version;
+	header.numEntries = (unsigned)this->items.size();
+	header.alignment = this->alignment;
+	header.stringsOffset = sizeof(EffectPack::Header) + header.numEntries * sizeof(EffectPack::Entry);
+	header.stringsSize = 0;
+
+	std::vector<EffectPack::Entry> entries(this->items.size());
+	for (i = 0; i < this->items.size(); i++)
+	{
+		entries[i].hash = this->items[i].hash;
+		entries[i].nameOffset = header.stringsOffset + header.stringsSize;
+		entries[i].nameLength = (unsigned)this->items[i].name.length();
+		header.stringsSize += entries[i].nameLength;
+	}
+
+	unsigned offset = header.stringsOffset + header.stringsSize;
+	for (i = 0; i < this->items.size(); i++)
+	{
+		offset = (offset + this->alignment - 1) & ~(this->alignment - 1);
+		entries[i].dataOffset = offset;
+		entries[i].dataSize = (unsigned)payloads[i].size();
+		offset += entries[i].dataSize;
+	}
+
+	BinWriter writer;
+	writer.SetPath(dst);
+	if (!writer.Open())
+	{
+		fprintf(stderr, "[anyfxpacker] error: could not open '%s' for writing\n", dst.c_str());
+		return false;
+	}
+
+	writer.WriteBytes((const char*)&header, sizeof(header));
+	if (!entries.empty()) writer.WriteBytes((const char*)entries.data(), (unsigned)(entries.size() * sizeof(EffectPack::Entry)));
+	for (i = 0; i < this->items.size(); i++)
+	{
+		writer.WriteBytes(this->items[i].name.c_str(), (unsigned)this->items[i].name.length());
+	}
+
+	static const char padding[256] = { 0 };
+	for (i = 0; i < this->items.size(); i++)
+	{
+		unsigned pad = entries[i].dataOffset - writer.Tell();
+		while (pad > 0)
+		{
+			unsigned chunk = pad < sizeof(padding) ? pad : sizeof(padding);
+			writer.WriteBytes(padding, chunk);
+			pad -= chunk;
+		}
+		if (!payloads[i].empty()) writer.WriteBytes(payloads[i].data(), (unsigned)payloads[i].size());
+	}
+	writer.Close();
+	return true;
+}
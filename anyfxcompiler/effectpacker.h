@@ -0,0 +1,56 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class EffectPacker
+
+	Packs compiled effects into a single AnyFX::EffectPack archive.
+
+    (C) 2019 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+
+#include <string>
+#include <vector>
+
+class EffectPacker
+{
+public:
+
+	/// constructor
+	EffectPacker();
+	/// destructor
+	~EffectPacker();
+
+	/// set payload alignment in bytes, must be a power of two
+	void SetAlignment(unsigned alignment);
+	/// add single compiled effect, the name is what the runtime looks it up by
+	void AddEffect(const std::string& name, const std::string& path);
+	/// add all .fxb files found under directory, named by their path relative to it
+	void AddDirectory(const std::string& dir);
+
+	/// write pack to file
+	bool Write(const std::string& dst);
+
+private:
+
+	struct Item
+	{
+		std::string name;
+		std::string path;
+		unsigned hash;
+	};
+
+	unsigned alignment;
+	std::vector<Item> items;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+EffectPacker::SetAlignment(unsigned alignment)
+{
+	this->alignment = alignment;
+}
+
+//------------------------------------------------------------------------------
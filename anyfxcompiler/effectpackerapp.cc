@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+//  effectpackerapp.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "effectpacker.h"
+#include "argh.h"
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+/**
+	Usage: anyfxpacker -o <pack> -i <dir> [<dir> ...] [-a <alignment>]
+
+	Packs every .fxb under the input directories, typically the output directory
+	given to anyfxcompiler, so effects are named like 'shaders/foo.fxb'.
+*/
+int __cdecl
+main(int argc, const char** argv)
+{
+	argh::parser args;
+	args.add_params({ "-i", "-o", "-a" });
+	args.parse(argv);
+
+	std::string dst;
+	if (!(args("o") >> dst))
+	{
+		fprintf(stderr, "anyfxpacker error: no output specified\n");
+		return 1;
+	}
+
+	EffectPacker packer;
+	unsigned alignment;
+	if (args("a") >> alignment)
+	{
+		packer.SetAlignment(alignment);
+	}
+
+	bool hasInput = false;
+	std::string buffer;
+	if (args("i") >> buffer)
+	{
+		packer.AddDirectory(buffer);
+		hasInput = true;
+	}
+
+	// any positional arguments are additional input directories, the first one is the executable
+	const std::vector<std::string>& allargs = args.args();
+	for (size_t i = 1; i < allargs.size(); i++)
+	{
+		packer.AddDirectory(allargs[i]);
+		hasInput = true;
+	}
+
+	if (!hasInput)
+	{
+		fprintf(stderr, "anyfxpacker error: no input directory specified\n");
+		return 1;
+	}
+
+	return packer.Write(dst) ? 0 : 1;
+}
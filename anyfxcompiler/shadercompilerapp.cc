@@ -4,6 +4,7 @@
 //------------------------------------------------------------------------------
 
 #include "shadercompilerapp.h"
+#include "shadercompilerserver.h"
 #include "argh.h"
 #include <filesystem>
 
@@ -15,10 +16,12 @@ bool
 ShaderCompilerApp::ParseCmdLineArgs(const char ** argv)
 {
 	argh::parser args;
-	args.add_params({ "-i", "-o", "-h" });
+	args.add_params({ "-i", "-o", "-h", "-c", "-p", "-s" });
 	args.parse(argv);
 
 	this->shaderCompiler.SetDebugFlag(args["debug"]);
+	this->shaderCompiler.SetCompressFlag(args["compress"]);
+	this->shaderCompiler.SetLexCheckFlag(args["lexcheck"]);
 	std::string buffer;	
 	if (!(args("o") >> buffer))
 	{
@@ -38,6 +41,19 @@ ShaderCompilerApp::ParseCmdLineArgs(const char ** argv)
 	{
 		this->shaderCompiler.SetHeaderDir(buffer);
 	}
+	if (args("c") >> buffer)
+	{
+		this->shaderCompiler.SetCacheDir(buffer);
+	}
+	unsigned pushConstantBudget;
+	if (args("p") >> pushConstantBudget)
+	{
+		this->shaderCompiler.SetPushConstantBudget(pushConstantBudget);
+	}
+	if (args("s") >> buffer)
+	{
+		this->shaderCompiler.SetProgramSelection(buffer);
+	}
 
     // find include dir args
 	
@@ -52,6 +68,9 @@ ShaderCompilerApp::ParseCmdLineArgs(const char ** argv)
     }
         
 	this->mode = args["M"];
+
+	// in server mode the input may also be a directory of effects
+	this->server = args["server"];
             
     return true;
 }
@@ -66,7 +85,13 @@ ShaderCompilerApp::Run()
 {   
 	bool success = false;
             
-    if(this->mode)
+    if(this->server)
+    {
+        ShaderCompilerServer server(this->shaderCompiler);
+        server.AddSource(this->src);
+        success = server.Run();
+    }
+    else if(this->mode)
     {
         success = this->shaderCompiler.CreateDependencies(this->src);
     }
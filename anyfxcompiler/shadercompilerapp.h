@@ -23,6 +23,7 @@ public:
     SingleShaderCompiler shaderCompiler;
     std::string src;
 	bool mode;
+	bool server;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,340 @@
+//------------------------------------------------------------------------------
+//  shadercompilerserver.cc
+//  (C) 2019 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "shadercompilerserver.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <stdio.h>
+#if __WIN32__
+#include <windows.h>
+#elif __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------
+/**
+*/
+ShaderCompilerServer::ShaderCompilerServer(SingleShaderCompiler& compiler) :
+	compiler(compiler),
+	pollInterval(250),
+	scanInterval(5000),
+	scanPending(false),
+	fallback(false),
+#if __linux__
+	notifyDescriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+#endif
+	queue(std::make_shared<CommandQueue>())
+{
+	// empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ShaderCompilerServer::~ShaderCompilerServer()
+{
+#if __WIN32__
+	for (void* notification : this->notifications) FindCloseChangeNotification(notification);
+#elif __linux__
+	if (this->notifyDescriptor != -1) close(this->notifyDescriptor);
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderCompilerServer::AddSource(const std::string& path)
+{
+	if (std::filesystem::is_directory(path))
+	{
+		std::string dir = Normalize(path);
+		this->directories.push_back(dir);
+		this->Watch(dir);
+	}
+	else
+	{
+		this->Track(Normalize(path));
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderCompilerServer::Run()
+{
+	// initialize once, every compile from now on reuses it
+	this->compiler.BeginSession();
+	this->Scan();
+	fprintf(stdout, "ready\n");
+	fflush(stdout);
+
+	// blocking reads can't be interrupted, so the reader only shares the queue with us
+	std::thread(ReadCommands, this->queue).detach();
+
+	bool running = true;
+	while (running)
+	{
+		std::deque<std::string> pending;
+		bool closed;
+		{
+			std::unique_lock<std::mutex> guard(this->queue->lock);
+			this->queue->signal.wait_for(guard, std::chrono::milliseconds(this->pollInterval), [this]()
+			{
+				return !this->queue->commands.empty() || this->queue->closed;
+			});
+			pending.swap(this->queue->commands);
+			closed = this->queue->closed;
+		}
+
+		// requests go first, they have someone waiting on them
+		while (!pending.empty() && running)
+		{
+			running = this->HandleCommand(pending.front());
+			pending.pop_front();
+		}
+		if (closed) running = false;
+
+		if (running)
+		{
+			if (this->NeedsScan()) this->Scan();
+			this->Poll();
+		}
+	}
+
+	this->compiler.EndSession();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderCompilerServer::ReadCommands(std::shared_ptr<CommandQueue> queue)
+{
+	std::string line;
+	while (std::getline(std::cin, line))
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty()) continue;
+		std::lock_guard<std::mutex> guard(queue->lock);
+		queue->commands.push_back(line);
+		queue->signal.notify_one();
+	}
+
+	std::lock_guard<std::mutex> guard(queue->lock);
+	queue->closed = true;
+	queue->signal.notify_one();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderCompilerServer::HandleCommand(const std::string& command)
+{
+	size_t space = command.find(' ');
+	std::string name = command.substr(0, space);
+	std::string arg = space != std::string::npos ? command.substr(space + 1) : "";
+
+	if (name == "quit")
+	{
+		return false;
+	}
+	else if (name == "compile" && !arg.empty())
+	{
+		std::string effect = Normalize(arg);
+		bool res = this->Compile(effect);
+		fprintf(stdout, "%s %s\n", res ? "ok" : "failed", effect.c_str());
+	}
+	else if (name == "watch" && !arg.empty())
+	{
+		this->AddSource(arg);
+		this->Scan();
+	}
+	else
+	{
+		fprintf(stdout, "error unknown command '%s'\n", command.c_str());
+	}
+	fflush(stdout);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderCompilerServer::Scan()
+{
+	this->lastScan = std::chrono::steady_clock::now();
+	this->scanPending = false;
+	for (const std::string& dir : this->directories)
+	{
+		std::error_code err;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, err))
+		{
+#if __linux__
+			// inotify doesn't watch subdirectories, so every one we come across needs its own watch
+			if (entry.is_directory()) this->Watch(entry.path().string());
+#endif
+			if (entry.is_regular_file() && entry.path().extension().string() == ".fx")
+			{
+				std::string effect = Normalize(entry.path().string());
+				if (this->effects.find(effect) == this->effects.end()) this->Track(effect);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Only additions matter here, changes to tracked files are found by Poll, which checks just the files effects depend on.
+*/
+void
+ShaderCompilerServer::Watch(const std::string& dir)
+{
+#if __WIN32__
+	HANDLE notification = FindFirstChangeNotificationA(dir.c_str(), TRUE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+	if (notification != INVALID_HANDLE_VALUE)
+	{
+		this->notifications.push_back(notification);
+		return;
+	}
+#elif __linux__
+	// watching the same directory again only updates the existing watch
+	if (this->notifyDescriptor != -1 && inotify_add_watch(this->notifyDescriptor, dir.c_str(), IN_CREATE | IN_MOVED_TO) != -1) return;
+#endif
+	this->fallback = true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderCompilerServer::NeedsScan()
+{
+	// drain every notification, so the next call only sees what happened after this scan
+#if __WIN32__
+	for (void* notification : this->notifications)
+	{
+		if (WaitForSingleObject(notification, 0) == WAIT_OBJECT_0)
+		{
+			this->scanPending = true;
+			FindNextChangeNotification(notification);
+		}
+	}
+#elif __linux__
+	if (this->notifyDescriptor != -1)
+	{
+		char events[4096];
+		while (read(this->notifyDescriptor, events, sizeof(events)) > 0)
+		{
+			this->scanPending = true;
+		}
+	}
+#endif
+	if (this->scanPending) return true;
+	return this->fallback && std::chrono::steady_clock::now() - this->lastScan >= std::chrono::milliseconds(this->scanInterval);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderCompilerServer::Track(const std::string& effect)
+{
+	this->effects.insert(effect);
+
+	// the effect is always part of its own dependencies, so changing it triggers a compile
+	std::vector<std::string> deps = this->compiler.GetDependencies(effect);
+	std::vector<std::string>& tracked = this->dependencies[effect];
+	tracked.clear();
+	tracked.push_back(effect);
+	for (const std::string& dep : deps)
+	{
+		std::string path = Normalize(dep);
+		if (path != effect) tracked.push_back(path);
+	}
+
+	for (const std::string& path : tracked)
+	{
+		if (this->writeTimes.find(path) == this->writeTimes.end()) this->writeTimes[path] = GetWriteTime(path);
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ShaderCompilerServer::Compile(const std::string& effect)
+{
+	bool res = this->compiler.CompileShader(effect);
+	this->Track(effect);
+	return res;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderCompilerServer::Poll()
+{
+	std::set<std::string> changed;
+	for (auto& it : this->writeTimes)
+	{
+		std::filesystem::file_time_type time = GetWriteTime(it.first);
+		if (time != it.second)
+		{
+			it.second = time;
+			changed.insert(it.first);
+		}
+	}
+	if (changed.empty()) return;
+
+	// collect first, compiling refreshes the dependencies we iterate
+	std::vector<std::string> affected;
+	for (const auto& it : this->dependencies)
+	{
+		for (const std::string& dep : it.second)
+		{
+			if (changed.find(dep) != changed.end())
+			{
+				affected.push_back(it.first);
+				break;
+			}
+		}
+	}
+
+	for (const std::string& effect : affected)
+	{
+		bool res = this->Compile(effect);
+		fprintf(stdout, "%s %s\n", res ? "ok" : "failed", effect.c_str());
+	}
+	fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::filesystem::file_time_type
+ShaderCompilerServer::GetWriteTime(const std::string& path)
+{
+	std::error_code err;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(path, err);
+	return err ? std::filesystem::file_time_type::min() : time;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+ShaderCompilerServer::Normalize(const std::string& path)
+{
+	std::error_code err;
+	std::filesystem::path res = std::filesystem::weakly_canonical(path, err);
+	return err ? std::filesystem::path(path).generic_string() : res.generic_string();
+}
@@ -0,0 +1,132 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class ShaderCompilerServer
+
+	Long running compile server, keeps glslang, the ANTLR parser and the
+	file system caches warm between compiles.
+
+	Every effect found in the watched sources is tracked together with its
+	includes, as reported by AnyFXGenerateDependencies. When any of those files
+	change, the effects depending on them are recompiled. Only those files are
+	checked on every poll, watched directories are only walked again when the
+	system tells us something was added to them, or every scan interval where
+	it can't.
+
+	Clients talk to the server over its standard input and output, one command
+	per line:
+
+		compile <file>		compile effect now, and watch it from then on
+		watch <file|dir>	watch effect or all effects in directory
+		quit				stop the server
+
+	Each compile is answered by 'ok <file>' or 'failed <file>' on standard
+	output, compiler messages go to standard error as usual. 'ready' is
+	printed once the initial scan is done.
+
+    (C) 2019 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+
+#include "singleshadercompiler.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+class ShaderCompilerServer
+{
+public:
+
+	/// constructor
+	ShaderCompilerServer(SingleShaderCompiler& compiler);
+	/// destructor
+	~ShaderCompilerServer();
+
+	/// set how often watched files are checked for changes, in milliseconds
+	void SetPollInterval(unsigned ms);
+	/// set how often watched directories are walked for new effects when the system can't notify us, in milliseconds
+	void SetScanInterval(unsigned ms);
+	/// add effect file or directory of effects to watch
+	void AddSource(const std::string& path);
+
+	/// run until asked to quit or the input is closed
+	bool Run();
+
+private:
+
+	struct CommandQueue
+	{
+		std::mutex lock;
+		std::condition_variable signal;
+		std::deque<std::string> commands;
+		bool closed = false;
+	};
+
+	/// read commands from standard input, runs on its own thread which may outlive the server
+	static void ReadCommands(std::shared_ptr<CommandQueue> queue);
+	/// handle single command, returns false when asked to quit
+	bool HandleCommand(const std::string& command);
+
+	/// find new effects in watched directories
+	void Scan();
+	/// get notified when files are added to directory, falls back to scanning every scan interval if that fails
+	void Watch(const std::string& dir);
+	/// check if watched directories may have new effects since the last scan
+	bool NeedsScan();
+	/// start tracking effect
+	void Track(const std::string& effect);
+	/// compile effect and refresh its dependencies, since the change may have added or removed includes
+	bool Compile(const std::string& effect);
+	/// recompile all effects whose sources changed since last poll
+	void Poll();
+
+	/// get time file was last written, or the minimum time if it doesn't exist
+	static std::filesystem::file_time_type GetWriteTime(const std::string& path);
+	/// make path comparable to the ones the dependency generator gives us
+	static std::string Normalize(const std::string& path);
+
+	SingleShaderCompiler& compiler;
+	unsigned pollInterval;
+	unsigned scanInterval;
+	std::chrono::steady_clock::time_point lastScan;
+	bool scanPending;
+	bool fallback;
+#if __WIN32__
+	std::vector<void*> notifications;
+#elif __linux__
+	int notifyDescriptor;
+#endif
+	std::vector<std::string> directories;
+	std::set<std::string> effects;
+	std::map<std::string, std::vector<std::string>> dependencies;
+	std::map<std::string, std::filesystem::file_time_type> writeTimes;
+
+	std::shared_ptr<CommandQueue> queue;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ShaderCompilerServer::SetPollInterval(unsigned ms)
+{
+	this->pollInterval = ms;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ShaderCompilerServer::SetScanInterval(unsigned ms)
+{
+	this->scanInterval = ms;
+}
+
+//------------------------------------------------------------------------------
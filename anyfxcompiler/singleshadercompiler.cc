@@ -14,6 +14,10 @@ SingleShaderCompiler::SingleShaderCompiler() :
 	platform("win32"),	
 	debug(false),
 	quiet(false),
+	compress(false),
+	lexCheck(false),
+	pushConstantBudget(0),
+	inSession(false),
 	defaultSet(3)
 {
 	// empty
@@ -69,15 +73,15 @@ bool
 SingleShaderCompiler::CompileSPIRV(const std::string& src)
 {
 
-	// start AnyFX compilation
-	AnyFXBeginCompile();
+	// start AnyFX compilation, unless a session keeps it running
+	if (!this->inSession) AnyFXBeginCompile();
 
 	std::filesystem::path sp(src);
 	std::string file = sp.stem().string();
     std::string folder = sp.parent_path().string();
 
-    // format destination
-    std::string destFile = this->dstDir + "/shaders/" + file + ".fxb";
+    // format destination, a partial effect must not replace the full one, it is only meant to be merged into it
+    std::string destFile = this->dstDir + "/shaders/" + file + (this->programSelection.empty() ? ".fxb" : ".partial.fxb");
 	std::string destHeader = this->headerDir + "/" + file + ".h";
 	std::filesystem::path dest(destFile);
 
@@ -108,6 +112,37 @@ SingleShaderCompiler::CompileSPIRV(const std::string& src)
 	snprintf(buffer, 25, "/DEFAULTSET %d", this->defaultSet);
     flags.push_back(std::string(buffer));	// since we want the most frequently switched set as high as possible, we send the default set to 8, must match the NEBULAT_DEFAULT_GROUP in std.fxh and DEFAULT_GROUP in coregraphics/config.h
 
+    // canonicalize and compress shader binaries, they are decompressed when first used
+    if (this->compress)
+    {
+        flags.push_back("/COMPRESS");
+    }
+
+    // report where the scanner and the generated lexer disagree
+    if (this->lexCheck)
+    {
+        flags.push_back("/LEXCHECK");
+    }
+
+    // reuse SPIR-V for programs whose generated code hasn't changed since the last run
+    if (!this->cacheDir.empty())
+    {
+        std::filesystem::create_directories(this->cacheDir);
+        flags.push_back("/SPVCACHE " + this->cacheDir);
+    }
+
+    // move small varblocks to push constants, saving a descriptor binding and a buffer write per draw
+    if (this->pushConstantBudget > 0)
+    {
+        flags.push_back("/PUSHBUDGET " + std::to_string(this->pushConstantBudget));
+    }
+
+    // only generate and link the selected programs and the shaders they use
+    if (!this->programSelection.empty())
+    {
+        flags.push_back("/PROGRAMS " + this->programSelection);
+    }
+
     // if using debug, output raw shader code
     if (!this->debug)
     {
@@ -136,6 +171,7 @@ SingleShaderCompiler::CompileSPIRV(const std::string& src)
             delete errors;
             errors = 0;
         }
+        if (!this->inSession) AnyFXEndCompile();
         return false;
     }
     else if (errors)
@@ -145,7 +181,7 @@ SingleShaderCompiler::CompileSPIRV(const std::string& src)
         errors = 0;
     }
     // stop AnyFX compilation
-    AnyFXEndCompile();
+    if (!this->inSession) AnyFXEndCompile();
     return true;
 }
 
@@ -156,10 +192,8 @@ SingleShaderCompiler::CompileSPIRV(const std::string& src)
 bool
 SingleShaderCompiler::CreateDependencies(const std::string& src)
 {
-
 	std::filesystem::path sp(src);
 	std::string file = sp.stem().string();
-	std::string folder = sp.parent_path().string();
 
 	// format destination
 	std::string destFile = this->dstDir + "/shaders/" + file + ".fxb";
@@ -167,9 +201,33 @@ SingleShaderCompiler::CreateDependencies(const std::string& src)
 	// compile
 	fprintf(stderr, "[anyfxcompiler] \n Analyzing:\n   %s -> %s", src.c_str(), destFile.c_str());	
 
+	std::filesystem::path destDir(this->dstDir);
+	std::filesystem::create_directories(destDir);
+#pragma warning (disable:4996)
+	FILE * output = fopen(destFile.c_str(), "w");
+	if(output)
+	{
+		std::vector<std::string> deps = this->GetDependencies(src);
+        for(auto str : deps)
+        {
+			fprintf(output, "%s;", str.c_str());
+        }
+		fclose(output);
+	}
+    
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::vector<std::string>
+SingleShaderCompiler::GetDependencies(const std::string& src)
+{
+	std::filesystem::path sp(src);
+	std::string folder = sp.parent_path().string();
 
 	std::vector<std::string> defines;
-	std::vector<std::string> flags;
 	std::string define = "-D GLSL";
 	defines.push_back(define);
 
@@ -183,19 +241,31 @@ SingleShaderCompiler::CreateDependencies(const std::string& src)
 		defines.push_back(define);
 	}
 
-	std::filesystem::path destDir(this->dstDir);
-	std::filesystem::create_directories(destDir);
-#pragma warning (disable:4996)
-	FILE * output = fopen(destFile.c_str(), "w");
-	if(output)
+	return AnyFXGenerateDependencies(sp.string().c_str(), defines);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SingleShaderCompiler::BeginSession()
+{
+	if (!this->inSession)
 	{
-		std::vector<std::string> deps = AnyFXGenerateDependencies(sp.string().c_str(), defines);
-        for(auto str : deps)
-        {
-			fprintf(output, "%s;", str.c_str());
-        }
-		fclose(output);
+		AnyFXBeginCompile();
+		this->inSession = true;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SingleShaderCompiler::EndSession()
+{
+	if (this->inSession)
+	{
+		AnyFXEndCompile();
+		this->inSession = false;
 	}
-    
-    return true;
 }
@@ -38,12 +38,29 @@ public:
 	void SetAdditionalParams(const std::string& params);
 	/// set quiet flag
 	void SetQuietFlag(bool b);
+	/// set flag to compress shader binaries
+	void SetCompressFlag(bool b);
+	/// set flag to compare the scanner against the generated lexer while compiling
+	void SetLexCheckFlag(bool b);
+	/// set directory where compiled SPIR-V programs are cached between runs, empty disables the cache
+	void SetCacheDir(const std::string& cacheDir);
+	/// set how many bytes of varblocks may be promoted to push constants, 0 disables promotion
+	void SetPushConstantBudget(unsigned bytes);
+	/// compile only programs matching these patterns, separated by ',' and using '*' and '?', to a partial effect next to the full one
+	void SetProgramSelection(const std::string& selection);
 
 	/// compile shader
 	bool CompileShader(const std::string& src);
 
 	/// calculate include dependencies
 	bool CreateDependencies(const std::string& src);
+	/// get include dependencies of shader, the shader itself included
+	std::vector<std::string> GetDependencies(const std::string& src);
+
+	/// keep the compiler initialized until EndSession, so compiles in between don't pay for setting it up
+	void BeginSession();
+	/// end session
+	void EndSession();
 	
 	///
 	void SetDefaultSet(int size);
@@ -58,6 +75,12 @@ private:
 	std::string language;
 	bool quiet;
 	bool debug;
+	bool compress;
+	bool lexCheck;
+	std::string cacheDir;
+	unsigned pushConstantBudget;
+	std::string programSelection;
+	bool inSession;
 	std::string additionalParams;
 	std::vector<std::string> includeDirs;
 }; 
@@ -144,4 +167,49 @@ SingleShaderCompiler::SetQuietFlag(bool b)
 	this->quiet = b;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+SingleShaderCompiler::SetCompressFlag(bool b)
+{
+	this->compress = b;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+SingleShaderCompiler::SetLexCheckFlag(bool b)
+{
+	this->lexCheck = b;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+SingleShaderCompiler::SetCacheDir(const std::string& cacheDir)
+{
+	this->cacheDir = cacheDir;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+SingleShaderCompiler::SetPushConstantBudget(unsigned bytes)
+{
+	this->pushConstantBudget = bytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+SingleShaderCompiler::SetProgramSelection(const std::string& selection)
+{
+	this->programSelection = selection;
+}
+
 //------------------------------------------------------------------------------
\ No newline at end of file